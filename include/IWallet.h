@@ -83,6 +83,8 @@ struct WalletTransaction {
   uint64_t unlockTime;
   std::string extra;
   bool isBase;
+  // taken from extra, NULL_HASH if it has none
+  Crypto::Hash paymentId;
 };
 
 enum class WalletTransferType : uint8_t {
@@ -170,6 +172,9 @@ public:
   virtual WalletTransactionWithTransfers getTransaction(const Crypto::Hash& transactionHash) const = 0;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count) const = 0;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count) const = 0;
+  // Same as getTransactions(), but only the transactions with paymentId and only the blocks that have any
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByPaymentId(const Crypto::Hash& paymentId, const Crypto::Hash& blockHash, size_t count) const = 0;
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByPaymentId(const Crypto::Hash& paymentId, uint32_t blockIndex, size_t count) const = 0;
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t blockIndex, size_t count) const = 0;
   virtual uint32_t getBlockCount() const  = 0;
   virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions() const = 0;
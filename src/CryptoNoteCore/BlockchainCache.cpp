@@ -701,34 +701,44 @@ ExtractOutputKeysResult BlockchainCache::extractKeyOutputKeys(uint64_t amount,
   return extractKeyOutputKeys(amount, getTopBlockIndex(), globalIndexes, publicKeys);
 }
 
-std::vector<uint32_t> BlockchainCache::getRandomOutsByAmount(Amount amount, size_t count, uint32_t blockIndex) const {
-  std::vector<uint32_t> offs;
-  auto it = keyOutputsGlobalIndexes.find(amount);
-  if (it == keyOutputsGlobalIndexes.end()) {
-    return parent != nullptr ? parent->getRandomOutsByAmount(amount, count, blockIndex) : offs;
-  }
-
-  auto& outs = it->second.outputs;
-  auto end = std::find_if(outs.rbegin(), outs.rend(), [&](PackedOutIndex index) {
-               return index.blockIndex <= blockIndex - currency.minedMoneyUnlockWindow();
-             }).base();
-  uint32_t dist = static_cast<uint32_t>(std::distance(outs.begin(), end));
-  dist = std::min(static_cast<uint32_t>(count), dist);
-  ShuffleGenerator<uint32_t, Crypto::random_engine<uint32_t>> generator(dist);
-  while (dist--) {
-    auto offset = generator();
-    auto& outIndex = it->second.outputs[offset];
-    auto transactionIterator = transactions.get<TransactionInBlockTag>().find(
-        boost::make_tuple<uint32_t, uint32_t>(outIndex.blockIndex, outIndex.transactionIndex));
-    if (isTransactionSpendTimeUnlocked(transactionIterator->unlockTime, blockIndex)) {
-      offs.push_back(it->second.startIndex + offset);
+std::vector<std::vector<RandomOutput>> BlockchainCache::getRandomOutsByAmounts(const std::vector<Amount>& amounts, const std::vector<size_t>& counts,
+                                                                               uint32_t blockIndex) const {
+  assert(amounts.size() == counts.size());
+
+  std::vector<std::vector<RandomOutput>> offs(amounts.size());
+  std::vector<size_t> parentCounts(counts);
+  bool needParent = false;
+  for (size_t i = 0; i < amounts.size(); ++i) {
+    auto it = keyOutputsGlobalIndexes.find(amounts[i]);
+    if (it != keyOutputsGlobalIndexes.end()) {
+      auto& outs = it->second.outputs;
+      auto end = std::find_if(outs.rbegin(), outs.rend(), [&](PackedOutIndex index) {
+                   return index.blockIndex <= blockIndex - currency.minedMoneyUnlockWindow();
+                 }).base();
+      uint32_t dist = static_cast<uint32_t>(std::distance(outs.begin(), end));
+      dist = std::min(static_cast<uint32_t>(counts[i]), dist);
+      ShuffleGenerator<uint32_t, Crypto::random_engine<uint32_t>> generator(dist);
+      while (dist--) {
+        auto offset = generator();
+        auto& outIndex = it->second.outputs[offset];
+        auto transactionIterator = transactions.get<TransactionInBlockTag>().find(
+            boost::make_tuple<uint32_t, uint32_t>(outIndex.blockIndex, outIndex.transactionIndex));
+        if (isTransactionSpendTimeUnlocked(transactionIterator->unlockTime, blockIndex)) {
+          assert(transactionIterator->outputs[outIndex.outputIndex].type() == typeid(KeyOutput));
+          offs[i].push_back({it->second.startIndex + offset, boost::get<KeyOutput>(transactionIterator->outputs[outIndex.outputIndex]).key});
+        }
+      }
     }
+
+    parentCounts[i] = counts[i] - offs[i].size();
+    needParent = needParent || parentCounts[i] != 0;
   }
 
-  if (offs.size() < count && parent != nullptr) {
-    auto prevs = parent->getRandomOutsByAmount(amount, count - offs.size(), blockIndex);
-    offs.reserve(prevs.size() + offs.size());
-    std::copy(prevs.begin(), prevs.end(), std::back_inserter(offs));
+  if (needParent && parent != nullptr) {
+    auto prevs = parent->getRandomOutsByAmounts(amounts, parentCounts, blockIndex);
+    for (size_t i = 0; i < amounts.size(); ++i) {
+      std::copy(prevs[i].begin(), prevs[i].end(), std::back_inserter(offs[i]));
+    }
   }
 
   return offs;
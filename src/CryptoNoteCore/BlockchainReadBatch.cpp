@@ -72,11 +72,6 @@ BlockchainReadBatch& BlockchainReadBatch::requestKeyOutputGlobalIndexForAmount(I
   return *this;
 }
 
-BlockchainReadBatch& BlockchainReadBatch::requestRawBlock(uint32_t blockIndex) {
-  state.rawBlocks.emplace(blockIndex, RawBlock());
-  return *this;
-}
-
 BlockchainReadBatch& BlockchainReadBatch::requestLastBlockIndex() {
   state.lastBlockIndex.second = true;
   return *this;
@@ -122,6 +117,11 @@ BlockchainReadBatch& BlockchainReadBatch::requestKeyOutputInfo(IBlockchainCache:
   return *this;
 }
 
+BlockchainReadBatch& BlockchainReadBatch::requestBlockUndoInfo(uint32_t blockIndex) {
+  state.blockUndoInfos.emplace(blockIndex, BlockUndoInfo());
+  return *this;
+}
+
 BlockchainReadResult BlockchainReadBatch::extractResult() {
   assert(resultSubmitted);
   auto st = std::move(state);
@@ -144,13 +144,13 @@ std::vector<std::string> BlockchainReadBatch::getRawKeys() const {
   DB::serializeKeys(rawKeys, DB::BLOCK_HASH_TO_BLOCK_INDEX_PREFIX, state.blockIndexesByBlockHashes);
   DB::serializeKeys(rawKeys, DB::KEY_OUTPUT_AMOUNT_PREFIX, state.keyOutputGlobalIndexesCountForAmounts);
   DB::serializeKeys(rawKeys, DB::KEY_OUTPUT_AMOUNT_PREFIX, state.keyOutputGlobalIndexesForAmounts);
-  DB::serializeKeys(rawKeys, DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, state.rawBlocks);
   DB::serializeKeys(rawKeys, DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, state.closestTimestampBlockIndex);
   DB::serializeKeys(rawKeys, DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX, state.keyOutputAmounts);
   DB::serializeKeys(rawKeys, DB::PAYMENT_ID_TO_TX_HASH_PREFIX, state.transactionCountsByPaymentIds);
   DB::serializeKeys(rawKeys, DB::PAYMENT_ID_TO_TX_HASH_PREFIX, state.transactionHashesByPaymentIds);
   DB::serializeKeys(rawKeys, DB::TIMESTAMP_TO_BLOCKHASHES_PREFIX, state.blockHashesByTimestamp);
   DB::serializeKeys(rawKeys, DB::KEY_OUTPUT_KEY_PREFIX, state.keyOutputKeys);
+  DB::serializeKeys(rawKeys, DB::BLOCK_INDEX_TO_UNDO_INFO_PREFIX, state.blockUndoInfos);
 
   if (state.lastBlockIndex.second) {
     rawKeys.emplace_back(DB::serializeKey(DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, DB::LAST_BLOCK_INDEX_KEY));
@@ -208,10 +208,6 @@ const std::unordered_map<std::pair<IBlockchainCache::Amount, uint32_t>, PackedOu
   return state.keyOutputGlobalIndexesForAmounts;
 }
 
-const std::unordered_map<uint32_t, RawBlock>& BlockchainReadResult::getRawBlocks() const {
-  return state.rawBlocks;
-}
-
 const std::pair<uint32_t, bool>& BlockchainReadResult::getLastBlockIndex() const {
   return state.lastBlockIndex;
 }
@@ -248,6 +244,10 @@ const KeyOutputKeyResult& BlockchainReadResult::getKeyOutputInfo() const {
   return state.keyOutputKeys;
 }
 
+const std::unordered_map<uint32_t, BlockUndoInfo>& BlockchainReadResult::getBlockUndoInfos() const {
+  return state.blockUndoInfos;
+}
+
 void BlockchainReadBatch::submitRawResult(const std::vector<std::string>& values, const std::vector<bool>& resultStates) {
   assert(state.size() == values.size());
   assert(values.size() == resultStates.size());
@@ -262,13 +262,13 @@ void BlockchainReadBatch::submitRawResult(const std::vector<std::string>& values
   DB::deserializeValues(state.blockIndexesByBlockHashes, iter, DB::BLOCK_HASH_TO_BLOCK_INDEX_PREFIX);
   DB::deserializeValues(state.keyOutputGlobalIndexesCountForAmounts, iter, DB::KEY_OUTPUT_AMOUNT_PREFIX);
   DB::deserializeValues(state.keyOutputGlobalIndexesForAmounts, iter, DB::KEY_OUTPUT_AMOUNT_PREFIX);
-  DB::deserializeValues(state.rawBlocks, iter, DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX);
   DB::deserializeValues(state.closestTimestampBlockIndex, iter, DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX);
   DB::deserializeValues(state.keyOutputAmounts, iter, DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX);
   DB::deserializeValues(state.transactionCountsByPaymentIds, iter, DB::PAYMENT_ID_TO_TX_HASH_PREFIX);
   DB::deserializeValues(state.transactionHashesByPaymentIds, iter, DB::PAYMENT_ID_TO_TX_HASH_PREFIX);
   DB::deserializeValues(state.blockHashesByTimestamp, iter, DB::TIMESTAMP_TO_BLOCKHASHES_PREFIX);
   DB::deserializeValues(state.keyOutputKeys, iter, DB::KEY_OUTPUT_KEY_PREFIX);
+  DB::deserializeValues(state.blockUndoInfos, iter, DB::BLOCK_INDEX_TO_UNDO_INFO_PREFIX);
 
   DB::deserializeValue(state.lastBlockIndex, iter, DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX);
   DB::deserializeValue(state.keyOutputAmountsCount, iter, DB::KEY_OUTPUT_AMOUNTS_COUNT_PREFIX);
@@ -288,9 +288,9 @@ cachedBlocks(std::move(state.cachedBlocks)),
 blockIndexesByBlockHashes(std::move(state.blockIndexesByBlockHashes)),
 keyOutputGlobalIndexesCountForAmounts(std::move(state.keyOutputGlobalIndexesCountForAmounts)),
 keyOutputGlobalIndexesForAmounts(std::move(state.keyOutputGlobalIndexesForAmounts)),
-rawBlocks(std::move(state.rawBlocks)),
 blockHashesByTimestamp(std::move(state.blockHashesByTimestamp)),
 keyOutputKeys(std::move(state.keyOutputKeys)),
+blockUndoInfos(std::move(state.blockUndoInfos)),
 closestTimestampBlockIndex(std::move(state.closestTimestampBlockIndex)),
 lastBlockIndex(std::move(state.lastBlockIndex)),
 keyOutputAmountsCount(std::move(state.keyOutputAmountsCount)),
@@ -309,13 +309,13 @@ size_t BlockchainReadState::size() const {
     blockIndexesByBlockHashes.size() +
     keyOutputGlobalIndexesCountForAmounts.size() +
     keyOutputGlobalIndexesForAmounts.size() +
-    rawBlocks.size() +
     closestTimestampBlockIndex.size() +
     keyOutputAmounts.size() +
     transactionCountsByPaymentIds.size() +
     transactionHashesByPaymentIds.size() +
     blockHashesByTimestamp.size() +
     keyOutputKeys.size() +
+    blockUndoInfos.size() +
     (lastBlockIndex.second ? 1 : 0) +
     (keyOutputAmountsCount.second ? 1 : 0) +
     (transactionsCount.second ? 1 : 0);
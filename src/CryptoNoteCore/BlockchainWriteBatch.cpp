@@ -71,11 +71,6 @@ BlockchainWriteBatch& BlockchainWriteBatch::insertKeyOutputGlobalIndexes(IBlockc
   return *this;
 }
 
-BlockchainWriteBatch& BlockchainWriteBatch::insertRawBlock(uint32_t blockIndex, const RawBlock& block) {
-  rawDataToInsert.emplace_back(DB::serialize(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, blockIndex, block));
-  return *this;
-}
-
 BlockchainWriteBatch& BlockchainWriteBatch::insertClosestTimestampBlockIndex(uint64_t timestamp, uint32_t blockIndex) {
   rawDataToInsert.emplace_back(DB::serialize(DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, timestamp, blockIndex));
   return *this;
@@ -105,6 +100,11 @@ BlockchainWriteBatch& BlockchainWriteBatch::insertKeyOutputInfo(IBlockchainCache
   return *this;
 }
 
+BlockchainWriteBatch& BlockchainWriteBatch::insertBlockUndoInfo(uint32_t blockIndex, const BlockUndoInfo& undoInfo) {
+  rawDataToInsert.emplace_back(DB::serialize(DB::BLOCK_INDEX_TO_UNDO_INFO_PREFIX, blockIndex, undoInfo));
+  return *this;
+}
+
 BlockchainWriteBatch& BlockchainWriteBatch::removeSpentKeyImages(uint32_t blockIndex, const std::vector<Crypto::KeyImage>& spentKeyImages) {
   rawKeysToRemove.reserve(rawKeysToRemove.size() + spentKeyImages.size() + 1);
   rawKeysToRemove.emplace_back(DB::serializeKey(DB::BLOCK_INDEX_TO_KEY_IMAGE_PREFIX, blockIndex));
@@ -123,7 +123,12 @@ BlockchainWriteBatch& BlockchainWriteBatch::removeCachedTransaction(const Crypto
 }
 
 BlockchainWriteBatch& BlockchainWriteBatch::removePaymentId(const Crypto::Hash paymentId, uint32_t totalTxsCountForPaymentId) {
-  rawDataToInsert.emplace_back(DB::serialize(DB::PAYMENT_ID_TO_TX_HASH_PREFIX, paymentId, totalTxsCountForPaymentId));
+  if (totalTxsCountForPaymentId == 0) {
+    rawKeysToRemove.emplace_back(DB::serializeKey(DB::PAYMENT_ID_TO_TX_HASH_PREFIX, paymentId));
+  } else {
+    rawDataToInsert.emplace_back(DB::serialize(DB::PAYMENT_ID_TO_TX_HASH_PREFIX, paymentId, totalTxsCountForPaymentId));
+  }
+
   rawKeysToRemove.emplace_back(DB::serializeKey(DB::PAYMENT_ID_TO_TX_HASH_PREFIX, std::make_pair(paymentId, totalTxsCountForPaymentId)));
   return *this;
 }
@@ -138,18 +143,18 @@ BlockchainWriteBatch& BlockchainWriteBatch::removeCachedBlock(const Crypto::Hash
 
 BlockchainWriteBatch& BlockchainWriteBatch::removeKeyOutputGlobalIndexes(IBlockchainCache::Amount amount, uint32_t outputsToRemoveCount, uint32_t totalOutputsCountForAmount) {
   rawKeysToRemove.reserve(rawKeysToRemove.size() + outputsToRemoveCount);
-  rawDataToInsert.emplace_back(DB::serialize(DB::KEY_OUTPUT_AMOUNT_PREFIX, amount, totalOutputsCountForAmount));
+  if (totalOutputsCountForAmount == 0) {
+    rawKeysToRemove.emplace_back(DB::serializeKey(DB::KEY_OUTPUT_AMOUNT_PREFIX, amount));
+  } else {
+    rawDataToInsert.emplace_back(DB::serialize(DB::KEY_OUTPUT_AMOUNT_PREFIX, amount, totalOutputsCountForAmount));
+  }
+
   for (uint32_t i = 0; i < outputsToRemoveCount; ++i) {
     rawKeysToRemove.emplace_back(DB::serializeKey(DB::KEY_OUTPUT_AMOUNT_PREFIX, std::make_pair(amount, totalOutputsCountForAmount + i)));
   }
   return *this;
 }
 
-BlockchainWriteBatch& BlockchainWriteBatch::removeRawBlock(uint32_t blockIndex) {
-  rawKeysToRemove.emplace_back(DB::serializeKey(DB::BLOCK_INDEX_TO_RAW_BLOCK_PREFIX, blockIndex));
-  return *this;
-}
-
 BlockchainWriteBatch& BlockchainWriteBatch::removeClosestTimestampBlockIndex(uint64_t timestamp) {
   rawKeysToRemove.emplace_back(DB::serializeKey(DB::CLOSEST_TIMESTAMP_BLOCK_INDEX_PREFIX, timestamp));
   return *this;
@@ -175,6 +180,11 @@ BlockchainWriteBatch&BlockchainWriteBatch::removeKeyOutputInfo(IBlockchainCache:
   return *this;
 }
 
+BlockchainWriteBatch& BlockchainWriteBatch::removeBlockUndoInfo(uint32_t blockIndex) {
+  rawKeysToRemove.emplace_back(DB::serializeKey(DB::BLOCK_INDEX_TO_UNDO_INFO_PREFIX, blockIndex));
+  return *this;
+}
+
 std::vector<std::pair<std::string, std::string>> BlockchainWriteBatch::extractRawDataToInsert() {
   return std::move(rawDataToInsert);
 }
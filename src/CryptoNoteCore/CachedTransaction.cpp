@@ -86,3 +86,49 @@ uint64_t CachedTransaction::getTransactionFee() const {
 
   return transactionFee.get();
 }
+
+const TransactionView& CachedTransaction::getTransactionView() const {
+  if (!transactionView.is_initialized()) {
+    transactionView = TransactionView(getTransactionBinaryArray());
+  }
+
+  return transactionView.get();
+}
+
+void CachedTransaction::computeHashes(const std::vector<CachedTransaction>& transactions) {
+  std::vector<BinaryArray> prefixBinaryArrays;
+  prefixBinaryArrays.reserve(transactions.size());
+  for (const auto& cachedTransaction : transactions) {
+    if (!cachedTransaction.transactionPrefixHash.is_initialized()) {
+      prefixBinaryArrays.emplace_back(toBinaryArray(static_cast<const TransactionPrefix&>(cachedTransaction.transaction)));
+    }
+  }
+
+  std::vector<const void*> data;
+  std::vector<size_t> lengths;
+  std::vector<Hash*> hashes;
+  data.reserve(2 * transactions.size());
+  lengths.reserve(2 * transactions.size());
+  hashes.reserve(2 * transactions.size());
+
+  auto prefixBinaryArray = prefixBinaryArrays.begin();
+  for (const auto& cachedTransaction : transactions) {
+    if (!cachedTransaction.transactionHash.is_initialized()) {
+      const auto& binaryArray = cachedTransaction.getTransactionBinaryArray();
+      cachedTransaction.transactionHash = Hash();
+      data.push_back(binaryArray.data());
+      lengths.push_back(binaryArray.size());
+      hashes.push_back(&cachedTransaction.transactionHash.get());
+    }
+
+    if (!cachedTransaction.transactionPrefixHash.is_initialized()) {
+      cachedTransaction.transactionPrefixHash = Hash();
+      data.push_back(prefixBinaryArray->data());
+      lengths.push_back(prefixBinaryArray->size());
+      hashes.push_back(&cachedTransaction.transactionPrefixHash.get());
+      ++prefixBinaryArray;
+    }
+  }
+
+  cn_fast_hash_many(data.data(), lengths.data(), hashes.data(), hashes.size());
+}
@@ -19,6 +19,7 @@
 
 #include <boost/optional.hpp>
 #include <CryptoNote.h>
+#include "TransactionView.h"
 
 namespace CryptoNote {
 
@@ -32,6 +33,11 @@ public:
   const Crypto::Hash& getTransactionPrefixHash() const;
   const BinaryArray& getTransactionBinaryArray() const;
   uint64_t getTransactionFee() const;
+  // Built from the binary array on first use, what validation reads instead of getTransaction()
+  const TransactionView& getTransactionView() const;
+
+  // Computes the transaction and prefix hashes of all the transactions at once with cn_fast_hash_many
+  static void computeHashes(const std::vector<CachedTransaction>& transactions);
 
 private:
   Transaction transaction;
@@ -39,6 +45,7 @@ private:
   mutable boost::optional<Crypto::Hash> transactionHash;
   mutable boost::optional<Crypto::Hash> transactionPrefixHash;
   mutable boost::optional<uint64_t> transactionFee;
+  mutable boost::optional<TransactionView> transactionView;
 };
 
 }
@@ -5,7 +5,11 @@
 // Please see the included LICENSE file for more information.
 
 #include <algorithm>
+#include <chrono>
+#include <future>
+#include <iterator>
 #include <numeric>
+#include <thread>
 #include <set>
 #include <unordered_set>
 
@@ -46,6 +50,13 @@ std::vector<T> preallocateVector(size_t elements) {
 }
 UseGenesis addGenesisBlock = UseGenesis(true);
 
+// below this many transactions per thread, starting the threads costs more than parsing serially
+const size_t MIN_TRANSACTIONS_PER_PARSING_THREAD = 16;
+
+// blocks read from the main chain storage at once when importing, the next run is parsed while the current one is pushed
+const uint32_t IMPORT_BLOCKS_BATCH_SIZE = 500;
+const uint32_t IMPORT_PROGRESS_INTERVAL = 1000;
+
 class TransactionSpentInputsChecker {
 public:
   bool haveSpentInputs(const Transaction& transaction) {
@@ -185,7 +196,8 @@ Core::Core(const Currency& currency, Logging::ILogger& logger, Checkpoints&& che
            std::unique_ptr<IBlockchainCacheFactory>&& blockchainCacheFactory, std::unique_ptr<IMainChainStorage>&& mainchainStorage)
     : currency(currency), dispatcher(dispatcher), contextGroup(dispatcher), logger(logger, "Core"), checkpoints(std::move(checkpoints)),
       upgradeManager(new UpgradeManager()), blockchainCacheFactory(std::move(blockchainCacheFactory)),
-      mainChainStorage(std::move(mainchainStorage)), initialized(false) {
+      mainChainStorage(std::move(mainchainStorage)), initialized(false),
+      explorerCache(parameters::EXPLORER_CACHE_DEFAULT_SIZE), memorySegmentDepth(parameters::CRYPTONOTE_MEMORY_SEGMENT_DEFAULT_DEPTH) {
 
   upgradeManager->addMajorBlockVersion(BLOCK_MAJOR_VERSION_2, currency.upgradeHeight(BLOCK_MAJOR_VERSION_2));
   upgradeManager->addMajorBlockVersion(BLOCK_MAJOR_VERSION_3, currency.upgradeHeight(BLOCK_MAJOR_VERSION_3));
@@ -665,6 +677,18 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
       if (cache == chainsLeaves[0]) {
         mainChainStorage->pushBlock(rawBlock);
 
+        // new blocks go to memory segments first, so that a short fork doesn't have to split the database
+        if (memorySegmentDepth != 0 && !checkpoints.isInCheckpointZone(cachedBlock.getBlockIndex()) &&
+            (cache->getParent() == nullptr || cache->getBlockCount() >= memorySegmentDepth)) {
+          auto newCache = blockchainCacheFactory->createBlockchainCache(currency, cache, previousBlockIndex + 1);
+          cache->addChild(newCache.get());
+
+          cache = newCache.get();
+          chainsStorage.emplace_back(std::move(newCache));
+          chainsLeaves[0] = cache;
+          mainChainSet.emplace(cache);
+        }
+
         cache->pushBlock(cachedBlock, transactions, validatorState, cumulativeBlockSize, emissionChange, currentDifficulty, std::move(rawBlock));
 
         updateBlockMedianSize();
@@ -690,8 +714,16 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
           std::swap(chainsLeaves[0], chainsLeaves[endpointIndex]);
           updateMainChainSet();
 
+          // the first block of the previous main chain which is not in the new one
+          uint32_t splitBlockIndex = mainChainCache->getTopBlockIndex() + 1;
+          for (auto segment = mainChainCache; segment != nullptr && mainChainSet.count(segment) == 0; segment = segment->getParent()) {
+            splitBlockIndex = segment->getStartBlockIndex();
+          }
+
+          explorerCache.removeFrom(splitBlockIndex);
+
           updateBlockMedianSize();
-          actualizePoolTransactions();
+          actualizePoolTransactions(splitBlockIndex, mainChainCache->getTopBlockIndex());
           copyTransactionsToPool(chainsLeaves[endpointIndex]);
 
           switchMainChainStorage(chainsLeaves[0]->getStartBlockIndex(), *chainsLeaves[0]);
@@ -754,14 +786,57 @@ std::error_code Core::addBlock(const CachedBlock& cachedBlock, RawBlock&& rawBlo
   }
 
   logger(Logging::DEBUGGING) << "Block: " << blockStr << " successfully added";
+  resetChainStatus();
   notifyOnSuccess(ret, previousBlockIndex, cachedBlock, *cache);
 
+  if (ret != error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE) {
+    commitBuriedSegments();
+  }
+
   return ret;
 }
 
-void Core::actualizePoolTransactions() {
+void Core::actualizePoolTransactions(uint32_t splitBlockIndex, uint32_t previousTopBlockIndex) {
   auto& pool = *transactionPool;
-  auto hashes = pool.getTransactionHashes();
+  IBlockchainCache* mainChain = chainsLeaves[0];
+
+  std::vector<Crypto::Hash> hashes;
+  if (mainChain->getTopBlockIndex() < previousTopBlockIndex) {
+    // the chain got shorter, outputs may be locked again, so everything is checked as before
+    hashes = pool.getTransactionHashes();
+  } else {
+    TransactionValidatorState switchedBlocksState;
+    for (uint32_t index = splitBlockIndex; index <= mainChain->getTopBlockIndex(); ++index) {
+      RawBlock rawBlock = mainChain->getBlockByIndex(index);
+      for (const auto& transactionBinaryArray : rawBlock.transactions) {
+        mergeStates(switchedBlocksState, extractSpentOutputs(CachedTransaction(transactionBinaryArray)));
+      }
+    }
+
+    actualizePoolTransactionsLite(switchedBlocksState);
+
+    // ring members taken from the switched blocks may be different outputs in the new chain
+    std::unordered_map<uint64_t, size_t> keyOutputsCounts;
+    for (const auto& hash : pool.getTransactionHashes()) {
+      for (const auto& input : pool.getTransaction(hash).getTransaction().inputs) {
+        if (input.type() != typeid(KeyInput)) {
+          continue;
+        }
+
+        const KeyInput& in = boost::get<KeyInput>(input);
+        auto countIt = keyOutputsCounts.find(in.amount);
+        if (countIt == keyOutputsCounts.end()) {
+          countIt = keyOutputsCounts.emplace(in.amount, mainChain->getKeyOutputsCountForAmount(in.amount, splitBlockIndex)).first;
+        }
+
+        uint64_t lastGlobalIndex = std::accumulate(in.outputIndexes.begin(), in.outputIndexes.end(), uint64_t(0));
+        if (lastGlobalIndex >= countIt->second) {
+          hashes.push_back(hash);
+          break;
+        }
+      }
+    }
+  }
 
   for (auto& hash : hashes) {
     auto tx = pool.getTransaction(hash);
@@ -775,15 +850,13 @@ void Core::actualizePoolTransactions() {
 
 void Core::actualizePoolTransactionsLite(const TransactionValidatorState& validatorState) {
   auto& pool = *transactionPool;
-  auto hashes = pool.getTransactionHashes();
+  auto hashes = pool.getTransactionHashesByKeyImages(validatorState);
+  auto oversizedHashes = pool.getTransactionHashesBiggerThan(getMaximumTransactionAllowedSize(blockMedianSize, currency));
+  hashes.insert(hashes.end(), oversizedHashes.begin(), oversizedHashes.end());
 
   for (auto& hash : hashes) {
-    auto tx = pool.getTransaction(hash);
-
-    auto txState = extractSpentOutputs(tx);
-
-    if (hasIntersections(validatorState, txState) || tx.getTransactionBinaryArray().size() > getMaximumTransactionAllowedSize(blockMedianSize, currency)) {
-      pool.removeTransaction(hash);
+    // a transaction can be both in conflict and too big
+    if (pool.removeTransaction(hash)) {
       notifyObservers(makeDelTransactionMessage({ hash }, Messages::DeleteTransaction::Reason::NotActual));
     }
   }
@@ -893,8 +966,23 @@ bool Core::getTransactionGlobalIndexes(const Crypto::Hash& transactionHash,
 
 bool Core::getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes,
                             std::vector<Crypto::PublicKey>& publicKeys) const {
+  std::vector<std::vector<uint32_t>> amountGlobalIndexes;
+  std::vector<std::vector<Crypto::PublicKey>> amountPublicKeys;
+  if (!getRandomOutputs(std::vector<uint64_t>{amount}, count, amountGlobalIndexes, amountPublicKeys)) {
+    return false;
+  }
+
+  globalIndexes = std::move(amountGlobalIndexes.front());
+  publicKeys = std::move(amountPublicKeys.front());
+  return true;
+}
+
+bool Core::getRandomOutputs(const std::vector<uint64_t>& amounts, uint16_t count, std::vector<std::vector<uint32_t>>& globalIndexes,
+                            std::vector<std::vector<Crypto::PublicKey>>& publicKeys) const {
   throwIfNotInitialized();
 
+  globalIndexes.assign(amounts.size(), {});
+  publicKeys.assign(amounts.size(), {});
   if (count == 0) {
     return true;
   }
@@ -905,44 +993,48 @@ bool Core::getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_
     return false;
   }
 
-  globalIndexes = chainsLeaves[0]->getRandomOutsByAmount(amount, count, getTopBlockIndex());
-  if (globalIndexes.empty()) {
-    return false;
-  }
+  // all the amounts are picked together, so the database is read a few times per request rather than per amount
+  auto outputs = chainsLeaves[0]->getRandomOutsByAmounts(amounts, std::vector<size_t>(amounts.size(), count), getTopBlockIndex());
+  for (size_t i = 0; i < amounts.size(); ++i) {
+    if (outputs[i].empty()) {
+      logger(Logging::DEBUGGING) << "No unlocked outputs for amount " << amounts[i];
+      return false;
+    }
 
-  std::sort(globalIndexes.begin(), globalIndexes.end());
+    std::sort(outputs[i].begin(), outputs[i].end(), [] (const RandomOutput& left, const RandomOutput& right) {
+      return left.globalIndex < right.globalIndex;
+    });
 
-  switch (chainsLeaves[0]->extractKeyOutputKeys(amount, getTopBlockIndex(), {globalIndexes.data(), globalIndexes.size()},
-                                                publicKeys)) {
-    case ExtractOutputKeysResult::SUCCESS:
-      return true;
-    case ExtractOutputKeysResult::INVALID_GLOBAL_INDEX:
-      logger(Logging::DEBUGGING) << "Invalid global index is given";
-      return false;
-    case ExtractOutputKeysResult::OUTPUT_LOCKED:
-      logger(Logging::DEBUGGING) << "Output is locked";
-      return false;
+    globalIndexes[i].reserve(outputs[i].size());
+    publicKeys[i].reserve(outputs[i].size());
+    for (const RandomOutput& output : outputs[i]) {
+      globalIndexes[i].push_back(output.globalIndex);
+      publicKeys[i].push_back(output.publicKey);
+    }
   }
 
-  return false;
+  return true;
 }
 
 bool Core::addTransactionToPool(const BinaryArray& transactionBinaryArray) {
   throwIfNotInitialized();
 
-  Transaction transaction;
-  if (!fromBinaryArray<Transaction>(transaction, transactionBinaryArray)) {
+  // keeps the binary array, so hashing and validation don't serialize the transaction again
+  boost::optional<CachedTransaction> cachedTransaction;
+  try {
+    cachedTransaction = CachedTransaction(transactionBinaryArray);
+  } catch (std::runtime_error&) {
     logger(Logging::WARNING) << "Couldn't add transaction to pool due to deserialization error";
     return false;
   }
 
-  CachedTransaction cachedTransaction(std::move(transaction));
-  auto transactionHash = cachedTransaction.getTransactionHash();
+  auto transactionHash = cachedTransaction->getTransactionHash();
 
-  if (!addTransactionToPool(std::move(cachedTransaction))) {
+  if (!addTransactionToPool(std::move(*cachedTransaction))) {
     return false;
   }
 
+  updatePoolTransactionCount();
   notifyObservers(makeAddTransactionMessage({transactionHash}));
   return true;
 }
@@ -1032,16 +1124,27 @@ bool Core::getPoolChangesLite(const Crypto::Hash& lastBlockHash, const std::vect
 
   std::vector<Crypto::Hash> newTransactions;
   getTransactionPoolDifference(knownHashes, newTransactions, deletedTransactions);
+  getPoolTransactionPrefixes(newTransactions, addedTransactions);
 
-  addedTransactions.reserve(newTransactions.size());
-  for (const auto& hash : newTransactions) {
-    TransactionPrefixInfo transactionPrefixInfo;
-    transactionPrefixInfo.txHash = hash;
-    transactionPrefixInfo.txPrefix =
-        static_cast<const TransactionPrefix&>(transactionPool->getTransaction(hash).getTransaction());
-    addedTransactions.emplace_back(std::move(transactionPrefixInfo));
+  return getTopBlockHash() == lastBlockHash;
+}
+
+bool Core::getPoolChangesSince(const Crypto::Hash& lastBlockHash, uint64_t sequenceNumber,
+                               std::vector<TransactionPrefixInfo>& addedTransactions,
+                               std::vector<Crypto::Hash>& deletedTransactions,
+                               uint64_t& currentSequenceNumber, bool& isSequenceActual) const {
+  throwIfNotInitialized();
+
+  std::vector<Crypto::Hash> newTransactions;
+  currentSequenceNumber = transactionPool->getSequenceNumber();
+  isSequenceActual = transactionPool->getChangesSince(sequenceNumber, newTransactions, deletedTransactions);
+  if (!isSequenceActual) {
+    newTransactions = transactionPool->getTransactionHashes();
+    deletedTransactions.clear();
   }
 
+  getPoolTransactionPrefixes(newTransactions, addedTransactions);
+
   return getTopBlockHash() == lastBlockHash;
 }
 
@@ -1278,16 +1381,54 @@ std::vector<Transaction> Core::getPoolTransactions() const {
 }
 
 bool Core::extractTransactions(const std::vector<BinaryArray>& rawTransactions,
-                               std::vector<CachedTransaction>& transactions, uint64_t& cumulativeSize) {
+                               std::vector<CachedTransaction>& transactions, uint64_t& cumulativeSize, bool parallel) {
+  for (auto& rawTransaction : rawTransactions) {
+    if (rawTransaction.size() > currency.maxTxSize()) {
+      logger(Logging::INFO) << "Raw transaction size " << rawTransaction.size() << " is too big.";
+      return false;
+    }
+
+    cumulativeSize += rawTransaction.size();
+  }
+
+  size_t workers = parallel ? std::min<size_t>(std::thread::hardware_concurrency(), rawTransactions.size() / MIN_TRANSACTIONS_PER_PARSING_THREAD) : 1;
+
   try {
-    for (auto& rawTransaction : rawTransactions) {
-      if (rawTransaction.size() > currency.maxTxSize()) {
-        logger(Logging::INFO) << "Raw transaction size " << rawTransaction.size() << " is too big.";
-        return false;
+    if (workers < 2) {
+      for (auto& rawTransaction : rawTransactions) {
+        transactions.emplace_back(rawTransaction);
       }
 
-      cumulativeSize += rawTransaction.size();
-      transactions.emplace_back(rawTransaction);
+      CachedTransaction::computeHashes(transactions);
+      return true;
+    }
+
+    // every worker parses and hashes a contiguous run of the transactions, so joining the runs keeps the block order
+    std::vector<std::future<std::vector<CachedTransaction>>> parsingThreads;
+    size_t begin = 0;
+    for (size_t i = 0; i < workers; ++i) {
+      size_t end = rawTransactions.size() * (i + 1) / workers;
+      parsingThreads.push_back(std::async(std::launch::async, [&rawTransactions, begin, end] {
+        std::vector<CachedTransaction> parsed;
+        parsed.reserve(end - begin);
+        for (size_t j = begin; j < end; ++j) {
+          parsed.emplace_back(rawTransactions[j]);
+          parsed.back().getTransactionFee();
+          parsed.back().getTransactionView();
+        }
+
+        CachedTransaction::computeHashes(parsed);
+        return parsed;
+      }));
+
+      begin = end;
+    }
+
+    transactions.reserve(transactions.size() + rawTransactions.size());
+    for (auto& parsingThread : parsingThreads) {
+      // rethrows the deserialization error of a worker, the remaining ones are waited for on destruction
+      auto parsed = parsingThread.get();
+      std::move(parsed.begin(), parsed.end(), std::back_inserter(transactions));
     }
   } catch (std::runtime_error& e) {
     logger(Logging::INFO) << e.what();
@@ -1300,16 +1441,14 @@ bool Core::extractTransactions(const std::vector<BinaryArray>& rawTransactions,
 std::error_code Core::validateTransaction(const CachedTransaction& cachedTransaction, TransactionValidatorState& state,
                                           IBlockchainCache* cache, uint64_t& fee, uint32_t blockIndex) {
   // TransactionValidatorState currentState;
-  const auto& transaction = cachedTransaction.getTransaction();
+  const auto& transaction = cachedTransaction.getTransactionView();
 auto error = validateSemantic(transaction, fee, blockIndex);
   if (error != error::TransactionValidationError::VALIDATION_SUCCESS) {
     return error;
   }
 
-  size_t inputIndex = 0;
-  for (const auto& input : transaction.inputs) {
-    if (input.type() == typeid(KeyInput)) {
-      const KeyInput& in = boost::get<KeyInput>(input);
+  for (const auto& in : transaction.getInputs()) {
+    if (!in.isBase) {
       if (!state.spentKeyImages.insert(in.keyImage).second) {
         return error::TransactionValidationError::INPUT_KEYIMAGE_ALREADY_SPENT;
       }
@@ -1320,12 +1459,13 @@ auto error = validateSemantic(transaction, fee, blockIndex);
         }
 
         std::vector<PublicKey> outputKeys;
-        assert(!in.outputIndexes.empty());
+        auto outputIndexes = transaction.getOutputIndexes(in);
+        assert(!outputIndexes.isEmpty());
 
-        std::vector<uint32_t> globalIndexes(in.outputIndexes.size());
-        globalIndexes[0] = in.outputIndexes[0];
-        for (size_t i = 1; i < in.outputIndexes.size(); ++i) {
-          globalIndexes[i] = globalIndexes[i - 1] + in.outputIndexes[i];
+        std::vector<uint32_t> globalIndexes(outputIndexes.getSize());
+        globalIndexes[0] = outputIndexes[0];
+        for (size_t i = 1; i < outputIndexes.getSize(); ++i) {
+          globalIndexes[i] = globalIndexes[i - 1] + outputIndexes[i];
         }
 
         auto result = cache->extractKeyOutputKeys(in.amount, blockIndex, {globalIndexes.data(), globalIndexes.size()}, outputKeys);
@@ -1341,7 +1481,7 @@ auto error = validateSemantic(transaction, fee, blockIndex);
         outputKeyPointers.reserve(outputKeys.size());
         std::for_each(outputKeys.begin(), outputKeys.end(), [&outputKeyPointers] (const Crypto::PublicKey& key) { outputKeyPointers.push_back(&key); });
         if (!Crypto::check_ring_signature(cachedTransaction.getTransactionPrefixHash(), in.keyImage, outputKeyPointers.data(),
-                                          outputKeyPointers.size(), transaction.signatures[inputIndex].data(),
+                                          outputKeyPointers.size(), transaction.getSignatures(in).getData(),
                                           blockIndex > parameters::KEY_IMAGE_CHECKING_BLOCK_INDEX)) {
           return error::TransactionValidationError::INPUT_INVALID_SIGNATURES;
         }
@@ -1351,30 +1491,25 @@ auto error = validateSemantic(transaction, fee, blockIndex);
       assert(false);
       return error::TransactionValidationError::INPUT_UNKNOWN_TYPE;
     }
-
-    inputIndex++;
   }
 
   return error::TransactionValidationError::VALIDATION_SUCCESS;
 }
 
-std::error_code Core::validateSemantic(const Transaction& transaction, uint64_t& fee, uint32_t blockIndex) {
-  if (transaction.inputs.empty()) {
+std::error_code Core::validateSemantic(const TransactionView& transaction, uint64_t& fee, uint32_t blockIndex) {
+  if (transaction.getInputs().isEmpty()) {
     return error::TransactionValidationError::EMPTY_INPUTS;
   }
 
   uint64_t summaryOutputAmount = 0;
-  for (const auto& output : transaction.outputs) {
+  for (const auto& output : transaction.getOutputs()) {
     if (output.amount == 0) {
       return error::TransactionValidationError::OUTPUT_ZERO_AMOUNT;
     }
 
-    if (output.target.type() == typeid(KeyOutput)) {
-      if (!check_key(boost::get<KeyOutput>(output.target).key)) {
-        return error::TransactionValidationError::OUTPUT_INVALID_KEY;
-      }
-    } else {
-      return error::TransactionValidationError::OUTPUT_UNKNOWN_TYPE;
+    // TransactionView only reads key outputs, other targets are refused while parsing
+    if (!check_key(output.key)) {
+      return error::TransactionValidationError::OUTPUT_INVALID_KEY;
     }
 
     if (std::numeric_limits<uint64_t>::max() - output.amount < summaryOutputAmount) {
@@ -1393,16 +1528,16 @@ std::error_code Core::validateSemantic(const Transaction& transaction, uint64_t&
   uint64_t summaryInputAmount = 0;
   std::unordered_set<Crypto::KeyImage> ki;
   std::set<std::pair<uint64_t, uint32_t>> outputsUsage;
-  for (const auto& input : transaction.inputs) {
+  for (const auto& in : transaction.getInputs()) {
     uint64_t amount = 0;
-    if (input.type() == typeid(KeyInput)) {
-      const KeyInput& in = boost::get<KeyInput>(input);
+    if (!in.isBase) {
       amount = in.amount;
       if (!ki.insert(in.keyImage).second) {
         return error::TransactionValidationError::INPUT_IDENTICAL_KEYIMAGES;
       }
 
-      if (in.outputIndexes.empty()) {
+      auto outputIndexes = transaction.getOutputIndexes(in);
+      if (outputIndexes.isEmpty()) {
         return error::TransactionValidationError::INPUT_EMPTY_OUTPUT_USAGE;
       }
 
@@ -1413,7 +1548,7 @@ std::error_code Core::validateSemantic(const Transaction& transaction, uint64_t&
     return error::TransactionValidationError::INPUT_INVALID_DOMAIN_KEYIMAGES;
   }
 
-      if (std::find(++std::begin(in.outputIndexes), std::end(in.outputIndexes), 0) != std::end(in.outputIndexes)) {
+      if (std::find(outputIndexes.begin() + 1, outputIndexes.end(), 0) != outputIndexes.end()) {
         return error::TransactionValidationError::INPUT_IDENTICAL_OUTPUT_INDEXES;
       }
     } else {
@@ -1431,7 +1566,6 @@ std::error_code Core::validateSemantic(const Transaction& transaction, uint64_t&
     return error::TransactionValidationError::WRONG_AMOUNT;
   }
 
-  assert(transaction.signatures.size() == transaction.inputs.size());
   fee = summaryInputAmount - summaryOutputAmount;
   return error::TransactionValidationError::VALIDATION_SUCCESS;
 }
@@ -1541,6 +1675,7 @@ void Core::save() {
   deleteAlternativeChains();
   mergeMainChainSegments();
   chainsLeaves[0]->save();
+  resetChainStatus();
 }
 
 void Core::load() {
@@ -1586,11 +1721,24 @@ void Core::initRootSegment() {
 
   contextGroup.spawn(std::bind(&Core::transactionPoolCleaningProcedure, this));
 
-  updateBlockMedianSize();
-
+  // loaded first, so the block sizes below come from the cache snapshot if there is one
   chainsLeaves[0]->load();
+
+  updateBlockMedianSize();
 }
 
+// A block of the main chain storage, parsed and hashed off the importing thread. The template lives on the heap, so the
+// cached block referencing it survives moves of the structure.
+struct Core::ImportedBlock {
+  RawBlock rawBlock;
+  std::unique_ptr<BlockTemplate> blockTemplate;
+  std::unique_ptr<CachedBlock> cachedBlock;
+  std::vector<CachedTransaction> transactions;
+  TransactionValidatorState spentOutputs;
+  uint64_t cumulativeSize;
+  uint64_t cumulativeFee;
+};
+
 void Core::importBlocksFromStorage() {
   uint32_t commonIndex = findCommonRoot(*mainChainStorage, *chainsLeaves[0]);
   assert(commonIndex <= mainChainStorage->getBlockCount());
@@ -1599,44 +1747,123 @@ void Core::importBlocksFromStorage() {
 
   auto previousBlockHash = getBlockHash(mainChainStorage->getBlockByIndex(commonIndex));
   auto blockCount = mainChainStorage->getBlockCount();
-  for (uint32_t i = commonIndex + 1; i < blockCount; ++i) {
-    RawBlock rawBlock = mainChainStorage->getBlockByIndex(i);
-    auto blockTemplate = extractBlockTemplate(rawBlock);
-    CachedBlock cachedBlock(blockTemplate);
 
-    if (blockTemplate.previousBlockHash != previousBlockHash) {
-      logger(Logging::ERROR) << "Corrupted blockchain. Block with index " << i << " and hash " << cachedBlock.getBlockHash()
-                             << " has previous block hash " << blockTemplate.previousBlockHash << ", but parent has hash " << previousBlockHash
-                             << ". Resynchronize your daemon please.";
-      throw std::system_error(make_error_code(error::CoreErrorCode::CORRUPTED_BLOCKCHAIN));
+  // the storage isn't safe to read concurrently with pushing, so raw blocks are read here and only parsed in the background
+  auto readRawBlocks = [this, blockCount] (uint32_t startIndex) {
+    std::vector<RawBlock> rawBlocks;
+    uint32_t endIndex = std::min(blockCount, startIndex + IMPORT_BLOCKS_BATCH_SIZE);
+    rawBlocks.reserve(endIndex - startIndex);
+    for (uint32_t i = startIndex; i < endIndex; ++i) {
+      rawBlocks.push_back(mainChainStorage->getBlockByIndex(i));
     }
 
-    previousBlockHash = cachedBlock.getBlockHash();
+    return rawBlocks;
+  };
 
-    std::vector<CachedTransaction> transactions;
-    uint64_t cumulativeSize = 0;
-    if (!extractTransactions(rawBlock.transactions, transactions, cumulativeSize)) {
-      logger(Logging::ERROR) << "Couldn't deserialize raw block transactions in block " << cachedBlock.getBlockHash();
-      throw std::system_error(make_error_code(error::AddBlockErrorCode::DESERIALIZATION_FAILED));
+  auto progressTime = std::chrono::steady_clock::now();
+  uint32_t progressIndex = commonIndex;
+
+  std::future<std::vector<ImportedBlock>> nextBatch;
+  if (commonIndex + 1 < blockCount) {
+    nextBatch = std::async(std::launch::async, &Core::prepareImportedBlocks, this, commonIndex + 1, readRawBlocks(commonIndex + 1));
+  }
+
+  for (uint32_t batchIndex = commonIndex + 1; batchIndex < blockCount; batchIndex += IMPORT_BLOCKS_BATCH_SIZE) {
+    // rethrows the deserialization error of the batch
+    std::vector<ImportedBlock> batch = nextBatch.get();
+    uint32_t nextBatchIndex = batchIndex + static_cast<uint32_t>(batch.size());
+    if (nextBatchIndex < blockCount) {
+      nextBatch = std::async(std::launch::async, &Core::prepareImportedBlocks, this, nextBatchIndex, readRawBlocks(nextBatchIndex));
     }
 
-    cumulativeSize += getObjectBinarySize(blockTemplate.baseTransaction);
-    TransactionValidatorState spentOutputs = extractSpentOutputs(transactions);
-    auto currentDifficulty = chainsLeaves[0]->getDifficultyForNextBlock(i - 1);
+    for (uint32_t i = batchIndex; i < nextBatchIndex; ++i) {
+      ImportedBlock& block = batch[i - batchIndex];
+      const CachedBlock& cachedBlock = *block.cachedBlock;
 
-    uint64_t cumulativeFee = std::accumulate(transactions.begin(), transactions.end(), UINT64_C(0), [] (uint64_t fee, const CachedTransaction& transaction) {
-      return fee + transaction.getTransactionFee();
-    });
+      if (block.blockTemplate->previousBlockHash != previousBlockHash) {
+        logger(Logging::ERROR) << "Corrupted blockchain. Block with index " << i << " and hash " << cachedBlock.getBlockHash()
+                               << " has previous block hash " << block.blockTemplate->previousBlockHash << ", but parent has hash " << previousBlockHash
+                               << ". Resynchronize your daemon please.";
+        throw std::system_error(make_error_code(error::CoreErrorCode::CORRUPTED_BLOCKCHAIN));
+      }
+
+      if (checkpoints.isInCheckpointZone(i) && !checkpoints.checkBlock(i, cachedBlock.getBlockHash())) {
+        logger(Logging::ERROR) << "Corrupted blockchain. Block with index " << i << " and hash " << cachedBlock.getBlockHash()
+                               << " doesn't match the checkpoints. Resynchronize your daemon please.";
+        throw std::system_error(make_error_code(error::CoreErrorCode::CORRUPTED_BLOCKCHAIN));
+      }
 
-    int64_t emissionChange = getEmissionChange(currency, *chainsLeaves[0], i - 1, cachedBlock, cumulativeSize, cumulativeFee);
-    chainsLeaves[0]->pushBlock(cachedBlock, transactions, spentOutputs, cumulativeSize, emissionChange, currentDifficulty, std::move(rawBlock));
+      previousBlockHash = cachedBlock.getBlockHash();
 
-    if (i % 1000 == 0) {
-      logger(Logging::INFO) << "Imported block with index " << i << " / " << (blockCount - 1);
+      auto currentDifficulty = chainsLeaves[0]->getDifficultyForNextBlock(i - 1);
+      int64_t emissionChange = getEmissionChange(currency, *chainsLeaves[0], i - 1, cachedBlock, block.cumulativeSize, block.cumulativeFee);
+      chainsLeaves[0]->pushBlock(cachedBlock, block.transactions, block.spentOutputs, block.cumulativeSize, emissionChange, currentDifficulty,
+                                 std::move(block.rawBlock));
+
+      if (i % IMPORT_PROGRESS_INTERVAL == 0) {
+        auto now = std::chrono::steady_clock::now();
+        double seconds = std::chrono::duration<double>(now - progressTime).count();
+        logger(Logging::INFO) << "Imported block with index " << i << " / " << (blockCount - 1) << ", "
+                              << static_cast<uint64_t>((i - progressIndex) / std::max(seconds, 0.001)) << " blocks/s";
+
+        progressTime = now;
+        progressIndex = i;
+      }
     }
   }
 }
 
+std::vector<Core::ImportedBlock> Core::prepareImportedBlocks(uint32_t startIndex, std::vector<RawBlock> rawBlocks) {
+  size_t workers = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), rawBlocks.size()));
+
+  // every worker prepares a contiguous run of the blocks, so joining the runs keeps the chain order
+  std::vector<std::future<std::vector<ImportedBlock>>> preparingThreads;
+  size_t begin = 0;
+  for (size_t i = 0; i < workers; ++i) {
+    size_t end = rawBlocks.size() * (i + 1) / workers;
+    preparingThreads.push_back(std::async(std::launch::async, [this, &rawBlocks, startIndex, begin, end] {
+      std::vector<ImportedBlock> prepared(end - begin);
+      for (size_t j = begin; j < end; ++j) {
+        ImportedBlock& block = prepared[j - begin];
+        block.rawBlock = std::move(rawBlocks[j]);
+        block.blockTemplate.reset(new BlockTemplate(extractBlockTemplate(block.rawBlock)));
+        block.cachedBlock.reset(new CachedBlock(*block.blockTemplate));
+        block.cachedBlock->getBlockHash();
+        block.cachedBlock->getBlockIndex();
+
+        block.cumulativeSize = 0;
+        // the blocks are already spread over the cores, parsing their transactions in parallel too would oversubscribe them
+        if (!extractTransactions(block.rawBlock.transactions, block.transactions, block.cumulativeSize, false)) {
+          logger(Logging::ERROR) << "Couldn't deserialize raw block transactions in block " << block.cachedBlock->getBlockHash()
+                                 << " with index " << (startIndex + j);
+          throw std::system_error(make_error_code(error::AddBlockErrorCode::DESERIALIZATION_FAILED));
+        }
+
+        block.cumulativeSize += getObjectBinarySize(block.blockTemplate->baseTransaction);
+        block.spentOutputs = extractSpentOutputs(block.transactions);
+        block.cumulativeFee = std::accumulate(block.transactions.begin(), block.transactions.end(), UINT64_C(0),
+                                              [] (uint64_t fee, const CachedTransaction& transaction) {
+          return fee + transaction.getTransactionFee();
+        });
+      }
+
+      return prepared;
+    }));
+
+    begin = end;
+  }
+
+  std::vector<ImportedBlock> blocks;
+  blocks.reserve(rawBlocks.size());
+  for (auto& preparingThread : preparingThreads) {
+    // rethrows the error of a worker, the remaining ones are waited for on destruction
+    auto prepared = preparingThread.get();
+    std::move(prepared.begin(), prepared.end(), std::back_inserter(blocks));
+  }
+
+  return blocks;
+}
+
 void Core::cutSegment(IBlockchainCache& segment, uint32_t startIndex) {
   if (segment.getTopBlockIndex() < startIndex) {
     return;
@@ -1865,6 +2092,18 @@ void Core::getTransactionPoolDifference(const std::vector<Crypto::Hash>& knownHa
   deletedTransactions.assign(knownTransactions.begin(), knownTransactions.end());
 }
 
+void Core::getPoolTransactionPrefixes(const std::vector<Crypto::Hash>& transactionHashes,
+                                      std::vector<TransactionPrefixInfo>& transactionPrefixes) const {
+  transactionPrefixes.reserve(transactionHashes.size());
+  for (const auto& hash : transactionHashes) {
+    TransactionPrefixInfo transactionPrefixInfo;
+    transactionPrefixInfo.txHash = hash;
+    transactionPrefixInfo.txPrefix =
+        static_cast<const TransactionPrefix&>(transactionPool->getTransaction(hash).getTransaction());
+    transactionPrefixes.emplace_back(std::move(transactionPrefixInfo));
+  }
+}
+
 uint8_t Core::getBlockMajorVersionForHeight(uint32_t height) const {
   return upgradeManager->getBlockMajorVersion(height);
 }
@@ -1935,6 +2174,22 @@ void Core::deleteAlternativeChains() {
   }
 }
 
+void Core::deleteAlternativeChildren(IBlockchainCache* segment) {
+  for (size_t leafIndex = 1; leafIndex < chainsLeaves.size();) {
+    IBlockchainCache* child = chainsLeaves[leafIndex];
+    while (child->getParent() != nullptr && child->getParent() != segment) {
+      child = child->getParent();
+    }
+
+    // deleteLeaf puts a parent left without children in place of the deleted leaf
+    if (child->getParent() == segment && mainChainSet.count(child) == 0) {
+      deleteLeaf(leafIndex);
+    } else {
+      ++leafIndex;
+    }
+  }
+}
+
 void Core::deleteLeaf(size_t leafIndex) {
   assert(leafIndex < chainsLeaves.size());
 
@@ -2001,6 +2256,56 @@ void Core::mergeMainChainSegments() {
   chainsLeaves.push_back(chainsStorage.begin()->get());
 }
 
+void Core::commitBuriedSegments() {
+  if (memorySegmentDepth == 0) {
+    return;
+  }
+
+  for (;;) {
+    // main chain segments from the leaf down to the root, which is the database
+    std::vector<IBlockchainCache*> chain;
+    for (IBlockchainCache* segment = chainsLeaves[0]; segment != nullptr; segment = segment->getParent()) {
+      chain.push_back(segment);
+    }
+
+    if (chain.size() < 3) {
+      return;
+    }
+
+    IBlockchainCache* root = chain[chain.size() - 1];
+    IBlockchainCache* segment = chain[chain.size() - 2];
+    if (chainsLeaves[0]->getTopBlockIndex() - segment->getTopBlockIndex() < memorySegmentDepth) {
+      return;
+    }
+
+    // An alternative chain forking at the database top couldn't be switched to once the database grows past it.
+    // Its fork point is more than the memory segment depth below the main chain top by now, so it's dropped
+    if (root->getChildCount() > 1) {
+      logger(Logging::DEBUGGING) << "Deleting alternative chains forking at block " << root->getTopBlockIndex();
+      deleteAlternativeChildren(root);
+    }
+
+    logger(Logging::DEBUGGING) << "Committing blocks " << segment->getStartBlockIndex() << " - " << segment->getTopBlockIndex() << " to the database";
+    mergeSegments(root, segment);
+
+    // every chain forking at the top of the committed segment forks at the database top now
+    root->deleteChild(segment);
+    for (const auto& storedSegment : chainsStorage) {
+      if (storedSegment->getParent() == segment) {
+        storedSegment->setParent(root);
+        root->addChild(storedSegment.get());
+      }
+    }
+
+    mainChainSet.erase(segment);
+
+    auto segmentIt = std::find_if(chainsStorage.begin(), chainsStorage.end(),
+      [segment](const std::unique_ptr<IBlockchainCache>& storedSegment) { return storedSegment.get() == segment; });
+    assert(segmentIt != chainsStorage.end());
+    chainsStorage.erase(segmentIt);
+  }
+}
+
 void Core::mergeSegments(IBlockchainCache* acceptingSegment, IBlockchainCache* segment) {
   assert(segment->getStartBlockIndex() == acceptingSegment->getStartBlockIndex() + acceptingSegment->getBlockCount());
 
@@ -2040,6 +2345,11 @@ BlockDetails Core::getBlockDetails(const uint32_t blockHeight) const {
 BlockDetails Core::getBlockDetails(const Crypto::Hash& blockHash) const {
   throwIfNotInitialized();
 
+  BlockDetails blockDetails;
+  if (explorerCache.getBlock(blockHash, blockDetails)) {
+    return blockDetails;
+  }
+
   IBlockchainCache* segment = findSegmentContainingBlock(blockHash);
   if (segment == nullptr) {
     throw std::runtime_error("Requested hash wasn't found in blockchain.");
@@ -2048,7 +2358,6 @@ BlockDetails Core::getBlockDetails(const Crypto::Hash& blockHash) const {
   uint32_t blockIndex = segment->getBlockIndex(blockHash);
   BlockTemplate blockTemplate = restoreBlockTemplate(segment, blockIndex);
 
-  BlockDetails blockDetails;
   blockDetails.majorVersion = blockTemplate.majorVersion;
   blockDetails.minorVersion = blockTemplate.minorVersion;
   blockDetails.timestamp = blockTemplate.timestamp;
@@ -2112,19 +2421,33 @@ BlockDetails Core::getBlockDetails(const Crypto::Hash& blockHash) const {
     blockDetails.totalFeeAmount += blockDetails.transactions.back().fee;
   }
 
+  if (!blockDetails.isAlternative && isBlockBuried(blockIndex)) {
+    explorerCache.addBlock(blockDetails);
+  }
+
   return blockDetails;
 }
 
 TransactionDetails Core::getTransactionDetails(const Crypto::Hash& transactionHash) const {
   throwIfNotInitialized();
 
+  TransactionDetails transactionDetails;
+  if (explorerCache.getTransaction(transactionHash, transactionDetails)) {
+    return transactionDetails;
+  }
+
   IBlockchainCache* segment = findSegmentContainingTransaction(transactionHash);
   bool foundInPool = transactionPool->checkIfTransactionPresent(transactionHash);
   if (segment == nullptr && !foundInPool) {
     throw std::runtime_error("Requested transaction wasn't found.");
   }
 
-  return getTransactionDetails(transactionHash, segment, foundInPool);
+  transactionDetails = getTransactionDetails(transactionHash, segment, foundInPool);
+  if (!foundInPool && mainChainSet.count(segment) != 0 && isBlockBuried(transactionDetails.blockIndex)) {
+    explorerCache.addTransaction(transactionDetails);
+  }
+
+  return transactionDetails;
 }
 
 TransactionDetails Core::getTransactionDetails(const Crypto::Hash& transactionHash, IBlockchainCache* segment, bool foundInPool) const {
@@ -2253,6 +2576,11 @@ TransactionDetails Core::getTransactionDetails(const Crypto::Hash& transactionHa
   return transactionDetails;
 }
 
+// blocks below the memory segments are only replaced by a deep chain switch, which drops them from the explorer cache
+bool Core::isBlockBuried(uint32_t blockIndex) const {
+  return static_cast<uint64_t>(blockIndex) + memorySegmentDepth <= chainsLeaves[0]->getTopBlockIndex();
+}
+
 std::vector<Crypto::Hash> Core::getAlternativeBlockHashesByIndex(uint32_t blockIndex) const {
   throwIfNotInitialized();
 
@@ -2361,6 +2689,7 @@ void Core::transactionPoolCleaningProcedure() {
       timer.sleep(OUTDATED_TRANSACTION_POLLING_INTERVAL);
 
       auto deletedTransactions = transactionPool->clean(getTopBlockIndex());
+      updatePoolTransactionCount();
       notifyObservers(makeDelTransactionMessage(std::move(deletedTransactions), Messages::DeleteTransaction::Reason::Outdated));
     }
   } catch (System::InterruptedException&) {
@@ -2370,6 +2699,47 @@ void Core::transactionPoolCleaningProcedure() {
   }
 }
 
+void Core::resetChainStatus() {
+  std::atomic_store(&chainStatus, std::shared_ptr<const ChainStatus>());
+}
+
+std::shared_ptr<const ChainStatus> Core::buildChainStatus() const {
+  IBlockchainCache* mainChain = chainsLeaves[0];
+  uint32_t topBlockIndex = mainChain->getTopBlockIndex();
+
+  std::shared_ptr<ChainStatus> status = std::make_shared<ChainStatus>();
+  status->topBlockIndex = topBlockIndex;
+  status->topBlockHash = mainChain->getTopBlockHash();
+  status->topBlock = restoreBlockTemplate(mainChain, topBlockIndex);
+  status->blockTransactionCount = static_cast<uint32_t>(status->topBlock.transactionHashes.size() + 1);
+
+  // the same as BlockDetails::blockSize
+  uint64_t transactionsSize = mainChain->getLastBlocksSizes(1, topBlockIndex, addGenesisBlock).front();
+  status->blockSize = getObjectBinarySize(status->topBlock) + transactionsSize - getObjectBinarySize(status->topBlock.baseTransaction);
+
+  status->blockDifficulty = getBlockDifficulty(topBlockIndex);
+  status->cumulativeDifficulty = mainChain->getCurrentCumulativeDifficulty();
+  status->difficulty = getDifficultyForNextBlock();
+  status->transactionCount = mainChain->getTransactionCount();
+  status->poolTransactionCount = transactionPool->getTransactionCount();
+  status->alternativeBlockCount = getAlternativeBlockCount();
+  status->blockMedianSize = blockMedianSize;
+
+  return status;
+}
+
+void Core::updatePoolTransactionCount() {
+  auto currentStatus = std::atomic_load(&chainStatus);
+  if (!currentStatus) {
+    return;
+  }
+
+  std::shared_ptr<ChainStatus> status = std::make_shared<ChainStatus>(*currentStatus);
+  status->poolTransactionCount = transactionPool->getTransactionCount();
+
+  std::atomic_store(&chainStatus, std::shared_ptr<const ChainStatus>(std::move(status)));
+}
+
 void Core::updateBlockMedianSize() {
   auto mainChain = chainsLeaves[0];
 
@@ -2380,6 +2750,30 @@ void Core::updateBlockMedianSize() {
   blockMedianSize = std::max(Common::medianValue(lastBlockSizes), static_cast<uint64_t>(nextBlockGrantedFullRewardZone));
 }
 
+std::shared_ptr<const ChainStatus> Core::getChainStatus() const {
+  throwIfNotInitialized();
+
+  auto status = std::atomic_load(&chainStatus);
+  if (!status) {
+    status = buildChainStatus();
+    std::atomic_store(&chainStatus, status);
+  }
+
+  return status;
+}
+
+void Core::setExplorerCacheSize(size_t maxSize) {
+  explorerCache.setMaxSize(maxSize);
+}
+
+void Core::setMemorySegmentDepth(uint32_t depth) {
+  memorySegmentDepth = depth;
+}
+
+ExplorerDetailsCache::Statistics Core::getExplorerCacheStatistics() const {
+  return explorerCache.getStatistics();
+}
+
 uint64_t Core::get_current_blockchain_height() const
 {
   // TODO: remove when GetCoreStatistics is implemented
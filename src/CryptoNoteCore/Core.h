@@ -5,6 +5,7 @@
 
 #pragma once
 #include <ctime>
+#include <memory>
 #include <vector>
 #include <unordered_map>
 #include "BlockchainCache.h"
@@ -12,6 +13,7 @@
 #include "CachedBlock.h"
 #include "CachedTransaction.h"
 #include "Currency.h"
+#include "ExplorerDetailsCache.h"
 #include "Checkpoints.h"
 #include "IBlockchainCache.h"
 #include "IBlockchainCacheFactory.h"
@@ -24,12 +26,32 @@
 #include <Logging/LoggerMessage.h>
 #include "MessageQueue.h"
 #include "TransactionValidatiorState.h"
+#include "TransactionView.h"
 #include "SwappedVector.h"
 
 #include <System/ContextGroup.h>
 
 namespace CryptoNote {
 
+// The state of the main chain which the RPC status calls report. Core drops it whenever the top block or the
+// alternative blocks change and builds a new one on the next request, readers keep the one they got.
+struct ChainStatus {
+  uint32_t topBlockIndex;
+  Crypto::Hash topBlockHash;
+  BlockTemplate topBlock;
+  // in the top block, the base transaction included
+  uint32_t blockTransactionCount;
+  uint64_t blockSize;
+  uint64_t blockDifficulty;
+  uint64_t cumulativeDifficulty;
+  // of the next block
+  uint64_t difficulty;
+  size_t transactionCount;
+  size_t poolTransactionCount;
+  size_t alternativeBlockCount;
+  size_t blockMedianSize;
+};
+
 class Core : public ICore, public ICoreInformation {
 public:
   Core(const Currency& currency, Logging::ILogger& logger, Checkpoints&& checkpoints, System::Dispatcher& dispatcher,
@@ -72,6 +94,8 @@ public:
 
   virtual bool getTransactionGlobalIndexes(const Crypto::Hash& transactionHash, std::vector<uint32_t>& globalIndexes) const override;
   virtual bool getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes, std::vector<Crypto::PublicKey>& publicKeys) const override;
+  virtual bool getRandomOutputs(const std::vector<uint64_t>& amounts, uint16_t count, std::vector<std::vector<uint32_t>>& globalIndexes,
+    std::vector<std::vector<Crypto::PublicKey>>& publicKeys) const override;
 
   virtual bool addTransactionToPool(const BinaryArray& transactionBinaryArray) override;
 
@@ -80,6 +104,8 @@ public:
     std::vector<Crypto::Hash>& deletedTransactions) const override;
   virtual bool getPoolChangesLite(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes, std::vector<TransactionPrefixInfo>& addedTransactions,
     std::vector<Crypto::Hash>& deletedTransactions) const override;
+  virtual bool getPoolChangesSince(const Crypto::Hash& lastBlockHash, uint64_t sequenceNumber, std::vector<TransactionPrefixInfo>& addedTransactions,
+    std::vector<Crypto::Hash>& deletedTransactions, uint64_t& currentSequenceNumber, bool& isSequenceActual) const override;
 
   virtual bool getBlockTemplate(BlockTemplate& b, const AccountPublicAddress& adr, const BinaryArray& extraNonce, uint64_t& difficulty, uint32_t& height) const override;
 
@@ -109,6 +135,12 @@ public:
 
   virtual uint64_t get_current_blockchain_height() const;
 
+  std::shared_ptr<const ChainStatus> getChainStatus() const;
+
+  void setExplorerCacheSize(size_t maxSize);
+  void setMemorySegmentDepth(uint32_t depth);
+  ExplorerDetailsCache::Statistics getExplorerCacheStatistics() const;
+
 private:
   const Currency& currency;
   System::Dispatcher& dispatcher;
@@ -131,11 +163,18 @@ private:
   time_t start_time;
 
   size_t blockMedianSize;
+  mutable std::shared_ptr<const ChainStatus> chainStatus;
+  // details of the main chain blocks below the memory segments and of their transactions
+  mutable ExplorerDetailsCache explorerCache;
+  // main chain blocks kept in memory above the database, 0 if they are written to it straight away
+  uint32_t memorySegmentDepth;
 
   void throwIfNotInitialized() const;
-  bool extractTransactions(const std::vector<BinaryArray>& rawTransactions, std::vector<CachedTransaction>& transactions, uint64_t& cumulativeSize);
+  // parallel lets a big block be parsed by several threads, callers already running in parallel pass false
+  bool extractTransactions(const std::vector<BinaryArray>& rawTransactions, std::vector<CachedTransaction>& transactions, uint64_t& cumulativeSize,
+                           bool parallel = true);
 
-  std::error_code validateSemantic(const Transaction& transaction, uint64_t& fee, uint32_t blockIndex);
+  std::error_code validateSemantic(const TransactionView& transaction, uint64_t& fee, uint32_t blockIndex);
   std::error_code validateTransaction(const CachedTransaction& transaction, TransactionValidatorState& state, IBlockchainCache* cache, uint64_t& fee, uint32_t blockIndex);
 
   uint32_t findBlockchainSupplement(const std::vector<Crypto::Hash>& remoteBlockIds) const;
@@ -167,29 +206,38 @@ private:
   void fillQueryBlockShortInfo(uint32_t fullOffset, uint32_t currentIndex, size_t maxItemsCount, std::vector<BlockShortInfo>& entries) const;
 
   void getTransactionPoolDifference(const std::vector<Crypto::Hash>& knownHashes, std::vector<Crypto::Hash>& newTransactions, std::vector<Crypto::Hash>& deletedTransactions) const;
+  void getPoolTransactionPrefixes(const std::vector<Crypto::Hash>& transactionHashes, std::vector<TransactionPrefixInfo>& transactionPrefixes) const;
 
   uint8_t getBlockMajorVersionForHeight(uint32_t height) const;
   size_t calculateCumulativeBlocksizeLimit(uint32_t height) const;
   void fillBlockTemplate(BlockTemplate& block, size_t medianSize, size_t maxCumulativeSize, size_t& transactionsSize, uint64_t& fee) const;
   void deleteAlternativeChains();
+  void deleteAlternativeChildren(IBlockchainCache* segment);
   void deleteLeaf(size_t leafIndex);
+  void commitBuriedSegments();
   void mergeMainChainSegments();
   void mergeSegments(IBlockchainCache* acceptingSegment, IBlockchainCache* segment);
   TransactionDetails getTransactionDetails(const Crypto::Hash& transactionHash, IBlockchainCache* segment, bool foundInPool) const;
+  bool isBlockBuried(uint32_t blockIndex) const;
   void notifyOnSuccess(error::AddBlockErrorCode opResult, uint32_t previousBlockIndex, const CachedBlock& cachedBlock,
                        const IBlockchainCache& cache);
   void copyTransactionsToPool(IBlockchainCache* alt);
 
-  void actualizePoolTransactions();
+  void actualizePoolTransactions(uint32_t splitBlockIndex, uint32_t previousTopBlockIndex); //Revalidates pool txs affected by the chain switch.
   void actualizePoolTransactionsLite(const TransactionValidatorState& validatorState); //Checks pool txs only for double spend.
 
   void transactionPoolCleaningProcedure();
   void updateBlockMedianSize();
+  void resetChainStatus();
+  std::shared_ptr<const ChainStatus> buildChainStatus() const;
+  void updatePoolTransactionCount();
   bool addTransactionToPool(CachedTransaction&& cachedTransaction);
   bool isTransactionValidForPool(const CachedTransaction& cachedTransaction, TransactionValidatorState& validatorState);
 
   void initRootSegment();
   void importBlocksFromStorage();
+  struct ImportedBlock;
+  std::vector<ImportedBlock> prepareImportedBlocks(uint32_t startIndex, std::vector<RawBlock> rawBlocks);
   void cutSegment(IBlockchainCache& segment, uint32_t startIndex);
 
   void switchMainChainStorage(uint32_t splitBlockIndex, IBlockchainCache& newChain);
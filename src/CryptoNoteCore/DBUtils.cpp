@@ -17,30 +17,30 @@
 
 #include "DBUtils.h"
 
-namespace {
-  const std::string RAW_BLOCK_NAME = "raw_block";
-  const std::string RAW_TXS_NAME = "raw_txs";
-}
-
 namespace CryptoNote {
 namespace DB {
-  std::string serialize(const RawBlock& value, const std::string& name) {
-    std::stringstream ss;
-    Common::StdOutputStream stream(ss);
-    CryptoNote::BinaryOutputStreamSerializer serializer(stream);
-    
-    serializer(const_cast<RawBlock&>(value).block, RAW_BLOCK_NAME);
-    serializer(const_cast<RawBlock&>(value).transactions, RAW_TXS_NAME);
+  void appendKey(std::string& key, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+      key.push_back(static_cast<char>(value >> shift));
+    }
+  }
+
+  void appendKey(std::string& key, uint64_t value) {
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      key.push_back(static_cast<char>(value >> shift));
+    }
+  }
+
+  void appendKey(std::string& key, const Crypto::Hash& value) {
+    key.append(reinterpret_cast<const char*>(value.data), sizeof(value.data));
+  }
 
-    return ss.str();
+  void appendKey(std::string& key, const Crypto::KeyImage& value) {
+    key.append(reinterpret_cast<const char*>(value.data), sizeof(value.data));
   }
 
-  void deserialize(const std::string& serialized, RawBlock& value, const std::string& name) {
-    std::stringstream ss(serialized);
-    Common::StdInputStream stream(ss);
-    CryptoNote::BinaryInputStreamSerializer serializer(stream);
-    serializer(value.block, RAW_BLOCK_NAME);
-    serializer(value.transactions, RAW_TXS_NAME);
+  void appendKey(std::string& key, const std::string& value) {
+    key.append(value);
   }
 }
 }
@@ -18,22 +18,20 @@
 #pragma once
 
 #include <string>
-#include <sstream>
 
-#include "Common/StdOutputStream.h"
-#include "Serialization/KVBinaryOutputStreamSerializer.h"
+#include "Common/MemoryInputStream.h"
+#include "Common/StringOutputStream.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
 #include "Serialization/SerializationOverloads.h"
 #include "CryptoNoteCore/CryptoNoteFormatUtils.h"
 #include "CryptoNoteCore/CryptoNoteSerialization.h"
-#include "Common/StdInputStream.h"
-#include "Serialization/KVBinaryInputStreamSerializer.h"
 
 namespace CryptoNote {
 namespace DB {
   const std::string BLOCK_INDEX_TO_KEY_IMAGE_PREFIX = "0";
   const std::string BLOCK_INDEX_TO_TX_HASHES_PREFIX = "1";
   const std::string BLOCK_INDEX_TO_TRANSACTION_INFO_PREFIX = "2";
-  const std::string BLOCK_INDEX_TO_RAW_BLOCK_PREFIX = "4";
 
   const std::string BLOCK_HASH_TO_BLOCK_INDEX_PREFIX = "5";
   const std::string BLOCK_INDEX_TO_BLOCK_INFO_PREFIX = "6";
@@ -61,40 +59,52 @@ namespace DB {
 
   const std::string KEY_OUTPUT_KEY_PREFIX = "j";
 
-  template <class Value>
-  std::string serialize(const Value& value, const std::string& name) {
-    CryptoNote::KVBinaryOutputStreamSerializer serializer;
-    std::stringstream ss;
-    Common::StdOutputStream stream(ss);
+  const std::string BLOCK_INDEX_TO_UNDO_INFO_PREFIX = "k";
 
-    serializer(const_cast<Value&>(value), name);
-    serializer.dump(stream);
+  // Keys are the prefix followed by the key in fixed width with integers big-endian, so the keys
+  // of a prefix sort by block index, timestamp, amount and global index
+  void appendKey(std::string& key, uint32_t value);
+  void appendKey(std::string& key, uint64_t value);
+  void appendKey(std::string& key, const Crypto::Hash& value);
+  void appendKey(std::string& key, const Crypto::KeyImage& value);
+  void appendKey(std::string& key, const std::string& value);
 
-    return ss.str();
+  template <class First, class Second>
+  void appendKey(std::string& key, const std::pair<First, Second>& value) {
+    appendKey(key, value.first);
+    appendKey(key, value.second);
   }
 
-  std::string serialize(const RawBlock& value, const std::string& name);
+  // Values are stored in the packed binary format, without field names
+  template <class Value>
+  std::string serialize(const Value& value, const std::string& name) {
+    std::string serialized;
+    Common::StringOutputStream stream(serialized);
+    CryptoNote::BinaryOutputStreamSerializer serializer(stream);
+    serializer(const_cast<Value&>(value), name);
 
-  template <class Key, class Value>
-  std::pair<std::string, std::string> serialize(const std::string& keyPrefix, const Key& key, const Value& value) {
-    return{ DB::serialize(std::make_pair(keyPrefix, key), keyPrefix), DB::serialize(value, keyPrefix) };
+    return serialized;
   }
 
   template <class Key>
   std::string serializeKey(const std::string& keyPrefix, const Key& key) {
-    return DB::serialize(std::make_pair(keyPrefix, key), keyPrefix);
+    std::string serializedKey(keyPrefix);
+    appendKey(serializedKey, key);
+    return serializedKey;
+  }
+
+  template <class Key, class Value>
+  std::pair<std::string, std::string> serialize(const std::string& keyPrefix, const Key& key, const Value& value) {
+    return{ DB::serializeKey(keyPrefix, key), DB::serialize(value, keyPrefix) };
   }
 
   template <class Value>
   void deserialize(const std::string& serialized, Value& value, const std::string& name) {
-    std::stringstream ss(serialized);
-    Common::StdInputStream stream(ss);
-    CryptoNote::KVBinaryInputStreamSerializer serializer(stream);
+    Common::MemoryInputStream stream(serialized.data(), serialized.size());
+    CryptoNote::BinaryInputStreamSerializer serializer(stream);
     serializer(value, name);
   }
 
-  void deserialize(const std::string& serialized, RawBlock& value, const std::string& name);
-
   template <class Key, class Value>
   void serializeKeys(std::vector<std::string>& rawKeys, const std::string keyPrefix, const std::unordered_map<Key, Value>& map) {
     for (const std::pair<Key, Value>& kv : map) {
@@ -40,6 +40,7 @@ const command_line::arg_descriptor<uint16_t>    argBackgroundThreadsCount = { "d
 const command_line::arg_descriptor<uint32_t>    argMaxOpenFiles = { "db-max-open-files", "Number of open files that can be used by the DB", DEFAULT_MAX_OPEN_FILES};
 const command_line::arg_descriptor<uint64_t>    argWriteBufferSize = { "db-write-buffer-size", "Size of data base write buffer in megabytes", WRITE_BUFFER_MB_DEFAULT_SIZE};
 const command_line::arg_descriptor<uint64_t>    argReadCacheSize = { "db-read-cache-size", "Size of data base read cache in megabytes", READ_BUFFER_MB_DEFAULT_SIZE};
+const command_line::arg_descriptor<bool>        argBulkLoad = { "db-bulk-load", "Collect the chain below the last checkpoint in memory and ingest it into the data base as table files. Data collected but not ingested is lost on a crash" };
 
 } //namespace
 
@@ -48,6 +49,7 @@ void DataBaseConfig::initOptions(boost::program_options::options_description& de
   command_line::add_arg(desc, argMaxOpenFiles);
   command_line::add_arg(desc, argWriteBufferSize);
   command_line::add_arg(desc, argReadCacheSize);
+  command_line::add_arg(desc, argBulkLoad);
 }
 
 DataBaseConfig::DataBaseConfig() :
@@ -56,6 +58,7 @@ DataBaseConfig::DataBaseConfig() :
   maxOpenFiles(DEFAULT_MAX_OPEN_FILES),
   writeBufferSize(WRITE_BUFFER_MB_DEFAULT_SIZE * MEGABYTE),
   readCacheSize(READ_BUFFER_MB_DEFAULT_SIZE * MEGABYTE),
+  bulkLoad(false),
   testnet(false) {
 }
 
@@ -76,6 +79,10 @@ bool DataBaseConfig::init(const boost::program_options::variables_map& vm) {
     readCacheSize = command_line::get_arg(vm, argReadCacheSize) * MEGABYTE;
   }
 
+  if (vm.count(argBulkLoad.name) != 0 && !vm[argBulkLoad.name].defaulted()) {
+    bulkLoad = command_line::get_arg(vm, argBulkLoad);
+  }
+
   if (vm.count(command_line::arg_data_dir.name) != 0 && (!vm[command_line::arg_data_dir.name].defaulted() || dataDir == Tools::getDefaultDataDirectory())) {
     dataDir = command_line::get_arg(vm, command_line::arg_data_dir);
   }
@@ -109,6 +116,10 @@ uint64_t DataBaseConfig::getReadCacheSize() const {
   return readCacheSize;
 }
 
+bool DataBaseConfig::getBulkLoad() const {
+  return bulkLoad;
+}
+
 bool DataBaseConfig::getTestnet() const {
   return testnet;
 }
@@ -137,6 +148,10 @@ void DataBaseConfig::setReadCacheSize(uint64_t readCacheSize) {
   this->readCacheSize = readCacheSize;
 }
 
+void DataBaseConfig::setBulkLoad(bool bulkLoad) {
+  this->bulkLoad = bulkLoad;
+}
+
 void DataBaseConfig::setTestnet(bool testnet) {
   this->testnet = testnet;
 }
@@ -37,6 +37,7 @@ public:
   uint32_t getMaxOpenFiles() const;
   uint64_t getWriteBufferSize() const; //Bytes
   uint64_t getReadCacheSize() const; //Bytes
+  bool getBulkLoad() const;
   bool getTestnet() const;
 
   void setConfigFolderDefaulted(bool defaulted);
@@ -45,6 +46,7 @@ public:
   void setMaxOpenFiles(uint32_t maxOpenFiles);
   void setWriteBufferSize(uint64_t writeBufferSize); //Bytes
   void setReadCacheSize(uint64_t readCacheSize); //Bytes
+  void setBulkLoad(bool bulkLoad);
   void setTestnet(bool testnet);
 
 private:
@@ -54,6 +56,7 @@ private:
   uint32_t maxOpenFiles;
   uint64_t writeBufferSize;
   uint64_t readCacheSize;
+  bool bulkLoad;
   bool testnet;
 };
 } //namespace CryptoNote
@@ -8,10 +8,13 @@
 
 #include <ctime>
 #include <cstdlib>
+#include <fstream>
 
 #include <boost/iterator/iterator_facade.hpp>
 
 #include <Common/ShuffleGenerator.h>
+#include <Common/StdInputStream.h>
+#include <Common/StdOutputStream.h>
 
 #include "BlockchainUtils.h"
 
@@ -21,6 +24,9 @@
 #include <CryptoNoteCore/CryptoNoteTools.h>
 #include <CryptoNoteCore/CryptoNoteBasicImpl.h>
 #include "CryptoNoteCore/TransactionExtra.h"
+#include "Serialization/BinaryInputStreamSerializer.h"
+#include "Serialization/BinaryOutputStreamSerializer.h"
+#include "Serialization/SerializationOverloads.h"
 
 namespace CryptoNote {
 
@@ -55,37 +61,6 @@ bool requestPackedOutputs(IBlockchainCache::Amount amount, Common::ArrayView<uin
   return true;
 }
 
-bool requestTransactionHashesForGlobalOutputIndexes(const std::vector<PackedOutIndex>& packedOuts, IDataBase& database, std::vector<Crypto::Hash>& transactionHashes) {
-  BlockchainReadBatch readHashesBatch;
-
-  std::set<uint32_t> blockIndexes;
-  std::for_each(packedOuts.begin(), packedOuts.end(), [&blockIndexes] (PackedOutIndex out) { blockIndexes.insert(out.blockIndex); });
-  std::for_each(blockIndexes.begin(), blockIndexes.end(), [&readHashesBatch] (uint32_t blockIndex) { readHashesBatch.requestTransactionHashesByBlock(blockIndex); });
-
-  auto dbResult = database.read(readHashesBatch);
-  if (dbResult) {
-    return false;
-  }
-
-  auto readResult = readHashesBatch.extractResult();
-  const auto& transactionHashesMap = readResult.getTransactionHashesByBlocks();
-
-  if (transactionHashesMap.size() != blockIndexes.size()) {
-    return false;
-  }
-
-  transactionHashes.reserve(transactionHashes.size() + packedOuts.size());
-  for (const auto& output: packedOuts) {
-    if (output.transactionIndex >= transactionHashesMap.at(output.blockIndex).size()) {
-      return false;
-    }
-
-    transactionHashes.push_back(transactionHashesMap.at(output.blockIndex)[output.transactionIndex]);
-  }
-
-  return true;
-}
-
 bool requestCachedTransactionInfos(const std::vector<Crypto::Hash>& transactionHashes, IDataBase& database, std::vector<CachedTransactionInfo>& result) {
   result.reserve(result.size() + transactionHashes.size());
 
@@ -146,16 +121,6 @@ bool requestExtendedTransactionInfos(const std::vector<Crypto::Hash>& transactio
   return true;
 }
 
-//returns ExtendedTransactionInfos in the same order as packedOuts are
-bool requestExtendedTransactionInfos(const std::vector<PackedOutIndex>& packedOuts, IDataBase& database, std::vector<ExtendedTransactionInfo>& result) {
-  std::vector<Crypto::Hash> transactionHashes;
-  if (!requestTransactionHashesForGlobalOutputIndexes(packedOuts, database, transactionHashes)) {
-    return false;
-  }
-
-  return requestExtendedTransactionInfos(transactionHashes, database, result);
-}
-
 uint64_t roundToMidnight(uint64_t timestamp) {
   if (timestamp > static_cast<uint64_t>(std::numeric_limits<time_t>::max())) {
     throw std::runtime_error("Timestamp is too big");
@@ -183,24 +148,6 @@ std::pair<boost::optional<uint32_t>, bool> requestClosestBlockIndexByTimestamp(u
   return result;
 }
 
-bool requestRawBlock(IDataBase& database, uint32_t blockIndex, RawBlock& block) {
-  auto batch = BlockchainReadBatch().requestRawBlock(blockIndex);
-
-  auto error = database.read(batch);
-  if (error) {
-    //may be throw in all similiar functions???
-    return false;
-  }
-
-  auto result = batch.extractResult();
-  if (result.getRawBlocks().count(blockIndex) == 0) {
-    return false;
-  }
-
-  block = result.getRawBlocks().at(blockIndex);
-  return true;
-}
-
 Transaction extractTransaction(const RawBlock& block, uint32_t transactionIndex) {
   assert(transactionIndex < block.transactions.size() + 1);
 
@@ -236,7 +183,7 @@ size_t requestPaymentIdTransactionsCount(IDataBase& database, const Crypto::Hash
   return result.getTransactionCountByPaymentIds().at(paymentId);
 }
 
-bool requestPaymentId(IDataBase& database, const Crypto::Hash& transactionHash, Crypto::Hash& paymentId) {
+bool requestPaymentId(IDataBase& database, const IMainChainStorage& mainChainStorage, const Crypto::Hash& transactionHash, Crypto::Hash& paymentId) {
   std::vector<CachedTransactionInfo> cachedTransactions;
 
   if (!requestCachedTransactionInfos({transactionHash}, database, cachedTransactions)) {
@@ -247,11 +194,11 @@ bool requestPaymentId(IDataBase& database, const Crypto::Hash& transactionHash,
     return false;
   }
 
-  RawBlock block;
-  if (!requestRawBlock(database, cachedTransactions[0].blockIndex, block)) {
+  if (cachedTransactions[0].blockIndex >= mainChainStorage.getBlockCount()) {
     return false;
   }
 
+  RawBlock block = mainChainStorage.getBlockByIndex(cachedTransactions[0].blockIndex);
   Transaction transaction = extractTransaction(block, cachedTransactions[0].transactionIndex);
   return getPaymentIdFromTxExtra(transaction.extra, paymentId);
 }
@@ -360,7 +307,8 @@ void mergeOutputsSplitBoundaries(std::map<IBlockchainCache::Amount, IBlockchainC
   }
 }
 
-void cutTail(std::deque<CachedBlockInfo>& cache, size_t count) {
+template <class T>
+void cutTail(std::deque<T>& cache, size_t count) {
   if (count >= cache.size()) {
     cache.clear();
     return;
@@ -415,18 +363,55 @@ private:
   uint32_t schemeVersion;
 };
 
-const uint32_t CURRENT_DB_SCHEME_VERSION = 2;
+const uint32_t CURRENT_DB_SCHEME_VERSION = 3;
+
+// bump whenever CacheSnapshot changes, an older snapshot is then ignored
+const uint32_t CACHE_SNAPSHOT_VERSION = 1;
 
 }
 
 struct DatabaseBlockchainCache::ExtendedPushedBlockInfo {
   PushedBlockInfo pushedBlockInfo;
+  bool hasRawBlock;
+  Crypto::Hash blockHash;
   uint64_t timestamp;
 };
 
+// Everything the cache otherwise reads back from the database lazily after a restart
+struct DatabaseBlockchainCache::CacheSnapshot {
+  uint32_t version;
+  uint32_t topBlockIndex;
+  Crypto::Hash topBlockHash;
+  uint64_t transactionsCount;
+  bool hasKeyOutputAmountsCount;
+  uint32_t keyOutputAmountsCount;
+  std::unordered_map<Amount, int32_t> keyOutputCountsForAmounts;
+  std::vector<CachedBlockInfo> units;
+  std::vector<std::map<Amount, std::pair<GlobalOutputIndex, uint32_t>>> recentKeyOutputs;
 
-DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase& dataBase, IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& _logger)
-    : currency(curr), database(dataBase), blockchainCacheFactory(blockchainCacheFactory), logger(_logger, "DatabaseBlockchainCache") {
+  void serialize(ISerializer& s) {
+    s(version, "version");
+    if (version != CACHE_SNAPSHOT_VERSION) {
+      return;
+    }
+
+    s(topBlockIndex, "top_block_index");
+    s(topBlockHash, "top_block_hash");
+    s(transactionsCount, "transactions_count");
+    s(hasKeyOutputAmountsCount, "has_key_output_amounts_count");
+    s(keyOutputAmountsCount, "key_output_amounts_count");
+    s(keyOutputCountsForAmounts, "key_output_counts_for_amounts");
+    s(units, "units");
+    s(recentKeyOutputs, "recent_key_outputs");
+  }
+};
+
+
+DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase& dataBase, const IMainChainStorage& mainChainStorage,
+                                                 IBlockchainCacheFactory& blockchainCacheFactory, const std::string& snapshotFilename,
+                                                 Logging::ILogger& _logger)
+    : currency(curr), database(dataBase), mainChainStorage(mainChainStorage), blockchainCacheFactory(blockchainCacheFactory),
+      snapshotFilename(snapshotFilename), logger(_logger, "DatabaseBlockchainCache") {
   DatabaseVersionReadBatch readBatch;
   auto ec = database.read(readBatch);
   if (ec) {
@@ -446,7 +431,9 @@ DatabaseBlockchainCache::DatabaseBlockchainCache(const Currency& curr, IDataBase
     logger(Logging::DEBUGGING) << "Current db scheme version: " << *version;
   }
 
-  if (getTopBlockIndex() == 0) {
+  //top block index 0 is also a database holding just the genesis block
+  auto lastBlockIndexBatch = BlockchainReadBatch().requestLastBlockIndex();
+  if (!readDatabase(lastBlockIndexBatch).getLastBlockIndex().second) {
     logger(Logging::DEBUGGING) << "top block index is nill, add genesis block";
     addGenesisBlock(CachedBlock (currency.genesisBlock()));
   }
@@ -515,65 +502,124 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
   logger(Logging::DEBUGGING) << "split at index " << splitBlockIndex << " started, top block index: " << getTopBlockIndex();
 
   auto cache = blockchainCacheFactory.createBlockchainCache(currency, this, splitBlockIndex);
+  auto currentTop = getTopBlockIndex();
+
+  // everything read for the blocks being moved and deleted is read at once
+  BlockchainReadBatch readBatch;
+  if (splitBlockIndex > 0) {
+    readBatch.requestCachedBlock(splitBlockIndex - 1);
+  }
+
+  for (uint32_t blockIndex = splitBlockIndex; blockIndex <= currentTop; ++blockIndex) {
+    readBatch.requestCachedBlock(blockIndex)
+      .requestSpentKeyImagesByBlock(blockIndex)
+      .requestTransactionHashesByBlock(blockIndex)
+      .requestBlockUndoInfo(blockIndex);
+  }
+
+  auto readResult = readDatabase(readBatch);
+  const auto& undoInfos = readResult.getBlockUndoInfos();
 
   using DeleteBlockInfo = std::tuple<uint32_t, Crypto::Hash, TransactionValidatorState, uint64_t>;
   std::vector<DeleteBlockInfo> deletingBlocks;
 
-  BlockchainWriteBatch writeBatch;
-  auto currentTop = getTopBlockIndex();
+  bool movingBlocks = true;
   for (uint32_t blockIndex = splitBlockIndex; blockIndex <= currentTop; ++blockIndex) {
-    ExtendedPushedBlockInfo extendedInfo = getExtendedPushedBlockInfo(blockIndex);
+    ExtendedPushedBlockInfo extendedInfo = getExtendedPushedBlockInfo(blockIndex, readResult);
 
     auto validatorState = extendedInfo.pushedBlockInfo.validatorState;
-    logger(Logging::DEBUGGING) << "pushing block " << blockIndex << " to child segment";
-    auto blockHash = pushBlockToAnotherCache(*cache, std::move(extendedInfo.pushedBlockInfo));
+    if (movingBlocks) {
+      logger(Logging::DEBUGGING) << "pushing block " << blockIndex << " to child segment";
+      movingBlocks = extendedInfo.hasRawBlock && pushBlockToAnotherCache(*cache, extendedInfo.blockHash, std::move(extendedInfo.pushedBlockInfo));
+      if (!movingBlocks) {
+        // only happens when the core cuts the database down to the main chain storage on load
+        logger(Logging::WARNING) << "Block " << blockIndex << " is not in the main chain storage, it and the blocks above it are dropped";
+      }
+    }
 
-    deletingBlocks.emplace_back(blockIndex, blockHash, validatorState, extendedInfo.timestamp);
+    deletingBlocks.emplace_back(blockIndex, extendedInfo.blockHash, validatorState, extendedInfo.timestamp);
   }
 
-  for (auto it = deletingBlocks.rbegin(); it != deletingBlocks.rend(); ++it) {
-    auto blockIndex = std::get<0>(*it);
-    auto blockHash = std::get<1>(*it);
-    auto& validatorState = std::get<2>(*it);
-    uint64_t timestamp = std::get<3>(*it);
-
-    writeBatch.removeCachedBlock(blockHash, blockIndex).removeRawBlock(blockIndex);
-    requestDeleteSpentOutputs(writeBatch,
-                              blockIndex,
-                              validatorState);
-    requestRemoveTimestamp(writeBatch, timestamp, blockHash);
+  // Blocks pushed before undo records were written, and the genesis block, have to be deleted the slow way.
+  // They are below all the blocks having records, which are deleted from their records first.
+  uint32_t undoStartIndex = currentTop + 1;
+  while (undoStartIndex > splitBlockIndex && undoInfos.count(undoStartIndex - 1) != 0) {
+    --undoStartIndex;
   }
 
-  auto deletingTransactionHashes = requestTransactionHashesFromBlockIndex(splitBlockIndex);
-  requestDeleteTransactions(writeBatch, deletingTransactionHashes);
-  requestDeletePaymentIds(writeBatch, deletingTransactionHashes);
+  if (undoStartIndex <= currentTop) {
+    BlockchainWriteBatch writeBatch;
+    for (auto it = deletingBlocks.rbegin(); it != deletingBlocks.rend() && std::get<0>(*it) >= undoStartIndex; ++it) {
+      writeBatch.removeCachedBlock(std::get<1>(*it), std::get<0>(*it)).removeBlockUndoInfo(std::get<0>(*it));
+      requestDeleteSpentOutputs(writeBatch, std::get<0>(*it), std::get<2>(*it));
+    }
 
-  std::vector<ExtendedTransactionInfo> extendedTransactions;
-  if (!requestExtendedTransactionInfos(deletingTransactionHashes, database, extendedTransactions)) {
-    logger(Logging::ERROR) << "Error while split: failed to request extended transaction info";
-    throw std::runtime_error("failed to request extended transaction info"); //TODO: make error codes
-  }
+    requestUndoBlocks(writeBatch, undoStartIndex, readResult);
 
-  std::map<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex> keyIndexSplitBoundaries;
-  for (const auto& transaction: extendedTransactions) {
-    auto txkeyBoundaries = getMinGlobalIndexesByAmount(transaction.amountToKeyIndexes);
+    // the slow way below reads the database as it is without the blocks deleted here. It is consistent
+    // on its own, a crash before the rest is deleted leaves the blocks below them to be cut on load
+    logger(Logging::DEBUGGING) << "Performing delete operations of blocks " << undoStartIndex << " - " << currentTop;
+    auto err = database.write(writeBatch);
+    if (err) {
+      logger(Logging::ERROR) << "split write failed, " << err.message();
+      throw std::runtime_error(err.message());
+    }
 
-    mergeOutputsSplitBoundaries(keyIndexSplitBoundaries, txkeyBoundaries);
+    topBlockIndex = boost::none;
+    topBlockHash = boost::none;
   }
 
-  requestDeleteKeyOutputs(writeBatch, keyIndexSplitBoundaries);
+  if (splitBlockIndex < undoStartIndex) {
+    BlockchainWriteBatch writeBatch;
+    std::map<uint64_t, std::vector<Crypto::Hash>> deletingTimestamps;
+    for (auto it = deletingBlocks.rbegin(); it != deletingBlocks.rend(); ++it) {
+      auto blockIndex = std::get<0>(*it);
+      if (blockIndex >= undoStartIndex) {
+        continue;
+      }
 
-  deleteClosestTimestampBlockIndex(writeBatch, splitBlockIndex);
+      auto blockHash = std::get<1>(*it);
+      writeBatch.removeCachedBlock(blockHash, blockIndex).removeBlockUndoInfo(blockIndex);
+      requestDeleteSpentOutputs(writeBatch, blockIndex, std::get<2>(*it));
+      deletingTimestamps[std::get<3>(*it)].push_back(blockHash);
+    }
+
+    for (const auto& kv: deletingTimestamps) {
+      requestRemoveTimestamp(writeBatch, kv.first, kv.second);
+    }
+
+    auto deletingTransactionHashes = requestTransactionHashesFromBlockIndex(splitBlockIndex);
+    requestDeleteTransactions(writeBatch, deletingTransactionHashes);
+    requestDeletePaymentIds(writeBatch, deletingTransactionHashes);
+
+    std::vector<ExtendedTransactionInfo> extendedTransactions;
+    if (!requestExtendedTransactionInfos(deletingTransactionHashes, database, extendedTransactions)) {
+      logger(Logging::ERROR) << "Error while split: failed to request extended transaction info";
+      throw std::runtime_error("failed to request extended transaction info"); //TODO: make error codes
+    }
 
-  logger(Logging::DEBUGGING) << "Performing delete operations";
-  // all data and indexes are now copied, no errors detected, can now erase data from database
-  auto err = database.write(writeBatch);
-  if (err) {
-    logger(Logging::ERROR) << "split write failed, " << err.message();
-    throw std::runtime_error(err.message());
+    std::map<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex> keyIndexSplitBoundaries;
+    for (const auto& transaction: extendedTransactions) {
+      auto txkeyBoundaries = getMinGlobalIndexesByAmount(transaction.amountToKeyIndexes);
+
+      mergeOutputsSplitBoundaries(keyIndexSplitBoundaries, txkeyBoundaries);
+    }
+
+    requestDeleteKeyOutputs(writeBatch, keyIndexSplitBoundaries);
+
+    deleteClosestTimestampBlockIndex(writeBatch, splitBlockIndex);
+
+    logger(Logging::DEBUGGING) << "Performing delete operations of blocks " << splitBlockIndex << " - " << (undoStartIndex - 1);
+    // all data and indexes are now copied, no errors detected, can now erase data from database
+    auto err = database.write(writeBatch);
+    if (err) {
+      logger(Logging::ERROR) << "split write failed, " << err.message();
+      throw std::runtime_error(err.message());
+    }
   }
 
   cutTail(unitsCache, currentTop + 1 - splitBlockIndex);
+  cutTail(recentKeyOutputs, currentTop + 1 - splitBlockIndex);
 
   children.push_back(cache.get());
   logger(Logging::TRACE) << "Delete successfull";
@@ -588,19 +634,23 @@ std::unique_ptr<IBlockchainCache> DatabaseBlockchainCache::split(uint32_t splitB
   return cache;
 }
 
-//returns hash of pushed block
-Crypto::Hash DatabaseBlockchainCache::pushBlockToAnotherCache(IBlockchainCache& segment, PushedBlockInfo&& pushedBlockInfo) {
+//returns false without pushing if the raw block isn't the block with the given hash
+bool DatabaseBlockchainCache::pushBlockToAnotherCache(IBlockchainCache& segment, const Crypto::Hash& blockHash, PushedBlockInfo&& pushedBlockInfo) {
   BlockTemplate block;
-  bool br = fromBinaryArray(block, pushedBlockInfo.rawBlock.block);
-  if (br) {}
-  assert(br);
+  if (!fromBinaryArray(block, pushedBlockInfo.rawBlock.block)) {
+    return false;
+  }
+
+  CachedBlock cachedBlock(block);
+  if (cachedBlock.getBlockHash() != blockHash) {
+    return false;
+  }
 
   std::vector<CachedTransaction> transactions;
   bool tr = Utils::restoreCachedTransactions(pushedBlockInfo.rawBlock.transactions, transactions);
   if (tr) {}
   assert(tr);
 
-  CachedBlock cachedBlock(block);
   segment.pushBlock(cachedBlock,
                     transactions,
                     pushedBlockInfo.validatorState,
@@ -609,7 +659,7 @@ Crypto::Hash DatabaseBlockchainCache::pushBlockToAnotherCache(IBlockchainCache&
                     pushedBlockInfo.blockDifficulty,
                     std::move(pushedBlockInfo.rawBlock));
 
-  return cachedBlock.getBlockHash();
+  return true;
 }
 
 std::vector<Crypto::Hash> DatabaseBlockchainCache::requestTransactionHashesFromBlockIndex(uint32_t splitBlockIndex) {
@@ -645,7 +695,7 @@ void DatabaseBlockchainCache::requestDeletePaymentIds(BlockchainWriteBatch& writ
 
   for (const auto& hash: transactionHashes) {
     Crypto::Hash paymentId;
-    if (!requestPaymentId(database, hash, paymentId)) {
+    if (!requestPaymentId(database, mainChainStorage, hash, paymentId)) {
       continue;
     }
 
@@ -663,7 +713,10 @@ void DatabaseBlockchainCache::requestDeletePaymentId(BlockchainWriteBatch& write
   assert(count >= toDelete);
 
   logger(Logging::DEBUGGING) << "Deleting last " << toDelete << " transaction hashes of payment id " << paymentId;
-  writeBatch.removePaymentId(paymentId, static_cast<uint32_t>(count - toDelete));
+  //from the top, so the count written last is the one left
+  for (size_t index = count; index-- > count - toDelete;) {
+    writeBatch.removePaymentId(paymentId, static_cast<uint32_t>(index));
+  }
 }
 
 void DatabaseBlockchainCache::requestDeleteSpentOutputs(BlockchainWriteBatch& writeBatch, uint32_t blockIndex, const TransactionValidatorState& spentOutputs) {
@@ -690,10 +743,16 @@ void DatabaseBlockchainCache::requestDeleteKeyOutputs(BlockchainWriteBatch& writ
   std::unordered_map<IBlockchainCache::Amount, uint32_t> amountCounts = readDatabase(readBatch).getKeyOutputGlobalIndexesCountForAmounts();
   assert(amountCounts.size() == boundaries.size());
 
+  uint32_t removedAmountsCount = 0;
   for (const auto& kv: amountCounts) {
     auto it = boundaries.find(kv.first); //can't be equal end() since assert(amountCounts.size() == boundaries.size())
     requestDeleteKeyOutputsAmount(writeBatch, kv.first, it->second, kv.second);
+    if (it->second == 0) {
+      ++removedAmountsCount;
+    }
   }
+
+  requestRemoveKeyOutputAmounts(writeBatch, removedAmountsCount);
 }
 
 void DatabaseBlockchainCache::requestDeleteKeyOutputsAmount(BlockchainWriteBatch& writeBatch, IBlockchainCache::Amount amount,
@@ -709,7 +768,28 @@ void DatabaseBlockchainCache::requestDeleteKeyOutputsAmount(BlockchainWriteBatch
   updateKeyOutputCount(amount, boundary - outputsCount);
 }
 
-void DatabaseBlockchainCache::requestRemoveTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const Crypto::Hash& blockHash) {
+/*
+ * Amounts are listed in the order of their first outputs, so the ones whose first outputs were deleted are the last ones.
+ */
+void DatabaseBlockchainCache::requestRemoveKeyOutputAmounts(BlockchainWriteBatch& writeBatch, uint32_t removedAmountsCount) {
+  if (removedAmountsCount == 0) {
+    return;
+  }
+
+  if (!keyOutputAmountsCount) {
+    auto result = readDatabase(BlockchainReadBatch().requestKeyOutputAmountsCount());
+    keyOutputAmountsCount = result.getKeyOutputAmountsCount();
+  }
+
+  assert(*keyOutputAmountsCount >= removedAmountsCount);
+  keyOutputAmountsCount = *keyOutputAmountsCount - removedAmountsCount;
+
+  logger(Logging::DEBUGGING) << "Deleting last " << removedAmountsCount << " key output amounts";
+  writeBatch.removeKeyOutputAmounts(removedAmountsCount, *keyOutputAmountsCount);
+}
+
+//blockHashes are all the deleted blocks with the timestamp, the database doesn't see the batch until it is written
+void DatabaseBlockchainCache::requestRemoveTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const std::vector<Crypto::Hash>& blockHashes) {
   auto readBatch = BlockchainReadBatch().requestBlockHashesByTimestamp(timestamp);
   auto result = readDatabase(readBatch);
 
@@ -718,22 +798,96 @@ void DatabaseBlockchainCache::requestRemoveTimestamp(BlockchainWriteBatch& batch
   }
 
   auto indexes = result.getBlockHashesByTimestamp().at(timestamp);
-  auto it = std::find(indexes.begin(), indexes.end(), blockHash);
-  indexes.erase(it);
+  for (const auto& blockHash: blockHashes) {
+    auto it = std::find(indexes.begin(), indexes.end(), blockHash);
+    if (it != indexes.end()) {
+      indexes.erase(it);
+    }
+  }
 
   if (indexes.empty()) {
     logger(Logging::DEBUGGING) << "Deleting timestamp " << timestamp;
     batch.removeTimestamp(timestamp);
   } else {
-    logger(Logging::DEBUGGING) << "Deleting block hash " << blockHash << " from timestamp " << timestamp;
+    logger(Logging::DEBUGGING) << "Deleting " << blockHashes.size() << " block hashes from timestamp " << timestamp;
     batch.insertTimestamp(timestamp, indexes);
   }
 }
 
+/*
+ * Deletes what the blocks from splitBlockIndex to the top added to the shared indexes, using only their undo records.
+ * Blocks are visited from the top, so for keys touched by several of them the lowest block decides what is left.
+ */
+void DatabaseBlockchainCache::requestUndoBlocks(BlockchainWriteBatch& writeBatch, uint32_t splitBlockIndex, const BlockchainReadResult& undoReadResult) {
+  const auto& transactionHashesByBlocks = undoReadResult.getTransactionHashesByBlocks();
+  const auto& undoInfos = undoReadResult.getBlockUndoInfos();
+
+  // amount -> global indexes [first, second) to delete
+  std::map<IBlockchainCache::Amount, std::pair<IBlockchainCache::GlobalOutputIndex, IBlockchainCache::GlobalOutputIndex>> keyOutputRanges;
+  std::map<uint64_t, std::vector<Crypto::Hash>> restoredTimestamps;
+
+  auto currentTop = getTopBlockIndex();
+  for (uint32_t blockIndex = currentTop + 1; blockIndex-- > splitBlockIndex;) {
+    const BlockUndoInfo& undoInfo = undoInfos.at(blockIndex);
+
+    requestDeleteTransactions(writeBatch, transactionHashesByBlocks.at(blockIndex));
+
+    for (auto it = undoInfo.paymentIds.rbegin(); it != undoInfo.paymentIds.rend(); ++it) {
+      writeBatch.removePaymentId(it->first, it->second);
+    }
+
+    for (const auto& kv: undoInfo.keyOutputs) {
+      auto range = std::make_pair(kv.second.first, kv.second.first + kv.second.second);
+      auto inserted = keyOutputRanges.emplace(kv.first, range);
+      if (!inserted.second) {
+        inserted.first->second.first = range.first;
+      }
+    }
+
+    if (undoInfo.closestTimestampBlockIndexInserted) {
+      writeBatch.removeClosestTimestampBlockIndex(roundToMidnight(undoInfo.timestamp));
+    }
+
+    restoredTimestamps[undoInfo.timestamp] = undoInfo.previousTimestampBlockHashes;
+  }
+
+  uint32_t removedAmountsCount = 0;
+  for (const auto& kv: keyOutputRanges) {
+    logger(Logging::DEBUGGING) << "Requesting delete for key output amount " << kv.first <<
+                                  " starting from global index " << kv.second.first << " to " << (kv.second.second - 1);
+
+    writeBatch.removeKeyOutputGlobalIndexes(kv.first, kv.second.second - kv.second.first, kv.second.first);
+    for (GlobalOutputIndex index = kv.second.first; index < kv.second.second; ++index) {
+      writeBatch.removeKeyOutputInfo(kv.first, index);
+    }
+
+    // counts not cached yet are read from the database once it is written
+    auto it = keyOutputCountsForAmounts.find(kv.first);
+    if (it != keyOutputCountsForAmounts.end()) {
+      it->second = kv.second.first;
+    }
+
+    if (kv.second.first == 0) {
+      ++removedAmountsCount;
+    }
+  }
+
+  requestRemoveKeyOutputAmounts(writeBatch, removedAmountsCount);
+
+  for (const auto& kv: restoredTimestamps) {
+    if (kv.second.empty()) {
+      writeBatch.removeTimestamp(kv.first);
+    } else {
+      writeBatch.insertTimestamp(kv.first, kv.second);
+    }
+  }
+}
+
 void DatabaseBlockchainCache::pushTransaction(const CachedTransaction& cachedTransaction,
                                               uint32_t blockIndex,
                                               uint16_t transactionBlockIndex,
-                                              BlockchainWriteBatch& batch) {
+                                              BlockchainWriteBatch& batch,
+                                              BlockUndoInfo& undoInfo) {
 
   logger(Logging::DEBUGGING) << "push transaction with hash " << cachedTransaction.getTransactionHash();
   const auto& tx = cachedTransaction.getTransaction();
@@ -774,6 +928,9 @@ void DatabaseBlockchainCache::pushTransaction(const CachedTransaction& cachedTra
       //output global index:
       transactionCacheInfo.amountToKeyIndexes[output.amount].push_back(globalIndex);
 
+      auto undoOutputs = undoInfo.keyOutputs.emplace(output.amount, std::make_pair(globalIndex, 0)).first;
+      ++undoOutputs->second.second;
+
       KeyOutputInfo outputInfo;
       outputInfo.publicKey = boost::get<KeyOutput>(output.target).key;
       outputInfo.transactionHash = transactionCacheInfo.transactionHash;
@@ -796,7 +953,8 @@ void DatabaseBlockchainCache::pushTransaction(const CachedTransaction& cachedTra
 
   Crypto::Hash paymentId;
   if (getPaymentIdFromTxExtra(cachedTransaction.getTransaction().extra, paymentId)) {
-    insertPaymentId(batch, cachedTransaction.getTransactionHash(), paymentId);
+    auto paymentIdCount = insertPaymentId(batch, cachedTransaction.getTransactionHash(), paymentId);
+    undoInfo.paymentIds.emplace_back(paymentId, paymentIdCount - 1);
   }
 
   batch.insertCachedTransaction(transactionCacheInfo, getCachedTransactionsCount() + 1);
@@ -815,26 +973,24 @@ uint32_t DatabaseBlockchainCache::updateKeyOutputCount(Amount amount, int32_t di
     auto val = found != result.getKeyOutputGlobalIndexesCountForAmounts().end() ? found->second : 0;
     it = keyOutputCountsForAmounts.insert({ amount, val }).first;
     logger(Logging::TRACE) << "updateKeyOutputCount: database replied: amount " << amount << " value " << val;
+  }
 
-    if (val == 0) {
-      if (!keyOutputAmountsCount) {
-        auto result = readDatabase(batch.requestKeyOutputAmountsCount());
-        keyOutputAmountsCount = result.getKeyOutputAmountsCount();
-      }
-
-      keyOutputAmountsCount = *keyOutputAmountsCount + 1;
-    }
-  } else if (!keyOutputAmountsCount) {
+  if (!keyOutputAmountsCount) {
     auto result = readDatabase(BlockchainReadBatch().requestKeyOutputAmountsCount());
     keyOutputAmountsCount = result.getKeyOutputAmountsCount();
   }
 
+  // also an amount whose outputs were all popped, split took it off the amounts
+  if (it->second == 0 && diff > 0) {
+    keyOutputAmountsCount = *keyOutputAmountsCount + 1;
+  }
+
   it->second += diff;
   assert(it->second >= 0);
   return it->second;
 }
 
-void DatabaseBlockchainCache::insertPaymentId(BlockchainWriteBatch& batch, const Crypto::Hash& transactionHash, const Crypto::Hash& paymentId) {
+uint32_t DatabaseBlockchainCache::insertPaymentId(BlockchainWriteBatch& batch, const Crypto::Hash& transactionHash, const Crypto::Hash& paymentId) {
   BlockchainReadBatch readBatch;
   uint32_t count = 0;
 
@@ -846,9 +1002,11 @@ void DatabaseBlockchainCache::insertPaymentId(BlockchainWriteBatch& batch, const
   count += 1;
 
   batch.insertPaymentId(transactionHash, paymentId, count);
+  return count;
 }
 
-void DatabaseBlockchainCache::insertBlockTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const Crypto::Hash& blockHash) {
+//returns block hashes the timestamp had before
+std::vector<Crypto::Hash> DatabaseBlockchainCache::insertBlockTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const Crypto::Hash& blockHash) {
   BlockchainReadBatch readBatch;
   readBatch.requestBlockHashesByTimestamp(timestamp);
 
@@ -859,9 +1017,11 @@ void DatabaseBlockchainCache::insertBlockTimestamp(BlockchainWriteBatch& batch,
     blockHashes = readResult.getBlockHashesByTimestamp().at(timestamp);
   }
 
+  auto previousBlockHashes = blockHashes;
   blockHashes.emplace_back(blockHash);
 
   batch.insertTimestamp(timestamp, blockHashes);
+  return previousBlockHashes;
 }
 
 void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
@@ -895,14 +1055,18 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
   // base transaction's hash is always the first one in index for this block
   txHashes.insert(txHashes.begin(), cachedBaseTransaction.getTransactionHash());
 
+  // the raw block itself is only kept in the main chain storage
+  assert(mainChainStorage.getBlockCount() > getTopBlockIndex() + 1);
   batch.insertCachedBlock(blockInfo, getTopBlockIndex() + 1, txHashes);
-  batch.insertRawBlock(getTopBlockIndex() + 1, std::move(rawBlock));
+
+  BlockUndoInfo undoInfo;
+  undoInfo.timestamp = cachedBlock.getBlock().timestamp;
 
   auto transactionIndex = 0;
-  pushTransaction(cachedBaseTransaction, getTopBlockIndex() + 1, transactionIndex++, batch);
+  pushTransaction(cachedBaseTransaction, getTopBlockIndex() + 1, transactionIndex++, batch, undoInfo);
 
   for (const auto& transaction: cachedTransactions) {
-    pushTransaction(transaction, getTopBlockIndex() + 1, transactionIndex++, batch);
+    pushTransaction(transaction, getTopBlockIndex() + 1, transactionIndex++, batch, undoInfo);
   }
 
   auto closestBlockIndexDb = requestClosestBlockIndexByTimestamp(roundToMidnight(cachedBlock.getBlock().timestamp), database);
@@ -911,11 +1075,13 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
     throw std::runtime_error("Couldn't get closest to timestamp block index");
   }
 
-  if (!closestBlockIndexDb.first) {
+  undoInfo.closestTimestampBlockIndexInserted = !closestBlockIndexDb.first;
+  if (undoInfo.closestTimestampBlockIndexInserted) {
     batch.insertClosestTimestampBlockIndex(roundToMidnight(cachedBlock.getBlock().timestamp), getTopBlockIndex() + 1);
   }
 
-  insertBlockTimestamp(batch, cachedBlock.getBlock().timestamp, cachedBlock.getBlockHash());
+  undoInfo.previousTimestampBlockHashes = insertBlockTimestamp(batch, cachedBlock.getBlock().timestamp, cachedBlock.getBlockHash());
+  batch.insertBlockUndoInfo(getTopBlockIndex() + 1, undoInfo);
 
   auto res = database.write(batch);
   if (res) {
@@ -931,6 +1097,11 @@ void DatabaseBlockchainCache::pushBlock(const CachedBlock& cachedBlock,
   if (unitsCache.size() > unitsCacheSize) {
     unitsCache.pop_front();
   }
+
+  recentKeyOutputs.push_back(std::move(undoInfo.keyOutputs));
+  if (recentKeyOutputs.size() > currency.minedMoneyUnlockWindow()) {
+    recentKeyOutputs.pop_front();
+  }
 }
 
 PushedBlockInfo DatabaseBlockchainCache::getPushedBlockInfo(uint32_t blockIndex) const {
@@ -1399,9 +1570,78 @@ size_t DatabaseBlockchainCache::getChildCount() const {
 }
 
 void DatabaseBlockchainCache::save() {
+  if (snapshotFilename.empty()) {
+    return;
+  }
+
+  CacheSnapshot snapshot;
+  snapshot.version = CACHE_SNAPSHOT_VERSION;
+  snapshot.topBlockIndex = getTopBlockIndex();
+  snapshot.topBlockHash = getTopBlockHash();
+  snapshot.transactionsCount = getTransactionCount();
+  snapshot.keyOutputAmountsCount = keyOutputAmountsCount.get_value_or(0);
+  snapshot.hasKeyOutputAmountsCount = keyOutputAmountsCount.is_initialized();
+  snapshot.keyOutputCountsForAmounts = keyOutputCountsForAmounts;
+  snapshot.units.assign(unitsCache.begin(), unitsCache.end());
+  snapshot.recentKeyOutputs.assign(recentKeyOutputs.begin(), recentKeyOutputs.end());
+
+  std::ofstream file(snapshotFilename.c_str(), std::ios::binary | std::ios::trunc);
+  Common::StdOutputStream stream(file);
+  BinaryOutputStreamSerializer s(stream);
+  snapshot.serialize(s);
+
+  if (!file.flush()) {
+    logger(Logging::WARNING) << "Failed to write cache snapshot to " << snapshotFilename;
+    return;
+  }
+
+  logger(Logging::DEBUGGING) << "Cache snapshot saved at block " << snapshot.topBlockIndex;
 }
 
 void DatabaseBlockchainCache::load() {
+  if (snapshotFilename.empty()) {
+    return;
+  }
+
+  std::ifstream file(snapshotFilename.c_str(), std::ios::binary);
+  if (!file) {
+    logger(Logging::DEBUGGING) << "No cache snapshot found at " << snapshotFilename;
+    return;
+  }
+
+  CacheSnapshot snapshot;
+  try {
+    Common::StdInputStream stream(file);
+    BinaryInputStreamSerializer s(stream);
+    snapshot.serialize(s);
+  } catch (std::exception& e) {
+    logger(Logging::WARNING) << "Failed to read cache snapshot " << snapshotFilename << ", ignoring it: " << e.what();
+    return;
+  }
+
+  if (snapshot.version != CACHE_SNAPSHOT_VERSION) {
+    logger(Logging::INFO) << "Cache snapshot version " << snapshot.version << " is not supported, ignoring it";
+    return;
+  }
+
+  // the snapshot is only written on a clean shutdown, a database that moved on since then makes it stale
+  if (snapshot.topBlockIndex != getTopBlockIndex() || snapshot.topBlockHash != getTopBlockHash()) {
+    logger(Logging::INFO) << "Cache snapshot taken at block " << snapshot.topBlockIndex << " doesn't match the database top block "
+                          << getTopBlockIndex() << ", ignoring it";
+    return;
+  }
+
+  transactionsCount = snapshot.transactionsCount;
+  if (snapshot.hasKeyOutputAmountsCount) {
+    keyOutputAmountsCount = snapshot.keyOutputAmountsCount;
+  }
+
+  keyOutputCountsForAmounts = std::move(snapshot.keyOutputCountsForAmounts);
+  unitsCache.assign(snapshot.units.begin(), snapshot.units.end());
+  recentKeyOutputs.assign(std::make_move_iterator(snapshot.recentKeyOutputs.begin()),
+                          std::make_move_iterator(snapshot.recentKeyOutputs.end()));
+
+  logger(Logging::INFO) << "Cache snapshot loaded at block " << snapshot.topBlockIndex;
 }
 
 std::vector<BinaryArray>
@@ -1429,15 +1669,15 @@ void DatabaseBlockchainCache::getRawTransactions(const std::vector<Crypto::Hash>
   }
 
   auto res = readDatabase(batch);
+  std::unordered_map<uint32_t, RawBlock> blocksMap;
   for (auto& tx : res.getCachedTransactions()) {
-    batch.requestRawBlock(tx.second.blockIndex);
+    if (tx.second.blockIndex < mainChainStorage.getBlockCount() && blocksMap.count(tx.second.blockIndex) == 0) {
+      blocksMap.emplace(tx.second.blockIndex, mainChainStorage.getBlockByIndex(tx.second.blockIndex));
+    }
   }
 
-  auto blocks = readDatabase(batch);
-
   foundTransactions.reserve(foundTransactions.size() + transactions.size());
   auto& hashesMap = res.getCachedTransactions();
-  auto& blocksMap = blocks.getRawBlocks();
   for (const auto& hash: transactions) {
     auto transactionIt = hashesMap.find(hash);
     if (transactionIt == hashesMap.end()) {
@@ -1464,9 +1704,11 @@ void DatabaseBlockchainCache::getRawTransactions(const std::vector<Crypto::Hash>
 }
 
 RawBlock DatabaseBlockchainCache::getBlockByIndex(uint32_t index) const {
-  auto batch = BlockchainReadBatch().requestRawBlock(index);
-  auto res = readDatabase(batch);
-  return std::move(res.getRawBlocks().at(index));
+  if (index > getTopBlockIndex()) {
+    throw std::out_of_range("Block index " + std::to_string(index) + " is out of range. Top block index: " + std::to_string(getTopBlockIndex()));
+  }
+
+  return mainChainStorage.getBlockByIndex(index);
 }
 
 BinaryArray DatabaseBlockchainCache::getRawTransaction(uint32_t blockIndex, uint32_t transactionIndex) const {
@@ -1478,62 +1720,119 @@ std::vector<Crypto::Hash> DatabaseBlockchainCache::getTransactionHashes() const
   return {};
 }
 
-std::vector<uint32_t> DatabaseBlockchainCache::getRandomOutsByAmount(uint64_t amount, size_t count,
-                                                                     uint32_t blockIndex) const {
-  auto batch = BlockchainReadBatch().requestKeyOutputGlobalIndexesCountForAmount(amount);
-  auto result = readDatabase(batch);
-  auto outputsCount = result.getKeyOutputGlobalIndexesCountForAmounts();
-  auto outputsToPick = std::min(static_cast<uint32_t>(count), outputsCount[amount]);
-
-  std::vector<uint32_t> resultOuts;
-  resultOuts.reserve(outputsToPick);
+// Every round reads the packed indexes and the keys of the candidates of all the amounts in one batch, and the
+// next round only draws replacements for the locked ones, so a transaction takes two or three reads in total.
+std::vector<std::vector<RandomOutput>> DatabaseBlockchainCache::getRandomOutsByAmounts(const std::vector<Amount>& amounts,
+                                                                                       const std::vector<size_t>& counts,
+                                                                                       uint32_t blockIndex) const {
+  assert(amounts.size() == counts.size());
 
-  ShuffleGenerator<uint32_t, Crypto::random_engine<uint32_t>> generator(outputsCount[amount]);
+  BlockchainReadBatch countBatch;
+  for (Amount amount : amounts) {
+    countBatch.requestKeyOutputGlobalIndexesCountForAmount(amount);
+  }
 
-  while (outputsToPick) {
-    std::vector<uint32_t> globalIndexes;
-    globalIndexes.reserve(outputsToPick);
+  // after a restart or a split the outputs of the recent blocks are read along with the counts
+  uint32_t topIndex = getTopBlockIndex();
+  size_t recentBlocks = std::min(static_cast<size_t>(currency.minedMoneyUnlockWindow()), static_cast<size_t>(topIndex) + 1);
+  for (size_t i = recentKeyOutputs.size(); i < recentBlocks; ++i) {
+    countBatch.requestBlockUndoInfo(topIndex - static_cast<uint32_t>(i));
+  }
 
-    try {
-      for (uint32_t i = 0; i < outputsToPick; ++i, globalIndexes.push_back(generator())) { }
-      //std::generate_n(std::back_inserter(globalIndexes), outputsToPick, generator);
-    } catch (const SequenceEnded&) {
-      logger(Logging::TRACE) << "getRandomOutsByAmount: generator reached sequence end";
-      return resultOuts;
+  auto countResult = readDatabase(countBatch);
+  const auto& outputsCounts = countResult.getKeyOutputGlobalIndexesCountForAmounts();
+  const auto& undoInfos = countResult.getBlockUndoInfos();
+  for (size_t i = recentKeyOutputs.size(); i < recentBlocks; ++i) {
+    auto undoInfo = undoInfos.find(topIndex - static_cast<uint32_t>(i));
+    if (undoInfo == undoInfos.end()) {
+      break;
     }
 
-    std::vector<PackedOutIndex> outputs;
-    if (extractKeyOtputIndexes(amount, Common::ArrayView<uint32_t>(globalIndexes.data(), globalIndexes.size()), outputs) != ExtractOutputKeysResult::SUCCESS) {
-      logger(Logging::DEBUGGING) << "getRandomOutsByAmount: failed to extract key output indexes";
-      throw std::runtime_error("Invalid output index"); //TODO: make error code
-    }
+    recentKeyOutputs.push_front(undoInfo->second.keyOutputs);
+  }
 
-    std::vector<ExtendedTransactionInfo> transactions;
-    if (!requestExtendedTransactionInfos(outputs, database, transactions)) {
-      logger(Logging::TRACE) << "getRandomOutsByAmount: requestExtendedTransactionInfos failed";
-      throw std::runtime_error("Error while requesting transactions"); //TODO: make error code
-    }
+  uint32_t uppperBlockIndex = 0;
+  if (blockIndex > currency.minedMoneyUnlockWindow()) {
+    uppperBlockIndex = blockIndex - currency.minedMoneyUnlockWindow();
+  }
 
-    assert(globalIndexes.size() == transactions.size());
+  // candidates are only drawn from the outputs out of the unlock window, so retries are left for unlock times
+  std::vector<std::vector<RandomOutput>> resultOuts(amounts.size());
+  std::vector<size_t> outputsToPick(amounts.size());
+  std::vector<ShuffleGenerator<uint32_t, Crypto::random_engine<uint32_t>>> generators;
+  generators.reserve(amounts.size());
+  for (size_t i = 0; i < amounts.size(); ++i) {
+    auto outputsCount = outputsCounts.find(amounts[i]);
+    uint32_t count = outputsCount != outputsCounts.end() ? outputsCount->second : 0;
+    count = getUnlockedKeyOutputsCount(amounts[i], count, uppperBlockIndex);
 
-    uint32_t uppperBlockIndex = 0;
-    if (blockIndex > currency.minedMoneyUnlockWindow()) {
-      uppperBlockIndex = blockIndex - currency.minedMoneyUnlockWindow();
-    }
+    outputsToPick[i] = std::min(counts[i], static_cast<size_t>(count));
+    resultOuts[i].reserve(outputsToPick[i]);
+    generators.emplace_back(count);
+  }
 
-    for (size_t i = 0; i < transactions.size(); ++i) {
-      if (!isTransactionSpendTimeUnlocked(transactions[i].unlockTime, blockIndex) || transactions[i].blockIndex > uppperBlockIndex) {
-        continue;
+  for (;;) {
+    BlockchainReadBatch batch;
+    std::vector<std::vector<uint32_t>> globalIndexes(amounts.size());
+    bool hasCandidates = false;
+    for (size_t i = 0; i < amounts.size(); ++i) {
+      while (globalIndexes[i].size() < outputsToPick[i] && !generators[i].empty()) {
+        uint32_t globalIndex = generators[i]();
+        batch.requestKeyOutputGlobalIndexForAmount(amounts[i], globalIndex);
+        batch.requestKeyOutputInfo(amounts[i], globalIndex);
+        globalIndexes[i].push_back(globalIndex);
+        hasCandidates = true;
       }
+    }
+
+    if (!hasCandidates) {
+      break;
+    }
 
-      resultOuts.push_back(globalIndexes[i]);
-      --outputsToPick;
+    auto result = readDatabase(batch);
+    const auto& packedOuts = result.getKeyOutputGlobalIndexesForAmounts();
+    const auto& outputInfos = result.getKeyOutputInfo();
+    for (size_t i = 0; i < amounts.size(); ++i) {
+      for (uint32_t globalIndex : globalIndexes[i]) {
+        auto key = std::make_pair(amounts[i], globalIndex);
+        auto packedOut = packedOuts.find(key);
+        auto outputInfo = outputInfos.find(key);
+        if (packedOut == packedOuts.end() || outputInfo == outputInfos.end()) {
+          logger(Logging::DEBUGGING) << "getRandomOutsByAmounts: failed to read output " << globalIndex << " of amount " << amounts[i];
+          throw std::runtime_error("Invalid output index"); //TODO: make error code
+        }
+
+        if (!isTransactionSpendTimeUnlocked(outputInfo->second.unlockTime, blockIndex) || packedOut->second.blockIndex > uppperBlockIndex) {
+          continue;
+        }
+
+        resultOuts[i].push_back({globalIndex, outputInfo->second.publicKey});
+        --outputsToPick[i];
+      }
     }
   }
 
   return resultOuts;
 }
 
+// Global indexes follow the block order, so every output of the amount below the first one added above
+// upperBlockIndex is out of the unlock window. Without the blocks above it, all the outputs are counted.
+uint32_t DatabaseBlockchainCache::getUnlockedKeyOutputsCount(Amount amount, uint32_t outputsCount, uint32_t upperBlockIndex) const {
+  uint32_t topIndex = getTopBlockIndex();
+  if (upperBlockIndex >= topIndex || topIndex - upperBlockIndex > recentKeyOutputs.size()) {
+    return outputsCount;
+  }
+
+  for (auto it = recentKeyOutputs.end() - (topIndex - upperBlockIndex); it != recentKeyOutputs.end(); ++it) {
+    auto keyOutputs = it->find(amount);
+    if (keyOutputs != it->end()) {
+      return keyOutputs->second.first;
+    }
+  }
+
+  return outputsCount;
+}
+
 ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOutputs(
     uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
     std::function<ExtractOutputKeysResult(const CachedTransactionInfo& info, PackedOutIndex index,
@@ -1566,8 +1865,8 @@ ExtractOutputKeysResult DatabaseBlockchainCache::extractKeyOutputs(
 }
 
 std::vector<Crypto::Hash> DatabaseBlockchainCache::getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const {
-  auto countBatch = BlockchainReadBatch().requestTransactionCountByPaymentId(paymentId);
-  uint32_t transactionsCountByPaymentId = readDatabase(countBatch).getTransactionCountByPaymentIds().at(paymentId);
+  //unknown to the database when only child segments have it
+  size_t transactionsCountByPaymentId = requestPaymentIdTransactionsCount(database, paymentId);
 
   BlockchainReadBatch transactionBatch;
   for (uint32_t i = 0; i < transactionsCountByPaymentId; ++i) {
@@ -1612,7 +1911,6 @@ DatabaseBlockchainCache::ExtendedPushedBlockInfo DatabaseBlockchainCache::getExt
   assert(blockIndex <= getTopBlockIndex());
 
   auto batch = BlockchainReadBatch()
-    .requestRawBlock(blockIndex)
     .requestCachedBlock(blockIndex)
     .requestSpentKeyImagesByBlock(blockIndex);
 
@@ -1620,13 +1918,23 @@ DatabaseBlockchainCache::ExtendedPushedBlockInfo DatabaseBlockchainCache::getExt
     batch.requestCachedBlock(blockIndex - 1);
   }
 
-  auto dbResult = readDatabase(batch);
+  return getExtendedPushedBlockInfo(blockIndex, readDatabase(batch));
+}
+
+// dbResult holds the cached block and its spent key images, the previous cached block, and the undo record if there is one
+DatabaseBlockchainCache::ExtendedPushedBlockInfo DatabaseBlockchainCache::getExtendedPushedBlockInfo(uint32_t blockIndex, const BlockchainReadResult& dbResult) const {
   const CachedBlockInfo& blockInfo = dbResult.getCachedBlocks().at(blockIndex);
   const CachedBlockInfo& previousBlockInfo = blockIndex > 0 ? dbResult.getCachedBlocks().at(blockIndex - 1) : NULL_CACHED_BLOCK_INFO;
 
   ExtendedPushedBlockInfo extendedInfo;
 
-  extendedInfo.pushedBlockInfo.rawBlock = dbResult.getRawBlocks().at(blockIndex);
+  // after an unclean shutdown the database may be ahead of the main chain storage or on another chain,
+  // then the raw block is left empty
+  extendedInfo.hasRawBlock = blockIndex < mainChainStorage.getBlockCount();
+  if (extendedInfo.hasRawBlock) {
+    extendedInfo.pushedBlockInfo.rawBlock = mainChainStorage.getBlockByIndex(blockIndex);
+  }
+
   extendedInfo.pushedBlockInfo.blockSize = blockInfo.blockSize;
   extendedInfo.pushedBlockInfo.blockDifficulty = blockInfo.cumulativeDifficulty - previousBlockInfo.cumulativeDifficulty;
   extendedInfo.pushedBlockInfo.generatedCoins = blockInfo.alreadyGeneratedCoins - previousBlockInfo.alreadyGeneratedCoins;
@@ -1635,7 +1943,10 @@ DatabaseBlockchainCache::ExtendedPushedBlockInfo DatabaseBlockchainCache::getExt
 
   extendedInfo.pushedBlockInfo.validatorState.spentKeyImages.insert(spentKeyImages.begin(), spentKeyImages.end());
 
-  extendedInfo.timestamp = blockInfo.timestamp;
+  extendedInfo.blockHash = blockInfo.blockHash;
+
+  auto undoInfo = dbResult.getBlockUndoInfos().find(blockIndex);
+  extendedInfo.timestamp = undoInfo != dbResult.getBlockUndoInfos().end() ? undoInfo->second.timestamp : blockInfo.timestamp;
 
   return extendedInfo;
 }
@@ -1686,10 +1997,11 @@ void DatabaseBlockchainCache::addGenesisBlock(CachedBlock&& genesisBlock) {
   auto baseTransaction = genesisBlock.getBlock().baseTransaction;
   auto cachedBaseTransaction = CachedTransaction{std::move(baseTransaction)};
 
-  pushTransaction(cachedBaseTransaction, 0, 0, batch);
+  // the genesis block is never popped, so its undo record isn't stored
+  BlockUndoInfo undoInfo;
+  pushTransaction(cachedBaseTransaction, 0, 0, batch, undoInfo);
 
   batch.insertCachedBlock(blockInfo, 0, {cachedBaseTransaction.getTransactionHash()});
-  batch.insertRawBlock(0, {toBinaryArray(genesisBlock.getBlock()), {}});
   batch.insertClosestTimestampBlockIndex(roundToMidnight(genesisBlock.getBlock().timestamp), 0);
 
   auto res = database.write(batch);
@@ -1701,6 +2013,7 @@ void DatabaseBlockchainCache::addGenesisBlock(CachedBlock&& genesisBlock) {
   topBlockHash = genesisBlock.getBlockHash();
 
   unitsCache.push_back(blockInfo);
+  recentKeyOutputs.push_back(std::move(undoInfo.keyOutputs));
 }
 
 }
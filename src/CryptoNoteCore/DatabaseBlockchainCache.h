@@ -20,6 +20,7 @@
 #include "Common/StringView.h"
 #include "Currency.h"
 #include "IBlockchainCache.h"
+#include "IMainChainStorage.h"
 #include "CryptoNoteCore/UpgradeManager.h"
 #include <IDataBase.h>
 #include <CryptoNoteCore/BlockchainReadBatch.h>
@@ -43,10 +44,11 @@ public:
 
   /*
    * Constructs new DatabaseBlockchainCache object. Currnetly, only factories that produce 
-   * BlockchainCache objects as children are supported.
+   * BlockchainCache objects as children are supported. Raw blocks are not kept in the database,
+   * they are read from the main chain storage, which always holds the blocks of this cache.
    */
-  DatabaseBlockchainCache(const Currency& currency, IDataBase& dataBase,
-                          IBlockchainCacheFactory& blockchainCacheFactory, Logging::ILogger& logger);
+  DatabaseBlockchainCache(const Currency& currency, IDataBase& dataBase, const IMainChainStorage& mainChainStorage,
+                          IBlockchainCacheFactory& blockchainCacheFactory, const std::string& snapshotFilename, Logging::ILogger& logger);
 
   static bool checkDBSchemeVersion(IDataBase& dataBase, Logging::ILogger& logger);
 
@@ -147,8 +149,8 @@ public:
   virtual RawBlock getBlockByIndex(uint32_t index) const override;
   virtual BinaryArray getRawTransaction(uint32_t blockIndex, uint32_t transactionIndex) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashes() const override;
-  virtual std::vector<uint32_t> getRandomOutsByAmount(uint64_t amount, size_t count,
-                                                      uint32_t blockIndex) const override;
+  virtual std::vector<std::vector<RandomOutput>> getRandomOutsByAmounts(const std::vector<Amount>& amounts, const std::vector<size_t>& counts,
+                                                                        uint32_t blockIndex) const override;
   virtual ExtractOutputKeysResult
   extractKeyOutputs(uint64_t amount, uint32_t blockIndex, Common::ArrayView<uint32_t> globalIndexes,
                     std::function<ExtractOutputKeysResult(const CachedTransactionInfo& info, PackedOutIndex index,
@@ -160,7 +162,10 @@ public:
 private:
   const Currency& currency;
   IDataBase& database;
+  const IMainChainStorage& mainChainStorage;
   IBlockchainCacheFactory& blockchainCacheFactory;
+  // save() writes the in-memory state below there and load() takes it back if the database still has the same top block
+  const std::string snapshotFilename;
   mutable boost::optional<uint32_t> topBlockIndex;
   mutable boost::optional<Crypto::Hash> topBlockHash;
   mutable boost::optional<uint64_t> transactionsCount;
@@ -170,24 +175,30 @@ private:
   Logging::LoggerRef logger;
   std::deque<CachedBlockInfo> unitsCache;
   const size_t unitsCacheSize = 1000;
+  // key outputs added by the last minedMoneyUnlockWindow blocks, as in BlockUndoInfo::keyOutputs
+  mutable std::deque<std::map<Amount, std::pair<GlobalOutputIndex, uint32_t>>> recentKeyOutputs;
 
   struct ExtendedPushedBlockInfo;
+  struct CacheSnapshot;
   ExtendedPushedBlockInfo getExtendedPushedBlockInfo(uint32_t blockIndex) const;
+  ExtendedPushedBlockInfo getExtendedPushedBlockInfo(uint32_t blockIndex, const BlockchainReadResult& dbResult) const;
 
   void deleteClosestTimestampBlockIndex(BlockchainWriteBatch& writeBatch, uint32_t splitBlockIndex);
   CachedBlockInfo getCachedBlockInfo(uint32_t index) const;
+  uint32_t getUnlockedKeyOutputsCount(Amount amount, uint32_t outputsCount, uint32_t upperBlockIndex) const;
   BlockchainReadResult readDatabase(BlockchainReadBatch& batch) const;
 
   void addSpentKeyImage(const Crypto::KeyImage& keyImage, uint32_t blockIndex);
   void pushTransaction(const CachedTransaction& cachedTransaction,
                        uint32_t blockIndex,
                        uint16_t transactionBlockIndex,
-                       BlockchainWriteBatch& batch);
+                       BlockchainWriteBatch& batch,
+                       BlockUndoInfo& undoInfo);
 
   uint32_t insertKeyOutputToGlobalIndex(uint64_t amount, PackedOutIndex output); //TODO not implemented. Should it be removed?
   uint32_t updateKeyOutputCount(Amount amount, int32_t diff) const;
-  void insertPaymentId(BlockchainWriteBatch& batch, const Crypto::Hash& transactionHash, const Crypto::Hash& paymentId);
-  void insertBlockTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const Crypto::Hash& blockHash);
+  uint32_t insertPaymentId(BlockchainWriteBatch& batch, const Crypto::Hash& transactionHash, const Crypto::Hash& paymentId);
+  std::vector<Crypto::Hash> insertBlockTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const Crypto::Hash& blockHash);
 
   void addGenesisBlock(CachedBlock&& genesisBlock);
 
@@ -195,7 +206,7 @@ private:
 
   TransactionValidatorState fillOutputsSpentByBlock(uint32_t blockIndex) const;
 
-  Crypto::Hash pushBlockToAnotherCache(IBlockchainCache& segment, PushedBlockInfo&& pushedBlockInfo);
+  bool pushBlockToAnotherCache(IBlockchainCache& segment, const Crypto::Hash& blockHash, PushedBlockInfo&& pushedBlockInfo);
   void requestDeleteSpentOutputs(BlockchainWriteBatch& writeBatch, uint32_t splitBlockIndex, const TransactionValidatorState& spentOutputs);
   std::vector<Crypto::Hash> requestTransactionHashesFromBlockIndex(uint32_t splitBlockIndex);
   void requestDeleteTransactions(BlockchainWriteBatch& writeBatch, const std::vector<Crypto::Hash>& transactionHashes);
@@ -203,7 +214,9 @@ private:
   void requestDeletePaymentId(BlockchainWriteBatch& writeBatch, const Crypto::Hash& paymentId, size_t toDelete);
   void requestDeleteKeyOutputs(BlockchainWriteBatch& writeBatch, const std::map<IBlockchainCache::Amount, IBlockchainCache::GlobalOutputIndex>& boundaries);
   void requestDeleteKeyOutputsAmount(BlockchainWriteBatch& writeBatch, IBlockchainCache::Amount amount, IBlockchainCache::GlobalOutputIndex boundary, uint32_t outputsCount);
-  void requestRemoveTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const Crypto::Hash& blockHash);
+  void requestRemoveKeyOutputAmounts(BlockchainWriteBatch& writeBatch, uint32_t removedAmountsCount);
+  void requestRemoveTimestamp(BlockchainWriteBatch& batch, uint64_t timestamp, const std::vector<Crypto::Hash>& blockHashes);
+  void requestUndoBlocks(BlockchainWriteBatch& writeBatch, uint32_t splitBlockIndex, const BlockchainReadResult& undoReadResult);
 
 uint8_t getBlockMajorVersionForHeight(uint32_t height) const;
   uint64_t getCachedTransactionsCount() const;
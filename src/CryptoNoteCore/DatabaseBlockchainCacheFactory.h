@@ -17,16 +17,21 @@
 
 #pragma once
 
+#include <string>
+
 #include "IBlockchainCacheFactory.h"
 #include <Logging/LoggerMessage.h>
 
 namespace CryptoNote {
 
 class IDataBase;
+class IMainChainStorage;
 
 class DatabaseBlockchainCacheFactory: public IBlockchainCacheFactory {
 public:
-  explicit DatabaseBlockchainCacheFactory(IDataBase& database, Logging::ILogger& logger);
+  // the root cache keeps a snapshot of its in-memory state in snapshotFilename, empty disables it
+  DatabaseBlockchainCacheFactory(IDataBase& database, const IMainChainStorage& mainChainStorage, const std::string& snapshotFilename,
+                                 Logging::ILogger& logger);
   virtual ~DatabaseBlockchainCacheFactory();
 
   virtual std::unique_ptr<IBlockchainCache> createRootBlockchainCache(const Currency& currency) override;
@@ -34,6 +39,8 @@ public:
 
 private:
   IDataBase& database;
+  const IMainChainStorage& mainChainStorage;
+  std::string snapshotFilename;
   Logging::ILogger& logger;
 };
 
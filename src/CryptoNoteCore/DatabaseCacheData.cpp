@@ -34,4 +34,12 @@ void KeyOutputInfo::serialize(ISerializer& s) {
   s(outputIndex, "output_index");
 }
 
+void BlockUndoInfo::serialize(ISerializer& s) {
+  s(timestamp, "timestamp");
+  s(keyOutputs, "key_outputs");
+  s(paymentIds, "payment_ids");
+  s(previousTimestampBlockHashes, "previous_timestamp_block_hashes");
+  s(closestTimestampBlockIndexInserted, "closest_timestamp_block_index_inserted");
+}
+
 }
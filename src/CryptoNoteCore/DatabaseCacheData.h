@@ -38,4 +38,18 @@ struct ExtendedTransactionInfo : CachedTransactionInfo {
   void serialize(ISerializer& s);
 };
 
+// What pushing a block added to the shared indexes, so that popping the block needs no lookups
+struct BlockUndoInfo {
+  uint64_t timestamp;
+  // per amount, the global index of the first key output the block added and how many it added
+  std::map<IBlockchainCache::Amount, std::pair<IBlockchainCache::GlobalOutputIndex, uint32_t>> keyOutputs;
+  // payment id of every transaction having one, with the position of the transaction under it
+  std::vector<std::pair<Crypto::Hash, uint32_t>> paymentIds;
+  // block hashes stored under the timestamp before the block was pushed
+  std::vector<Crypto::Hash> previousTimestampBlockHashes;
+  bool closestTimestampBlockIndexInserted;
+
+  void serialize(ISerializer& s);
+};
+
 }
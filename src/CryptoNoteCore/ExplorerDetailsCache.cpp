@@ -0,0 +1,161 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "ExplorerDetailsCache.h"
+
+#include <iterator>
+
+using namespace CryptoNote;
+
+namespace {
+
+// list and hash map nodes of an entry
+const size_t ENTRY_OVERHEAD = 128;
+
+size_t estimateSize(const TransactionDetails& transactionDetails) {
+  size_t size = sizeof(TransactionDetails) + transactionDetails.extra.nonce.size() + transactionDetails.extra.raw.size();
+
+  for (const auto& signatures : transactionDetails.signatures) {
+    size += sizeof(signatures) + signatures.size() * sizeof(Crypto::Signature);
+  }
+
+  size += transactionDetails.inputs.size() * sizeof(TransactionInputDetails);
+  for (const auto& input : transactionDetails.inputs) {
+    if (input.type() == typeid(KeyInputDetails)) {
+      size += boost::get<KeyInputDetails>(input).input.outputIndexes.size() * sizeof(uint32_t);
+    }
+  }
+
+  return size + transactionDetails.outputs.size() * sizeof(TransactionOutputDetails);
+}
+
+size_t estimateSize(const BlockDetails& blockDetails) {
+  size_t size = sizeof(BlockDetails);
+  for (const auto& transactionDetails : blockDetails.transactions) {
+    size += estimateSize(transactionDetails);
+  }
+
+  return size;
+}
+
+}
+
+ExplorerDetailsCache::ExplorerDetailsCache(size_t maxSize) : maxSize(maxSize), size(0), hits(0), misses(0) {
+}
+
+void ExplorerDetailsCache::setMaxSize(size_t maxSize) {
+  std::lock_guard<std::mutex> lock(mutex);
+  this->maxSize = maxSize;
+  shrink();
+}
+
+bool ExplorerDetailsCache::getBlock(const Crypto::Hash& blockHash, BlockDetails& blockDetails) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = find(blocks, blockHash);
+  if (it == entries.end()) {
+    return false;
+  }
+
+  blockDetails = *it->block;
+  return true;
+}
+
+void ExplorerDetailsCache::addBlock(const BlockDetails& blockDetails) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (maxSize == 0 || blocks.count(blockDetails.hash) != 0) {
+    return;
+  }
+
+  Entry entry;
+  entry.blockIndex = blockDetails.index;
+  entry.size = ENTRY_OVERHEAD + estimateSize(blockDetails);
+  entry.block.reset(new BlockDetails(blockDetails));
+  insert(std::move(entry));
+  blocks.emplace(blockDetails.hash, entries.begin());
+  shrink();
+}
+
+bool ExplorerDetailsCache::getTransaction(const Crypto::Hash& transactionHash, TransactionDetails& transactionDetails) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = find(transactions, transactionHash);
+  if (it == entries.end()) {
+    return false;
+  }
+
+  transactionDetails = *it->transaction;
+  return true;
+}
+
+void ExplorerDetailsCache::addTransaction(const TransactionDetails& transactionDetails) {
+  std::lock_guard<std::mutex> lock(mutex);
+  if (maxSize == 0 || transactions.count(transactionDetails.hash) != 0) {
+    return;
+  }
+
+  Entry entry;
+  entry.blockIndex = transactionDetails.blockIndex;
+  entry.size = ENTRY_OVERHEAD + estimateSize(transactionDetails);
+  entry.transaction.reset(new TransactionDetails(transactionDetails));
+  insert(std::move(entry));
+  transactions.emplace(transactionDetails.hash, entries.begin());
+  shrink();
+}
+
+void ExplorerDetailsCache::removeFrom(uint32_t blockIndex) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto it = entries.begin(); it != entries.end();) {
+    if (it->blockIndex >= blockIndex) {
+      erase(it++);
+    } else {
+      ++it;
+    }
+  }
+}
+
+ExplorerDetailsCache::Statistics ExplorerDetailsCache::getStatistics() const {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  Statistics statistics;
+  statistics.hits = hits;
+  statistics.misses = misses;
+  statistics.blockCount = blocks.size();
+  statistics.transactionCount = transactions.size();
+  statistics.size = size;
+  statistics.maxSize = maxSize;
+  return statistics;
+}
+
+ExplorerDetailsCache::EntryList::iterator ExplorerDetailsCache::find(std::unordered_map<Crypto::Hash, EntryList::iterator>& index, const Crypto::Hash& hash) {
+  auto found = index.find(hash);
+  if (found == index.end()) {
+    ++misses;
+    return entries.end();
+  }
+
+  ++hits;
+  entries.splice(entries.begin(), entries, found->second);
+  return found->second;
+}
+
+void ExplorerDetailsCache::insert(Entry&& entry) {
+  size += entry.size;
+  entries.push_front(std::move(entry));
+}
+
+void ExplorerDetailsCache::erase(EntryList::iterator it) {
+  if (it->block) {
+    blocks.erase(it->block->hash);
+  } else {
+    transactions.erase(it->transaction->hash);
+  }
+
+  size -= it->size;
+  entries.erase(it);
+}
+
+void ExplorerDetailsCache::shrink() {
+  while (size > maxSize && !entries.empty()) {
+    erase(std::prev(entries.end()));
+  }
+}
@@ -0,0 +1,72 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "BlockchainExplorerData.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+// Block and transaction details of the main chain, least recently used ones are dropped once their
+// estimated size goes over the budget. The details don't change while their block stays in the main
+// chain, so the owner only has to drop the blocks above a chain switch. A budget of 0 disables it.
+class ExplorerDetailsCache {
+public:
+  struct Statistics {
+    uint64_t hits;
+    uint64_t misses;
+    size_t blockCount;
+    size_t transactionCount;
+    size_t size;
+    size_t maxSize;
+  };
+
+  explicit ExplorerDetailsCache(size_t maxSize);
+
+  void setMaxSize(size_t maxSize);
+
+  bool getBlock(const Crypto::Hash& blockHash, BlockDetails& blockDetails);
+  void addBlock(const BlockDetails& blockDetails);
+
+  bool getTransaction(const Crypto::Hash& transactionHash, TransactionDetails& transactionDetails);
+  void addTransaction(const TransactionDetails& transactionDetails);
+
+  // drops everything from the blocks with index blockIndex and above
+  void removeFrom(uint32_t blockIndex);
+
+  Statistics getStatistics() const;
+
+private:
+  struct Entry {
+    uint32_t blockIndex;
+    size_t size;
+    std::unique_ptr<BlockDetails> block;
+    std::unique_ptr<TransactionDetails> transaction;
+  };
+
+  typedef std::list<Entry> EntryList;
+
+  mutable std::mutex mutex;
+  size_t maxSize;
+  size_t size;
+  uint64_t hits;
+  uint64_t misses;
+  // most recently used first
+  EntryList entries;
+  std::unordered_map<Crypto::Hash, EntryList::iterator> blocks;
+  std::unordered_map<Crypto::Hash, EntryList::iterator> transactions;
+
+  EntryList::iterator find(std::unordered_map<Crypto::Hash, EntryList::iterator>& index, const Crypto::Hash& hash);
+  void insert(Entry&& entry);
+  void erase(EntryList::iterator it);
+  void shrink();
+};
+
+}
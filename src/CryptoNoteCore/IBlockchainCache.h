@@ -49,6 +49,11 @@ union PackedOutIndex {
 
 const uint32_t INVALID_BLOCK_INDEX = std::numeric_limits<uint32_t>::max();
 
+struct RandomOutput {
+  uint32_t globalIndex;
+  Crypto::PublicKey publicKey;
+};
+
 struct PushedBlockInfo {
   RawBlock rawBlock;
   TransactionValidatorState validatorState;
@@ -172,7 +177,9 @@ public:
   virtual std::vector<uint64_t> getLastUnits(size_t count, uint32_t blockIndex, UseGenesis use,
                                              std::function<uint64_t(const CachedBlockInfo&)> pred) const = 0;
   virtual std::vector<Crypto::Hash> getTransactionHashes() const = 0;
-  virtual std::vector<uint32_t> getRandomOutsByAmount(uint64_t amount, size_t count, uint32_t blockIndex) const = 0;
+  // up to counts[i] unlocked outputs of amounts[i] for every i, picked for all the amounts together
+  virtual std::vector<std::vector<RandomOutput>> getRandomOutsByAmounts(const std::vector<Amount>& amounts, const std::vector<size_t>& counts,
+                                                                        uint32_t blockIndex) const = 0;
 
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const = 0;
   virtual std::vector<Crypto::Hash> getBlockHashesByTimestamps(uint64_t timestampBegin, size_t secondsCount) const = 0;
@@ -82,6 +82,8 @@ public:
                                            std::vector<uint32_t>& globalIndexes) const = 0;
   virtual bool getRandomOutputs(uint64_t amount, uint16_t count, std::vector<uint32_t>& globalIndexes,
                                 std::vector<Crypto::PublicKey>& publicKeys) const = 0;
+  virtual bool getRandomOutputs(const std::vector<uint64_t>& amounts, uint16_t count, std::vector<std::vector<uint32_t>>& globalIndexes,
+                                std::vector<std::vector<Crypto::PublicKey>>& publicKeys) const = 0;
 
   virtual bool addTransactionToPool(const BinaryArray& transactionBinaryArray) = 0;
 
@@ -92,6 +94,12 @@ public:
   virtual bool getPoolChangesLite(const Crypto::Hash& lastBlockHash, const std::vector<Crypto::Hash>& knownHashes,
                                   std::vector<TransactionPrefixInfo>& addedTransactions,
                                   std::vector<Crypto::Hash>& deletedTransactions) const = 0;
+  // Changes after the pool sequence number sequenceNumber. If they are no longer remembered,
+  // isSequenceActual is false and addedTransactions has the whole pool instead.
+  virtual bool getPoolChangesSince(const Crypto::Hash& lastBlockHash, uint64_t sequenceNumber,
+                                   std::vector<TransactionPrefixInfo>& addedTransactions,
+                                   std::vector<Crypto::Hash>& deletedTransactions,
+                                   uint64_t& currentSequenceNumber, bool& isSequenceActual) const = 0;
 
   virtual bool getBlockTemplate(BlockTemplate& b, const AccountPublicAddress& adr, const BinaryArray& extraNonce,
                                 uint64_t& difficulty, uint32_t& height) const = 0;
@@ -37,6 +37,14 @@ public:
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const = 0;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const = 0;
+  // Pool transactions spending any of the key images in state
+  virtual std::vector<Crypto::Hash> getTransactionHashesByKeyImages(const TransactionValidatorState& state) const = 0;
+  virtual std::vector<Crypto::Hash> getTransactionHashesBiggerThan(size_t size) const = 0;
+
+  // Increased by every addition and removal
+  virtual uint64_t getSequenceNumber() const = 0;
+  // Net changes made after sequenceNumber, false if they are no longer remembered
+  virtual bool getChangesSince(uint64_t sequenceNumber, std::vector<Crypto::Hash>& addedTransactions, std::vector<Crypto::Hash>& deletedTransactions) const = 0;
 };
 
 }
@@ -17,9 +17,12 @@
 
 #include "RocksDBWrapper.h"
 
+#include <cstdio>
+
 #include "rocksdb/cache.h"
 #include "rocksdb/table.h"
 #include "rocksdb/db.h"
+#include "rocksdb/sst_file_writer.h"
 #include "rocksdb/utilities/backupable_db.h"
 
 #include "DataBaseErrors.h"
@@ -30,9 +33,14 @@ using namespace Logging;
 namespace {
   const std::string DB_NAME = "DB";
   const std::string TESTNET_DB_NAME = "testnet_DB";
+
+  // sequence number and count, then a type byte and up to two varint32 lengths per record
+  const size_t WRITE_BATCH_HEADER_SIZE = 12;
+  const size_t WRITE_BATCH_RECORD_OVERHEAD = 11;
 }
 
-RocksDBWrapper::RocksDBWrapper(Logging::ILogger& logger) : logger(logger, "RocksDBWrapper"), state(NOT_INITIALIZED){
+RocksDBWrapper::RocksDBWrapper(Logging::ILogger& logger) : logger(logger, "RocksDBWrapper"), state(NOT_INITIALIZED), bulkLoad(false),
+    bulkLoadDataSize(0), bulkLoadChunkSize(0), bulkLoadIngestedFiles(0), bulkLoadIngestedSize(0) {
 
 }
 
@@ -72,6 +80,8 @@ void RocksDBWrapper::init(const DataBaseConfig& config) {
   }
 
   db.reset(dbPtr);
+  bulkLoadChunkSize = static_cast<size_t>(config.getWriteBufferSize());
+  bulkLoadFileName = dataDir + "_bulk_load.sst";
   state.store(INITIALIZED);
 }
 
@@ -80,6 +90,11 @@ void RocksDBWrapper::shutdown() {
     throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
   }
 
+  auto error = endBulkLoad();
+  if (error) {
+    logger(ERROR) << "Bulk load data couldn't be written, the blocks it held will be imported again on the next start";
+  }
+
   logger(INFO) << "Closing DB.";
   db->Flush(rocksdb::FlushOptions());
   db->SyncWAL();
@@ -124,16 +139,50 @@ std::error_code RocksDBWrapper::writeSync(IWriteBatch& batch) {
 }
 
 std::error_code RocksDBWrapper::write(IWriteBatch& batch, bool sync) {
+  {
+    std::lock_guard<std::mutex> lock(bulkLoadMutex);
+    if (bulkLoad) {
+      // in the order rocksdb::WriteBatch applies them below, so a key both inserted and removed ends up removed
+      for (auto& kvPair : batch.extractRawDataToInsert()) {
+        bulkLoadDataSize += kvPair.first.size() + kvPair.second.size();
+        bulkLoadData[std::move(kvPair.first)] = std::move(kvPair.second);
+      }
+
+      for (auto& key : batch.extractRawKeysToRemove()) {
+        bulkLoadDataSize += key.size();
+        bulkLoadData[std::move(key)] = boost::none;
+      }
+
+      // an ingested file is as durable as a synced write
+      if (bulkLoadDataSize < bulkLoadChunkSize && !sync) {
+        return std::error_code();
+      }
+
+      return flushBulkLoadData();
+    }
+  }
+
   rocksdb::WriteOptions writeOptions;
   writeOptions.sync = sync;
 
-  rocksdb::WriteBatch rocksdbBatch;
+  // the extracted data is moved out of the batch, the WriteBatch then takes the one copy it needs in a single allocation
   std::vector<std::pair<std::string, std::string>> rawData(batch.extractRawDataToInsert());
+  std::vector<std::string> rawKeys(batch.extractRawKeysToRemove());
+
+  size_t batchSize = WRITE_BATCH_HEADER_SIZE;
+  for (const std::pair<std::string, std::string>& kvPair : rawData) {
+    batchSize += WRITE_BATCH_RECORD_OVERHEAD + kvPair.first.size() + kvPair.second.size();
+  }
+
+  for (const std::string& key : rawKeys) {
+    batchSize += WRITE_BATCH_RECORD_OVERHEAD + key.size();
+  }
+
+  rocksdb::WriteBatch rocksdbBatch(batchSize);
   for (const std::pair<std::string, std::string>& kvPair : rawData) {
     rocksdbBatch.Put(rocksdb::Slice(kvPair.first), rocksdb::Slice(kvPair.second));
   }
 
-  std::vector<std::string> rawKeys(batch.extractRawKeysToRemove());
   for (const std::string& key : rawKeys) {
     rocksdbBatch.Delete(rocksdb::Slice(key));
   }
@@ -156,29 +205,164 @@ std::error_code RocksDBWrapper::read(IReadBatch& batch) {
   rocksdb::ReadOptions readOptions;
 
   std::vector<std::string> rawKeys(batch.getRawKeys());
+  std::vector<std::string> values(rawKeys.size());
+  std::vector<bool> resultStates(rawKeys.size());
+
+  // keys still waiting for ingestion are answered from memory, the rest from the DB
+  std::vector<size_t> dbKeyIndexes;
+  dbKeyIndexes.reserve(rawKeys.size());
+  {
+    std::lock_guard<std::mutex> lock(bulkLoadMutex);
+    for (size_t i = 0; i < rawKeys.size(); ++i) {
+      auto it = bulkLoadData.find(rawKeys[i]);
+      if (it == bulkLoadData.end()) {
+        dbKeyIndexes.push_back(i);
+      } else if (it->second) {
+        values[i] = *it->second;
+        resultStates[i] = true;
+      }
+    }
+  }
+
   std::vector<rocksdb::Slice> keySlices;
-  keySlices.reserve(rawKeys.size());
-  for (const std::string& key : rawKeys) {
-    keySlices.emplace_back(rocksdb::Slice(key));
+  keySlices.reserve(dbKeyIndexes.size());
+  for (size_t i : dbKeyIndexes) {
+    keySlices.emplace_back(rocksdb::Slice(rawKeys[i]));
   }
 
-  std::vector<std::string> values;
-  values.reserve(rawKeys.size());
-  std::vector<rocksdb::Status> statuses = db->MultiGet(readOptions, keySlices, &values);
+  std::vector<std::string> dbValues;
+  dbValues.reserve(dbKeyIndexes.size());
+  std::vector<rocksdb::Status> statuses = db->MultiGet(readOptions, keySlices, &dbValues);
 
-  std::error_code error;
-  std::vector<bool> resultStates;
-  for (const rocksdb::Status& status : statuses) {
-    if (!status.ok() && !status.IsNotFound()) {
+  for (size_t j = 0; j < statuses.size(); ++j) {
+    if (!statuses[j].ok() && !statuses[j].IsNotFound()) {
       return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
     }
-    resultStates.push_back(status.ok());
+
+    values[dbKeyIndexes[j]] = std::move(dbValues[j]);
+    resultStates[dbKeyIndexes[j]] = statuses[j].ok();
   }
 
   batch.submitRawResult(values, resultStates);
   return std::error_code();
 }
 
+void RocksDBWrapper::beginBulkLoad() {
+  if (state.load() != INITIALIZED) {
+    throw std::system_error(make_error_code(CryptoNote::error::DataBaseErrorCodes::NOT_INITIALIZED));
+  }
+
+  std::lock_guard<std::mutex> lock(bulkLoadMutex);
+  if (bulkLoad) {
+    return;
+  }
+
+  logger(INFO) << "Starting bulk load, writes are ingested in chunks of " << bulkLoadChunkSize / (1024 * 1024) << " MB";
+  bulkLoad = true;
+  bulkLoadIngestedFiles = 0;
+  bulkLoadIngestedSize = 0;
+}
+
+std::error_code RocksDBWrapper::endBulkLoad() {
+  std::lock_guard<std::mutex> lock(bulkLoadMutex);
+  if (!bulkLoad) {
+    return std::error_code();
+  }
+
+  auto error = flushBulkLoadData();
+  if (error) {
+    return error;
+  }
+
+  bulkLoad = false;
+
+  logger(INFO) << "Bulk load finished, ingested " << bulkLoadIngestedFiles << " files of " << bulkLoadIngestedSize / (1024 * 1024) << " MB in total";
+  return std::error_code();
+}
+
+std::error_code RocksDBWrapper::flushBulkLoadData() {
+  auto error = ingestBulkLoadData();
+  if (!error) {
+    return error;
+  }
+
+  // stays on if this fails too, so the data keeps shadowing the DB and the next write or shutdown() tries again
+  logger(WARNING) << "Switching from bulk load to normal writes";
+  error = writeBulkLoadData();
+  if (!error) {
+    bulkLoad = false;
+  }
+
+  return error;
+}
+
+std::error_code RocksDBWrapper::ingestBulkLoadData() {
+  if (bulkLoadData.empty()) {
+    return std::error_code();
+  }
+
+  rocksdb::SstFileWriter fileWriter(rocksdb::EnvOptions(), db->GetOptions());
+  rocksdb::Status status = fileWriter.Open(bulkLoadFileName);
+
+  // the map is ordered the same way as the default bytewise comparator
+  for (auto it = bulkLoadData.begin(); status.ok() && it != bulkLoadData.end(); ++it) {
+    if (it->second) {
+      status = fileWriter.Put(rocksdb::Slice(it->first), rocksdb::Slice(*it->second));
+    } else {
+      status = fileWriter.Delete(rocksdb::Slice(it->first));
+    }
+  }
+
+  rocksdb::ExternalSstFileInfo fileInfo;
+  if (status.ok()) {
+    status = fileWriter.Finish(&fileInfo);
+  }
+
+  if (status.ok()) {
+    rocksdb::IngestExternalFileOptions ingestOptions;
+    ingestOptions.move_files = true;
+    status = db->IngestExternalFile({bulkLoadFileName}, ingestOptions);
+  }
+
+  std::remove(bulkLoadFileName.c_str());
+
+  if (!status.ok()) {
+    logger(ERROR) << "Can't ingest bulk load data to DB. " << status.ToString();
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  logger(DEBUGGING) << "Ingested " << bulkLoadData.size() << " keys, " << fileInfo.file_size << " bytes";
+  ++bulkLoadIngestedFiles;
+  bulkLoadIngestedSize += fileInfo.file_size;
+  bulkLoadData.clear();
+  bulkLoadDataSize = 0;
+  return std::error_code();
+}
+
+std::error_code RocksDBWrapper::writeBulkLoadData() {
+  rocksdb::WriteBatch rocksdbBatch;
+  for (const auto& kvPair : bulkLoadData) {
+    if (kvPair.second) {
+      rocksdbBatch.Put(rocksdb::Slice(kvPair.first), rocksdb::Slice(*kvPair.second));
+    } else {
+      rocksdbBatch.Delete(rocksdb::Slice(kvPair.first));
+    }
+  }
+
+  rocksdb::WriteOptions writeOptions;
+  writeOptions.sync = true;
+
+  rocksdb::Status status = db->Write(writeOptions, &rocksdbBatch);
+  if (!status.ok()) {
+    logger(ERROR) << "Can't write bulk load data to DB. " << status.ToString();
+    return make_error_code(CryptoNote::error::DataBaseErrorCodes::INTERNAL_ERROR);
+  }
+
+  bulkLoadData.clear();
+  bulkLoadDataSize = 0;
+  return std::error_code();
+}
+
 rocksdb::Options RocksDBWrapper::getDBOptions(const DataBaseConfig& config) {
   rocksdb::DBOptions dbOptions;
   dbOptions.IncreaseParallelism(config.getBackgroundThreadsCount());
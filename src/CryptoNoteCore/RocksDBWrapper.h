@@ -18,9 +18,13 @@
 #pragma once
 
 #include <atomic>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 
+#include <boost/optional.hpp>
+
 #include "rocksdb/db.h"
 
 #include "IDataBase.h"
@@ -49,8 +53,21 @@ public:
   std::error_code writeSync(IWriteBatch& batch) override;
   std::error_code read(IReadBatch& batch) override;
 
+  // Until endBulkLoad() writes are kept in memory and ingested as sorted table files of about the write buffer size,
+  // bypassing the WAL and the memtables. Meant for the blocks below the last checkpoint, which are never reverted.
+  // A write returns before it is durable: up to a write buffer worth of blocks is only in memory until the next
+  // ingestion, a synced write or endBulkLoad(), and is lost on a crash. Every ingestion holds whole write batches, so
+  // the DB still ends at a block and the core imports the lost blocks again from the main chain storage on start.
+  // If an ingestion fails, the data is written through the WAL instead and bulk load ends. endBulkLoad() returns the
+  // error only if that fails as well, the data then stays in memory and is tried again on the next call.
+  void beginBulkLoad();
+  std::error_code endBulkLoad();
+
 private:
   std::error_code write(IWriteBatch& batch, bool sync);
+  std::error_code flushBulkLoadData();
+  std::error_code ingestBulkLoadData();
+  std::error_code writeBulkLoadData();
 
   rocksdb::Options getDBOptions(const DataBaseConfig& config);
   std::string getDataDir(const DataBaseConfig& config);
@@ -63,5 +80,15 @@ private:
   Logging::LoggerRef logger;
   std::unique_ptr<rocksdb::DB> db;
   std::atomic<State> state;
+
+  std::mutex bulkLoadMutex;
+  bool bulkLoad;
+  // none is a removed key
+  std::map<std::string, boost::optional<std::string>> bulkLoadData;
+  size_t bulkLoadDataSize;
+  size_t bulkLoadChunkSize;
+  std::string bulkLoadFileName;
+  uint64_t bulkLoadIngestedFiles;
+  uint64_t bulkLoadIngestedSize;
 };
 }
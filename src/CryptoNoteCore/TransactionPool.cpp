@@ -17,10 +17,14 @@
 
 #include "TransactionPool.h"
 
+#include <unordered_set>
+
 #include "Common/int-util.h"
 #include "CryptoNoteBasicImpl.h"
 #include "CryptoNoteCore/TransactionExtra.h"
 
+#include <config/CryptoNoteConfig.h>
+
 namespace CryptoNote {
 
 // lhs > hrs
@@ -49,6 +53,10 @@ const Crypto::Hash& TransactionPool::PendingTransactionInfo::getTransactionHash(
   return cachedTransaction.getTransactionHash();
 }
 
+size_t TransactionPool::PendingTransactionInfo::getTransactionSize() const {
+  return cachedTransaction.getTransactionBinaryArray().size();
+}
+
 size_t TransactionPool::PaymentIdHasher::operator() (const boost::optional<Crypto::Hash>& paymentId) const {
   if (!paymentId) {
     return std::numeric_limits<size_t>::max();
@@ -61,6 +69,10 @@ TransactionPool::TransactionPool(Logging::ILogger& logger) :
   transactionHashIndex(transactions.get<TransactionHashTag>()),
   transactionCostIndex(transactions.get<TransactionCostTag>()),
   paymentIdIndex(transactions.get<PaymentIdTag>()),
+  transactionSizeIndex(transactions.get<TransactionSizeTag>()),
+  // a random start, so that a sequence number handed out before a restart is not mistaken for a recent one
+  sequenceNumber(static_cast<uint64_t>(Crypto::rand<uint32_t>()) << 32),
+  changeLog(parameters::CRYPTONOTE_MEMPOOL_CHANGE_LOG_SIZE),
   logger(logger, "TransactionPool") {
 }
 
@@ -83,9 +95,18 @@ bool TransactionPool::pushTransaction(CachedTransaction&& transaction, Transacti
   }
 
   mergeStates(poolState, transactionState);
+  for (const auto& keyImage : transactionState.spentKeyImages) {
+    keyImageIndex.emplace(keyImage, pendingTx.getTransactionHash());
+  }
 
   logger(Logging::DEBUGGING) << "pushed transaction " << pendingTx.getTransactionHash() << " to pool";
-  return transactionHashIndex.emplace(std::move(pendingTx)).second;
+  Crypto::Hash hash = pendingTx.getTransactionHash();
+  if (!transactionHashIndex.emplace(std::move(pendingTx)).second) {
+    return false;
+  }
+
+  logChange(hash, true);
+  return true;
 }
 
 const CachedTransaction& TransactionPool::getTransaction(const Crypto::Hash& hash) const {
@@ -103,7 +124,14 @@ bool TransactionPool::removeTransaction(const Crypto::Hash& hash) {
   }
 
   excludeFromState(poolState, it->cachedTransaction);
+  for (const auto& input : it->cachedTransaction.getTransaction().inputs) {
+    if (input.type() == typeid(KeyInput)) {
+      keyImageIndex.erase(boost::get<KeyInput>(input).keyImage);
+    }
+  }
+
   transactionHashIndex.erase(it);
+  logChange(hash, false);
 
   logger(Logging::DEBUGGING) << "transaction " << hash << " removed from pool";
   return true;
@@ -161,4 +189,58 @@ std::vector<Crypto::Hash> TransactionPool::getTransactionHashesByPaymentId(const
   return transactionHashes;
 }
 
+std::vector<Crypto::Hash> TransactionPool::getTransactionHashesByKeyImages(const TransactionValidatorState& state) const {
+  std::unordered_set<Crypto::Hash> transactionHashes;
+  for (const auto& keyImage : state.spentKeyImages) {
+    auto it = keyImageIndex.find(keyImage);
+    if (it != keyImageIndex.end()) {
+      transactionHashes.insert(it->second);
+    }
+  }
+
+  return std::vector<Crypto::Hash>(transactionHashes.begin(), transactionHashes.end());
+}
+
+std::vector<Crypto::Hash> TransactionPool::getTransactionHashesBiggerThan(size_t size) const {
+  std::vector<Crypto::Hash> transactionHashes;
+  for (auto it = transactionSizeIndex.upper_bound(size); it != transactionSizeIndex.end(); ++it) {
+    transactionHashes.push_back(it->getTransactionHash());
+  }
+
+  return transactionHashes;
+}
+
+uint64_t TransactionPool::getSequenceNumber() const {
+  return sequenceNumber;
+}
+
+bool TransactionPool::getChangesSince(uint64_t sequenceNumber, std::vector<Crypto::Hash>& addedTransactions, std::vector<Crypto::Hash>& deletedTransactions) const {
+  // the oldest sequence number the log still has every change after
+  uint64_t oldestSequenceNumber = changeLog.empty() ? this->sequenceNumber : changeLog.front().sequenceNumber - 1;
+  if (sequenceNumber < oldestSequenceNumber || sequenceNumber > this->sequenceNumber) {
+    return false;
+  }
+
+  std::unordered_set<Crypto::Hash> added;
+  std::unordered_set<Crypto::Hash> deleted;
+  for (auto it = changeLog.begin() + (sequenceNumber - oldestSequenceNumber); it != changeLog.end(); ++it) {
+    // a transaction added and removed again in between is not reported at all, and neither is one removed and added back
+    if (it->added) {
+      if (deleted.erase(it->transactionHash) == 0) {
+        added.insert(it->transactionHash);
+      }
+    } else if (added.erase(it->transactionHash) == 0) {
+      deleted.insert(it->transactionHash);
+    }
+  }
+
+  addedTransactions.assign(added.begin(), added.end());
+  deletedTransactions.assign(deleted.begin(), deleted.end());
+  return true;
+}
+
+void TransactionPool::logChange(const Crypto::Hash& hash, bool added) {
+  changeLog.push_back(PoolChange{++sequenceNumber, hash, added});
+}
+
 }
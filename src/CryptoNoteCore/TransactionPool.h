@@ -26,6 +26,7 @@
 #include <boost/multi_index/member.hpp>
 #include <boost/multi_index/mem_fun.hpp>
 #include <boost/multi_index/ordered_index.hpp>
+#include <boost/circular_buffer.hpp>
 
 #include "ITransactionPool.h"
 #include <Logging/LoggerMessage.h>
@@ -51,6 +52,11 @@ public:
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
+  virtual std::vector<Crypto::Hash> getTransactionHashesByKeyImages(const TransactionValidatorState& state) const override;
+  virtual std::vector<Crypto::Hash> getTransactionHashesBiggerThan(size_t size) const override;
+
+  virtual uint64_t getSequenceNumber() const override;
+  virtual bool getChangesSince(uint64_t sequenceNumber, std::vector<Crypto::Hash>& addedTransactions, std::vector<Crypto::Hash>& deletedTransactions) const override;
 private:
   TransactionValidatorState poolState;
 
@@ -60,6 +66,7 @@ private:
     boost::optional<Crypto::Hash> paymentId;
 
     const Crypto::Hash& getTransactionHash() const;
+    size_t getTransactionSize() const;
   };
 
   struct TransactionPriorityComparator {
@@ -70,6 +77,7 @@ private:
   struct TransactionHashTag {};
   struct TransactionCostTag {};
   struct PaymentIdTag {};
+  struct TransactionSizeTag {};
 
   typedef boost::multi_index::ordered_non_unique<
     boost::multi_index::tag<TransactionCostTag>,
@@ -96,12 +104,22 @@ private:
     PaymentIdHasher
   > PaymentIdIndex;
 
+  typedef boost::multi_index::ordered_non_unique<
+    boost::multi_index::tag<TransactionSizeTag>,
+    boost::multi_index::const_mem_fun<
+      PendingTransactionInfo,
+      size_t,
+      &PendingTransactionInfo::getTransactionSize
+    >
+  > TransactionSizeIndex;
+
   typedef boost::multi_index_container<
     PendingTransactionInfo,
     boost::multi_index::indexed_by<
       TransactionHashIndex,
       TransactionCostIndex,
-      PaymentIdIndex
+      PaymentIdIndex,
+      TransactionSizeIndex
     >
   > TransactionsContainer;
 
@@ -109,7 +127,22 @@ private:
   TransactionsContainer::index<TransactionHashTag>::type& transactionHashIndex;
   TransactionsContainer::index<TransactionCostTag>::type& transactionCostIndex;
   TransactionsContainer::index<PaymentIdTag>::type& paymentIdIndex;
-  
+  TransactionsContainer::index<TransactionSizeTag>::type& transactionSizeIndex;
+  // key image -> hash of the pool transaction spending it, the same key images as poolState has
+  std::unordered_map<Crypto::KeyImage, Crypto::Hash> keyImageIndex;
+
+  struct PoolChange {
+    uint64_t sequenceNumber;
+    Crypto::Hash transactionHash;
+    bool added;
+  };
+
+  void logChange(const Crypto::Hash& hash, bool added);
+
+  uint64_t sequenceNumber;
+  // the last CRYPTONOTE_MEMPOOL_CHANGE_LOG_SIZE changes, sequence numbers are consecutive
+  boost::circular_buffer<PoolChange> changeLog;
+
   Logging::LoggerRef logger;
 };
 
@@ -71,6 +71,22 @@ std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashesByPay
   return transactionPool->getTransactionHashesByPaymentId(paymentId);
 }
 
+std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashesByKeyImages(const TransactionValidatorState& state) const {
+  return transactionPool->getTransactionHashesByKeyImages(state);
+}
+
+std::vector<Crypto::Hash> TransactionPoolCleanWrapper::getTransactionHashesBiggerThan(size_t size) const {
+  return transactionPool->getTransactionHashesBiggerThan(size);
+}
+
+uint64_t TransactionPoolCleanWrapper::getSequenceNumber() const {
+  return transactionPool->getSequenceNumber();
+}
+
+bool TransactionPoolCleanWrapper::getChangesSince(uint64_t sequenceNumber, std::vector<Crypto::Hash>& addedTransactions, std::vector<Crypto::Hash>& deletedTransactions) const {
+  return transactionPool->getChangesSince(sequenceNumber, addedTransactions, deletedTransactions);
+}
+
 std::vector<Crypto::Hash> TransactionPoolCleanWrapper::clean(const uint32_t height) {
   try {
     uint64_t currentTime = timeProvider->now();
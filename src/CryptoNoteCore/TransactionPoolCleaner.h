@@ -50,6 +50,11 @@ public:
 
   virtual uint64_t getTransactionReceiveTime(const Crypto::Hash& hash) const override;
   virtual std::vector<Crypto::Hash> getTransactionHashesByPaymentId(const Crypto::Hash& paymentId) const override;
+  virtual std::vector<Crypto::Hash> getTransactionHashesByKeyImages(const TransactionValidatorState& state) const override;
+  virtual std::vector<Crypto::Hash> getTransactionHashesBiggerThan(size_t size) const override;
+
+  virtual uint64_t getSequenceNumber() const override;
+  virtual bool getChangesSince(uint64_t sequenceNumber, std::vector<Crypto::Hash>& addedTransactions, std::vector<Crypto::Hash>& deletedTransactions) const override;
 
   virtual std::vector<Crypto::Hash> clean(const uint32_t height) override;
 
@@ -0,0 +1,203 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "TransactionView.h"
+
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+#include <config/CryptoNoteConfig.h>
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint8_t BASE_INPUT_TAG = 0xff;
+const uint8_t KEY_INPUT_TAG = 0x2;
+const uint8_t KEY_OUTPUT_TAG = 0x2;
+
+size_t alignOffset(size_t offset) {
+  return (offset + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t);
+}
+
+class Reader {
+public:
+  explicit Reader(const BinaryArray& data) : current(data.data()), end(data.data() + data.size()) {
+  }
+
+  // the same checks as Common::readVarint
+  template<typename T>
+  T readVarint() {
+    const size_t bits = sizeof(T) * 8;
+    uint64_t temp = 0;
+    for (uint8_t shift = 0;; shift += 7) {
+      uint8_t piece = readByte();
+      if (shift >= bits - 7 && piece >= 1 << (bits - shift)) {
+        throw std::runtime_error("TransactionView: varint value overflow");
+      }
+
+      temp |= static_cast<uint64_t>(piece & 0x7f) << shift;
+      if ((piece & 0x80) == 0) {
+        if (piece == 0 && shift != 0) {
+          throw std::runtime_error("TransactionView: invalid varint value representation");
+        }
+
+        break;
+      }
+    }
+
+    return static_cast<T>(temp);
+  }
+
+  uint8_t readByte() {
+    return *readBytes(1);
+  }
+
+  const uint8_t* readBytes(size_t size) {
+    if (static_cast<size_t>(end - current) < size) {
+      throw std::runtime_error("TransactionView: unexpected end of transaction");
+    }
+
+    const uint8_t* bytes = current;
+    current += size;
+    return bytes;
+  }
+
+  bool atEnd() const {
+    return current == end;
+  }
+
+private:
+  const uint8_t* current;
+  const uint8_t* end;
+};
+
+}
+
+TransactionView::TransactionView(const BinaryArray& transactionBinaryArray) {
+  // the first pass only validates and counts, the second one fills the buffer sized from the counts
+  read(transactionBinaryArray, false);
+
+  outputsOffset = alignOffset(inputCount * sizeof(Input));
+  signaturesOffset = alignOffset(outputsOffset + outputCount * sizeof(Output));
+  outputIndexesOffset = alignOffset(signaturesOffset + ringTotal * sizeof(Crypto::Signature));
+  extraOffset = outputIndexesOffset + ringTotal * sizeof(uint32_t);
+  buffer.resize(alignOffset(extraOffset + extraSize) / sizeof(uint64_t));
+
+  read(transactionBinaryArray, true);
+}
+
+uint8_t TransactionView::getVersion() const {
+  return version;
+}
+
+uint64_t TransactionView::getUnlockTime() const {
+  return unlockTime;
+}
+
+Common::ArrayView<TransactionView::Input> TransactionView::getInputs() const {
+  return {reinterpret_cast<const Input*>(getBufferData()), inputCount};
+}
+
+Common::ArrayView<uint32_t> TransactionView::getOutputIndexes(const Input& input) const {
+  return {reinterpret_cast<const uint32_t*>(getBufferData() + outputIndexesOffset) + input.ringBegin, input.ringSize};
+}
+
+Common::ArrayView<TransactionView::Output> TransactionView::getOutputs() const {
+  return {reinterpret_cast<const Output*>(getBufferData() + outputsOffset), outputCount};
+}
+
+Common::ArrayView<Crypto::Signature> TransactionView::getSignatures(const Input& input) const {
+  return {reinterpret_cast<const Crypto::Signature*>(getBufferData() + signaturesOffset) + input.ringBegin, input.ringSize};
+}
+
+Common::ArrayView<uint8_t> TransactionView::getExtra() const {
+  return {getBufferData() + extraOffset, extraSize};
+}
+
+// Follows serialize(Transaction&) for BinaryInputStreamSerializer
+void TransactionView::read(const BinaryArray& transactionBinaryArray, bool store) {
+  Reader reader(transactionBinaryArray);
+  uint8_t* data = getBufferData();
+
+  version = reader.readVarint<uint8_t>();
+  if (CURRENT_TRANSACTION_VERSION < version) {
+    throw std::runtime_error("Wrong transaction version");
+  }
+
+  unlockTime = reader.readVarint<uint64_t>();
+
+  inputCount = reader.readVarint<uint64_t>();
+  ringTotal = 0;
+  for (size_t i = 0; i < inputCount; ++i) {
+    Input input = Input();
+    input.ringBegin = static_cast<uint32_t>(ringTotal);
+
+    uint8_t tag = reader.readByte();
+    if (tag == BASE_INPUT_TAG) {
+      input.isBase = true;
+      input.blockIndex = reader.readVarint<uint32_t>();
+    } else if (tag == KEY_INPUT_TAG) {
+      input.isBase = false;
+      input.amount = reader.readVarint<uint64_t>();
+
+      size_t ringSize = reader.readVarint<uint64_t>();
+      for (size_t j = 0; j < ringSize; ++j) {
+        uint32_t outputIndex = reader.readVarint<uint32_t>();
+        if (store) {
+          reinterpret_cast<uint32_t*>(data + outputIndexesOffset)[ringTotal + j] = outputIndex;
+        }
+      }
+
+      input.ringSize = static_cast<uint32_t>(ringSize);
+      memcpy(&input.keyImage, reader.readBytes(sizeof(input.keyImage)), sizeof(input.keyImage));
+      ringTotal += ringSize;
+    } else {
+      throw std::runtime_error("Unknown variant tag");
+    }
+
+    if (store) {
+      new (data + i * sizeof(Input)) Input(input);
+    }
+  }
+
+  outputCount = reader.readVarint<uint64_t>();
+  for (size_t i = 0; i < outputCount; ++i) {
+    Output output;
+    output.amount = reader.readVarint<uint64_t>();
+    if (reader.readByte() != KEY_OUTPUT_TAG) {
+      throw std::runtime_error("Unknown variant tag");
+    }
+
+    memcpy(&output.key, reader.readBytes(sizeof(output.key)), sizeof(output.key));
+    if (store) {
+      new (data + outputsOffset + i * sizeof(Output)) Output(output);
+    }
+  }
+
+  extraSize = reader.readVarint<uint64_t>();
+  const uint8_t* extra = reader.readBytes(extraSize);
+  if (store && extraSize != 0) {
+    memcpy(data + extraOffset, extra, extraSize);
+  }
+
+  // every input is followed by one signature per ring member, base inputs have none
+  const uint8_t* signatures = reader.readBytes(ringTotal * sizeof(Crypto::Signature));
+  if (store && ringTotal != 0) {
+    memcpy(data + signaturesOffset, signatures, ringTotal * sizeof(Crypto::Signature));
+  }
+
+  if (!reader.atEnd()) {
+    throw std::runtime_error("failed to unpack type");
+  }
+}
+
+const uint8_t* TransactionView::getBufferData() const {
+  return reinterpret_cast<const uint8_t*>(buffer.data());
+}
+
+uint8_t* TransactionView::getBufferData() {
+  return reinterpret_cast<uint8_t*>(buffer.data());
+}
@@ -0,0 +1,68 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <vector>
+
+#include <Common/ArrayView.h>
+#include <CryptoNote.h>
+
+namespace CryptoNote {
+
+// A transaction read straight from its binary form into one buffer. Inputs, output indexes, outputs,
+// signatures and extra are spans of that buffer, so reading a transaction makes a single allocation
+// and builds no boost::variant. The same binary arrays as fromBinaryArray<Transaction> are accepted,
+// anything else throws std::runtime_error.
+class TransactionView {
+public:
+  struct Input {
+    // base inputs only have the block index, key inputs everything else
+    bool isBase;
+    uint32_t blockIndex;
+    uint64_t amount;
+    Crypto::KeyImage keyImage;
+    // where the output indexes and the signatures of the input start, there are ringSize of each
+    uint32_t ringBegin;
+    uint32_t ringSize;
+  };
+
+  struct Output {
+    uint64_t amount;
+    Crypto::PublicKey key;
+  };
+
+  explicit TransactionView(const BinaryArray& transactionBinaryArray);
+
+  uint8_t getVersion() const;
+  uint64_t getUnlockTime() const;
+  Common::ArrayView<Input> getInputs() const;
+  // packed as in KeyInput, the first index is absolute and the others are offsets to the previous one
+  Common::ArrayView<uint32_t> getOutputIndexes(const Input& input) const;
+  Common::ArrayView<Output> getOutputs() const;
+  Common::ArrayView<Crypto::Signature> getSignatures(const Input& input) const;
+  Common::ArrayView<uint8_t> getExtra() const;
+
+private:
+  uint8_t version;
+  uint64_t unlockTime;
+
+  size_t inputCount;
+  size_t ringTotal;
+  size_t outputCount;
+  size_t extraSize;
+
+  // byte offsets of the spans in the buffer, which is made of uint64_t to keep them aligned
+  size_t outputsOffset;
+  size_t signaturesOffset;
+  size_t outputIndexesOffset;
+  size_t extraOffset;
+  std::vector<uint64_t> buffer;
+
+  void read(const BinaryArray& transactionBinaryArray, bool store);
+  const uint8_t* getBufferData() const;
+  uint8_t* getBufferData();
+};
+
+}
@@ -5,13 +5,16 @@
 #undef NDEBUG
 
 #include <iostream>
+#include <algorithm>
 #include <chrono>
+#include <iomanip>
 #include <assert.h>
 
 #include "CryptoNote.h"
 #include "CryptoTypes.h"
 #include "Common/StringTools.h"
 #include "crypto/crypto.h"
+#include "crypto/chacha8.h"
 
 #define PERFORMANCE_ITERATIONS  1000
 
@@ -90,6 +93,81 @@ const std::string CN_SOFT_SHELL_V2[] = {
   "b2172ec9466e1aee70ec8572a14c233ee354582bcb93f869d429744de5726a26"
 };
 
+/* Key derivation vectors: these pin the output of the elliptic curve code so
+   that every field arithmetic backend in crypto-ops can be checked against
+   the reference 32-bit implementation bit for bit */
+const std::string VIEW_SECRET_KEY = "a5e3f76c1b3f1c0c2f6cbb7e6a64c5c2a3b5a1c2d3e4f5061728394a5b6c7d0e";
+const std::string SPEND_SECRET_KEY = "b1c2d3e4f5061728394a5b6c7d8e9fa0b1c2d3e4f5061728394a5b6c7d8e9f0a";
+const std::string TX_SECRET_KEY = "0f1e2d3c4b5a69788796a5b4c3d2e1f00f1e2d3c4b5a69788796a5b4c3d2e10b";
+
+const std::string VIEW_PUBLIC_KEY = "f3a41431ff5c8ab8286de77cacce4029e8faf398fe06f10c9a40ca2502919e90";
+const std::string SPEND_PUBLIC_KEY = "cc28cf96beb4e254ba53499a4952695bf9c23e89365751c7368e98a127b68c40";
+const std::string TX_PUBLIC_KEY = "9c33aa360e8c309b63ed76b5220cff613584de0d76598f44e0dcaa2d4711ee90";
+
+const std::string KEY_DERIVATION = "2ac3a30d3c8d31fb168780b67bb11ec7011962e2a720b8cf44f901b3b2fc4cbc";
+const std::string DERIVED_PUBLIC_KEY = "d4f31a258832238e48817af7d3419654b23aac184a4a1fd9fcdbe7737060cad1";
+const std::string DERIVED_SECRET_KEY = "9a8bc3574f6a92e5fed435a30802d5aa584f2018e09e25f923b0be0b815d6108";
+const std::string KEY_IMAGE = "1ba056bd51a4123a32b5cd0d4760a2087035554451b40e2565e547eba23218b4";
+
+const std::string HASH_TO_EC[] = {
+  "6876d12c0050c3fa21c4277966e23aca6df769a2f9ccd988b94638d4cb5df6b7",
+  "dd9ec8f59fd6d7f0bc877b6c066b735898ba967369b4bc384c60efa919735427",
+  "37b3b295a4a523890b8e7b2ef5aa5885566f5698ef3f2b1b98559fb52da7584b",
+  "91e3535d036c1c5a17bc0abced2f4216b80893f00c0b82cfa084264ec784f1ee",
+  "39d83a596192d21f35a83df67ae50a51d73e771292fb4e5cf4b940c5c90e6404",
+  "7c40277037301e394c8becad739a38185a28520cfb1506674c915986046709f9",
+  "9dee753acb0d3a10c3b3a266efcc4e1a36756ef0c3a5776fd4717ba1e2a946a3",
+  "087cad88135aa6d6938b3da33df267032ae59d529a6eb90d360061d7011a7520"
+};
+
+/* cn_fast_hash of 1000 zero bytes encrypted with key 00 01 .. 1f, iv 00 01 .. 07 */
+const std::string CHACHA8_CIPHER_HASH = "d968b6fa6f5fc119953cacc4ca5d2b955c05af729b5843ebbdc73f3d503e91d7";
+
+/* y = p and y = p - 1, the first one must be rejected as non-canonical */
+const std::string NON_CANONICAL_KEY = "edffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f";
+const std::string CANONICAL_KEY = "ecffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f";
+
+const std::string SIGNATURE = "e75e1a6934e90a29b3dc73020ece1e85738bfbb847591b0fd13bbfb321f2aa0c89843559c778afdad0bbb57fa88acbdbbdde4424e517e1dff0273ae26eac6906";
+
+const std::string RING_KEYS[] = {
+  "b6166c83a18b125361b137d30945bb1a637214b068165a85bd22c6afd626f8aa",
+  "26200843437b429638330d27c6491848470c4c9f6b3408b910a5c2a4764a5db7",
+  "d4f31a258832238e48817af7d3419654b23aac184a4a1fd9fcdbe7737060cad1",
+  "0c25ab9125e5d72b32bd060c88d70db4c4dd7a573bf61901b9def92a4751523a"
+};
+
+const std::string RING_SIGNATURE[] = {
+  "0ce477255164a28fb446ec10202e71a730cea038c0ce9748ddcf955af04dff07e80266560ec02859b732a7409a91c49cda15c63412504352c351e55e1d44b30b",
+  "c758ee892aa10a56a9d7b699e59b9161d6db60ca00e42d5ed7e50c54c55c9509d0d11f1bfc34ad0bb91684fe1b4ba185b85c898a374facedbdababff4bf3860e",
+  "d9bc79c3f66630f1ec0181d489c7b7db0cc42892295962230db229a1d24b4606ac25cb9d6ed51f31d512b78953f4550a0c03c4ae87f4d095643c5421fd961d0d",
+  "500023f83ac939914ec85b1c71f413f8a9088f8a63e612fd4d3edd682984ec00d6be92f2e0696b8900919a3cba2aa371eb54c428b190898a109842568b96d103"
+};
+
+template<typename T>
+static inline T PodFromHex(const std::string& hex)
+{
+  T result = T();
+  bool success = Common::podFromHex(hex, result);
+  assert(success);
+  return result;
+}
+
+/* Times function and reports the cost of one of the operationsPerCall operations it performs */
+template<typename F>
+static inline void Benchmark(const std::string& name, F function, size_t operationsPerCall = 1)
+{
+  const size_t iterations = (PERFORMANCE_ITERATIONS + operationsPerCall - 1) / operationsPerCall;
+  auto startTimer = std::chrono::high_resolution_clock::now();
+  for (size_t i = 0; i < iterations; i++)
+  {
+    function();
+  }
+  auto elapsedTime = std::chrono::high_resolution_clock::now() - startTimer;
+  auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsedTime).count();
+  std::cout << name << ": " << std::fixed << std::setprecision(2)
+            << (nanoseconds / 1000.0 / (iterations * operationsPerCall)) << " us/op\n";
+}
+
 static inline bool CompareHashes(const Hash leftHash, const std::string right)
 {
   Hash rightHash = Hash();
@@ -112,6 +190,64 @@ int main(int argc, char** argv) {
     std::cout << "cn_fast_hash: " << Common::toHex(&hash, sizeof(Hash)) << "\n";
     assert(CompareHashes(hash, CN_FAST_HASH));
 
+    /* The batched hashes must match cn_fast_hash for messages of mixed block counts */
+    std::vector<const void*> manyData;
+    std::vector<size_t> manyLengths;
+    std::vector<Hash> manyHashes(3 * HASH_DATA_AREA);
+    std::vector<Hash*> manyHashPointers;
+    std::vector<uint8_t> longData(4 * HASH_DATA_AREA);
+    for (size_t i = 0; i < longData.size(); i++)
+    {
+      longData[i] = rawData[i % rawData.size()];
+    }
+    for (size_t i = 0; i < manyHashes.size(); i++)
+    {
+      manyData.push_back(longData.data());
+      manyLengths.push_back((i * 7) % (longData.size() + 1));
+      manyHashPointers.push_back(&manyHashes[i]);
+    }
+    cn_fast_hash_many(manyData.data(), manyLengths.data(), manyHashPointers.data(), manyHashes.size());
+    for (size_t i = 0; i < manyHashes.size(); i++)
+    {
+      assert(manyHashes[i] == cn_fast_hash(manyData[i], manyLengths[i]));
+    }
+
+    /* tree_hash hashes its levels with cn_fast_hash_many, tree_hash_from_branch does not */
+    for (size_t count = 1; count <= 70; count++)
+    {
+      Hash root, branchRoot;
+      std::vector<Hash> branch(64);
+      tree_hash(manyHashes.data(), count, root);
+      tree_branch(manyHashes.data(), count, branch.data());
+      tree_hash_from_branch(branch.data(), tree_depth(count), manyHashes[0], nullptr, branchRoot);
+      assert(root == branchRoot);
+    }
+    std::cout << "cn_fast_hash_many / tree_hash: OK\n";
+
+    /* chacha8 must give the same cipher in one call and when streamed in uneven chunks */
+    chacha8_key chachaKey;
+    chacha8_iv chachaIv;
+    for (size_t i = 0; i < sizeof(chachaKey.data); i++)
+    {
+      chachaKey.data[i] = static_cast<uint8_t>(i);
+    }
+    for (size_t i = 0; i < sizeof(chachaIv.data); i++)
+    {
+      chachaIv.data[i] = static_cast<uint8_t>(i);
+    }
+    std::vector<char> plain(1000), cipher(1000), streamedCipher(1000);
+    chacha8(plain.data(), plain.size(), chachaKey, chachaIv, cipher.data());
+    assert(CompareHashes(cn_fast_hash(cipher.data(), cipher.size()), CHACHA8_CIPHER_HASH));
+    chacha8_state chachaState;
+    chacha8_init(chachaState, chachaKey, chachaIv);
+    for (size_t offset = 0, chunk = 1; offset < plain.size(); offset += chunk, chunk = chunk * 3 + 1)
+    {
+      chunk = std::min(chunk, plain.size() - offset);
+      chacha8_update(chachaState, plain.data() + offset, chunk, streamedCipher.data() + offset);
+    }
+    assert(streamedCipher == cipher);
+    std::cout << "chacha8: OK\n";
+
     std::cout << "\n";
 
     cn_slow_hash_v0(rawData.data(), rawData.size(), hash);
@@ -170,6 +306,190 @@ int main(int argc, char** argv) {
       }
     }
 
+    std::cout << "\n";
+
+    const SecretKey viewSecretKey = PodFromHex<SecretKey>(VIEW_SECRET_KEY);
+    const SecretKey spendSecretKey = PodFromHex<SecretKey>(SPEND_SECRET_KEY);
+    const SecretKey txSecretKey = PodFromHex<SecretKey>(TX_SECRET_KEY);
+
+    PublicKey viewPublicKey, spendPublicKey, txPublicKey;
+    assert(secret_key_to_public_key(viewSecretKey, viewPublicKey));
+    assert(secret_key_to_public_key(spendSecretKey, spendPublicKey));
+    assert(secret_key_to_public_key(txSecretKey, txPublicKey));
+    assert(viewPublicKey == PodFromHex<PublicKey>(VIEW_PUBLIC_KEY));
+    assert(spendPublicKey == PodFromHex<PublicKey>(SPEND_PUBLIC_KEY));
+    assert(txPublicKey == PodFromHex<PublicKey>(TX_PUBLIC_KEY));
+    std::cout << "secret_key_to_public_key: " << Common::podToHex(txPublicKey) << "\n";
+
+    KeyDerivation derivation, senderDerivation;
+    assert(generate_key_derivation(txPublicKey, viewSecretKey, derivation));
+    assert(generate_key_derivation(viewPublicKey, txSecretKey, senderDerivation));
+    assert(Common::podToHex(derivation) == KEY_DERIVATION);
+    assert(Common::podToHex(senderDerivation) == KEY_DERIVATION);
+    std::cout << "generate_key_derivation: " << Common::podToHex(derivation) << "\n";
+
+    PublicKey derivedPublicKey, underivedPublicKey;
+    SecretKey derivedSecretKey;
+    assert(derive_public_key(derivation, 1, spendPublicKey, derivedPublicKey));
+    derive_secret_key(derivation, 1, spendSecretKey, derivedSecretKey);
+    assert(underive_public_key(derivation, 1, derivedPublicKey, underivedPublicKey));
+    assert(derivedPublicKey == PodFromHex<PublicKey>(DERIVED_PUBLIC_KEY));
+    assert(derivedSecretKey == PodFromHex<SecretKey>(DERIVED_SECRET_KEY));
+    assert(underivedPublicKey == spendPublicKey);
+    std::cout << "derive_public_key: " << Common::podToHex(derivedPublicKey) << "\n";
+
+    /* The batched versions must agree with the single ones, including on invalid points */
+    const std::vector<PublicKey> batchKeys = { txPublicKey, PodFromHex<PublicKey>(NON_CANONICAL_KEY), viewPublicKey, derivedPublicKey };
+    std::vector<KeyDerivation> batchDerivations;
+    std::vector<bool> batchValid;
+    generate_key_derivations(batchKeys, viewSecretKey, batchDerivations, batchValid);
+    assert(batchDerivations.size() == batchKeys.size() && batchValid.size() == batchKeys.size());
+    for (size_t i = 0; i < batchKeys.size(); i++)
+    {
+      KeyDerivation single;
+      assert(batchValid[i] == generate_key_derivation(batchKeys[i], viewSecretKey, single));
+      assert(!batchValid[i] || Common::podToHex(batchDerivations[i]) == Common::podToHex(single));
+    }
+
+    PreparedSecretKey preparedViewSecretKey;
+    prepare_secret_key(viewSecretKey, preparedViewSecretKey);
+    std::vector<KeyDerivation> preparedDerivations;
+    std::vector<bool> preparedValid;
+    generate_key_derivations(batchKeys, preparedViewSecretKey, preparedDerivations, preparedValid);
+    assert(preparedValid == batchValid);
+    for (size_t i = 0; i < batchKeys.size(); i++)
+    {
+      KeyDerivation single;
+      assert(preparedValid[i] == generate_key_derivation(batchKeys[i], preparedViewSecretKey, single));
+      assert(!preparedValid[i] || Common::podToHex(preparedDerivations[i]) == Common::podToHex(batchDerivations[i]));
+      assert(!preparedValid[i] || Common::podToHex(single) == Common::podToHex(batchDerivations[i]));
+    }
+
+    std::vector<PublicKey> batchBases;
+    const std::vector<size_t> batchIndexes = { 1, 0, 1, 2 };
+    underive_public_keys(std::vector<KeyDerivation>(batchKeys.size(), derivation), batchIndexes, batchKeys, batchBases, batchValid);
+    assert(batchBases[2] == spendPublicKey || batchKeys[2] != derivedPublicKey);
+    assert(batchBases[3] == spendPublicKey || batchIndexes[3] != 1);
+    for (size_t i = 0; i < batchKeys.size(); i++)
+    {
+      PublicKey single;
+      assert(batchValid[i] == underive_public_key(derivation, batchIndexes[i], batchKeys[i], single));
+      assert(!batchValid[i] || batchBases[i] == single);
+    }
+    std::cout << "generate_key_derivations / underive_public_keys: OK\n";
+
+    KeyImage keyImage;
+    generate_key_image(derivedPublicKey, derivedSecretKey, keyImage);
+    assert(keyImage == PodFromHex<KeyImage>(KEY_IMAGE));
+    std::cout << "generate_key_image: " << Common::podToHex(keyImage) << "\n";
+
+    for (char c = '0'; c < '8'; c++)
+    {
+      PublicKey point;
+      hash_data_to_ec(reinterpret_cast<const uint8_t*>(&c), 1, point);
+      assert(point == PodFromHex<PublicKey>(HASH_TO_EC[c - '0']));
+    }
+
+    assert(!check_key(PodFromHex<PublicKey>(NON_CANONICAL_KEY)));
+    assert(check_key(PodFromHex<PublicKey>(CANONICAL_KEY)));
+
+    Hash prefixHash;
+    cn_fast_hash("prefix", 6, prefixHash);
+
+    const Signature signature = PodFromHex<Signature>(SIGNATURE);
+    assert(check_signature(prefixHash, derivedPublicKey, signature));
+
+    PublicKey ringKeys[4];
+    Signature ringSignature[4];
+    const PublicKey* ring[4];
+    for (size_t i = 0; i < 4; i++)
+    {
+      ringKeys[i] = PodFromHex<PublicKey>(RING_KEYS[i]);
+      ringSignature[i] = PodFromHex<Signature>(RING_SIGNATURE[i]);
+      ring[i] = &ringKeys[i];
+    }
+    assert(check_ring_signature(prefixHash, keyImage, ring, 4, ringSignature, true));
+    ringSignature[1].data[0] ^= 1;
+    assert(!check_ring_signature(prefixHash, keyImage, ring, 4, ringSignature, true));
+    ringSignature[1].data[0] ^= 1;
+    std::cout << "check_ring_signature: OK\n";
+
+#if defined(CRYPTO_OPS_FE51) && defined(__SIZEOF_INT128__)
+    std::cout << "\nField arithmetic: 64-bit (radix 2^51)\n\n";
+#else
+    std::cout << "\nField arithmetic: 32-bit (radix 2^25.5)\n\n";
+#endif
+
+    Benchmark("cn_fast_hash (64 bytes)", [&]() {
+      cn_fast_hash(manyHashes.data(), 2 * sizeof(Hash), hash);
+    });
+
+    const std::vector<const void*> pairData(64, manyHashes.data());
+    const std::vector<size_t> pairLengths(64, 2 * sizeof(Hash));
+    Benchmark("cn_fast_hash_many (64 bytes, batches of 64)", [&]() {
+      cn_fast_hash_many(pairData.data(), pairLengths.data(), manyHashPointers.data(), pairData.size());
+    }, pairData.size());
+
+    Benchmark("tree_hash (256 hashes)", [&]() {
+      tree_hash(manyHashes.data(), 256, hash);
+    }, 255);
+
+    for (size_t kilobytes : { 64, 1024, 16 * 1024 })
+    {
+      std::vector<char> container(kilobytes * 1024);
+      Benchmark("chacha8 (" + std::to_string(kilobytes) + " KiB container, per KiB)", [&]() {
+        chacha8(container.data(), container.size(), chachaKey, chachaIv, container.data());
+      }, kilobytes);
+    }
+
+    Benchmark("generate_key_derivation", [&]() {
+      generate_key_derivation(txPublicKey, viewSecretKey, derivation);
+    });
+
+    const std::vector<PublicKey> scanKeys(64, txPublicKey);
+    Benchmark("generate_key_derivations (batches of 64)", [&]() {
+      generate_key_derivations(scanKeys, viewSecretKey, batchDerivations, batchValid);
+    }, scanKeys.size());
+
+    Benchmark("generate_key_derivation (prepared key)", [&]() {
+      generate_key_derivation(txPublicKey, preparedViewSecretKey, derivation);
+    });
+
+    Benchmark("generate_key_derivations (prepared key, batches of 64)", [&]() {
+      generate_key_derivations(scanKeys, preparedViewSecretKey, batchDerivations, batchValid);
+    }, scanKeys.size());
+
+    Benchmark("underive_public_key", [&]() {
+      underive_public_key(derivation, 1, derivedPublicKey, underivedPublicKey);
+    });
+
+    const std::vector<KeyDerivation> scanDerivations(64, derivation);
+    const std::vector<size_t> scanIndexes(64, 1);
+    const std::vector<PublicKey> scanOutputKeys(64, derivedPublicKey);
+    Benchmark("underive_public_keys (batches of 64)", [&]() {
+      underive_public_keys(scanDerivations, scanIndexes, scanOutputKeys, batchBases, batchValid);
+    }, scanOutputKeys.size());
+
+    Benchmark("derive_public_key", [&]() {
+      derive_public_key(derivation, 1, spendPublicKey, derivedPublicKey);
+    });
+
+    Benchmark("generate_key_image", [&]() {
+      generate_key_image(derivedPublicKey, derivedSecretKey, keyImage);
+    });
+
+    Benchmark("check_key", [&]() {
+      check_key(derivedPublicKey);
+    });
+
+    Benchmark("check_signature", [&]() {
+      check_signature(prefixHash, derivedPublicKey, signature);
+    });
+
+    Benchmark("check_ring_signature (4 keys)", [&]() {
+      check_ring_signature(prefixHash, keyImage, ring, 4, ringSignature, true);
+    });
+
     std::cout <<  "\nPerformance Tests: Please wait, this may take a while depending on your system...\n\n";
 
     auto startTimer = std::chrono::high_resolution_clock::now();
@@ -32,6 +32,8 @@
 #include "Rpc/RpcServerConfig.h"
 #include "Serialization/BinaryInputStreamSerializer.h"
 #include "Serialization/BinaryOutputStreamSerializer.h"
+#include "System/Context.h"
+#include "System/Timer.h"
 #include "version.h"
 
 #include <config/Ascii.h>
@@ -68,6 +70,10 @@ namespace
   const command_line::arg_descriptor<std::string> arg_load_checkpoints   = {"load-checkpoints", "<default|filename> Use builtin default checkpoints or checkpoint csv file for faster initial blockchain sync", "default"};
   const command_line::arg_descriptor<std::string> arg_set_fee_address = { "fee-address", "Sets fee address for light wallets that use the daemon.", "" };
   const command_line::arg_descriptor<int> arg_set_fee_amount = { "fee-amount", "Sets the fee amount for the light wallets that use the daemon.", 0 };
+  const command_line::arg_descriptor<uint32_t> arg_explorer_cache_size = { "explorer-cache-size", "Memory in MB used to keep block and transaction details for the explorer calls, 0 disables it",
+    static_cast<uint32_t>(CryptoNote::parameters::EXPLORER_CACHE_DEFAULT_SIZE / (1024 * 1024)) };
+  const command_line::arg_descriptor<uint32_t> arg_memory_segment_depth = { "memory-segment-depth", "Number of the newest main chain blocks kept in memory, so that a fork among them doesn't write to the database, 0 writes every block straight away",
+    CryptoNote::parameters::CRYPTONOTE_MEMORY_SEGMENT_DEFAULT_DEPTH };
 }
 
 bool command_line_preprocessor(const boost::program_options::variables_map& vm, LoggerRef& logger);
@@ -172,6 +178,8 @@ int main(int argc, char* argv[])
     command_line::add_arg(desc_cmd_sett, arg_load_checkpoints);
     command_line::add_arg(desc_cmd_sett, arg_set_fee_address);
     command_line::add_arg(desc_cmd_sett, arg_set_fee_amount);
+    command_line::add_arg(desc_cmd_sett, arg_explorer_cache_size);
+    command_line::add_arg(desc_cmd_sett, arg_memory_segment_depth);
     
     RpcServerConfig::initOptions(desc_cmd_sett);
     NetNodeConfig::initOptions(desc_cmd_sett);
@@ -313,19 +321,49 @@ int main(int argc, char* argv[])
       dbShutdownOnExit.resume();
     }
 
+    // the chain below the last checkpoint is never reverted, so on request the database takes it in bulk until the core gets there
+    std::vector<uint32_t> checkpointHeights = checkpoints.getCheckpointHeights();
+    uint32_t lastCheckpointIndex = checkpointHeights.empty() ? 0 : checkpointHeights.back();
+    bool bulkLoad = dbConfig.getBulkLoad() && lastCheckpointIndex != 0;
+    if (bulkLoad) {
+      database.beginBulkLoad();
+    }
+
     System::Dispatcher dispatcher;
     logger(INFO) << "Initializing core...";
+    // the database reads raw blocks from the main chain storage, which is owned by the core
+    std::unique_ptr<IMainChainStorage> mainChainStorage = createSwappedMainChainStorage(data_dir_path.string(), currency);
+    std::unique_ptr<IBlockchainCacheFactory> blockchainCacheFactory(new DatabaseBlockchainCacheFactory(database, *mainChainStorage,
+      (data_dir_path / CryptoNote::parameters::CRYPTONOTE_CACHE_SNAPSHOT_FILENAME).string(), logger.getLogger()));
     CryptoNote::Core ccore(
       currency,
       logManager,
       std::move(checkpoints),
       dispatcher,
-      std::unique_ptr<IBlockchainCacheFactory>(new DatabaseBlockchainCacheFactory(database, logger.getLogger())),
-      createSwappedMainChainStorage(data_dir_path.string(), currency));
+      std::move(blockchainCacheFactory),
+      std::move(mainChainStorage));
 
+    ccore.setExplorerCacheSize(static_cast<size_t>(command_line::get_arg(vm, arg_explorer_cache_size)) * 1024 * 1024);
+    ccore.setMemorySegmentDepth(command_line::get_arg(vm, arg_memory_segment_depth));
     ccore.load();
     logger(INFO) << "Core initialized OK";
 
+    std::unique_ptr<System::Context<>> bulkLoadContext;
+    if (bulkLoad) {
+      // nobody waits for this context, so errors are reported here and shutdown() tries again
+      bulkLoadContext.reset(new System::Context<>(dispatcher, [&dispatcher, &ccore, &database, &logger, lastCheckpointIndex] {
+        System::Timer timer(dispatcher);
+        while (ccore.getTopBlockIndex() < lastCheckpointIndex) {
+          timer.sleep(std::chrono::seconds(5));
+        }
+
+        auto error = database.endBulkLoad();
+        if (error) {
+          logger(ERROR, BRIGHT_RED) << "Failed to finish the DB bulk load: " << error.message();
+        }
+      }));
+    }
+
     CryptoNote::CryptoNoteProtocolHandler cprotocol(currency, dispatcher, ccore, nullptr, logManager);
     CryptoNote::NodeServer p2psrv(dispatcher, cprotocol, logManager);
     CryptoNote::RpcServer rpcServer(dispatcher, logManager, ccore, p2psrv, cprotocol);
@@ -58,6 +58,7 @@ DaemonCommandsHandler::DaemonCommandsHandler(CryptoNote::Core& core, CryptoNote:
   m_consoleHandler.setHandler("print_tx", boost::bind(&DaemonCommandsHandler::print_tx, this, _1), "Print transaction, print_tx <transaction_hash>");
   m_consoleHandler.setHandler("print_pool", boost::bind(&DaemonCommandsHandler::print_pool, this, _1), "Print transaction pool (long format)");
   m_consoleHandler.setHandler("print_pool_sh", boost::bind(&DaemonCommandsHandler::print_pool_sh, this, _1), "Print transaction pool (short format)");
+  m_consoleHandler.setHandler("print_explorer_cache", boost::bind(&DaemonCommandsHandler::print_explorer_cache, this, _1), "Print usage and hit rate of the block and transaction details cache");
   m_consoleHandler.setHandler("set_log", boost::bind(&DaemonCommandsHandler::set_log, this, _1), "set_log <level> - Change current log level, <level> is a number 0-4");
   m_consoleHandler.setHandler("status", boost::bind(&DaemonCommandsHandler::status, this, _1), "Show daemon status");
 }
@@ -314,6 +315,19 @@ bool DaemonCommandsHandler::print_pool_sh(const std::vector<std::string>& args)
   return true;
 }
 //--------------------------------------------------------------------------------
+bool DaemonCommandsHandler::print_explorer_cache(const std::vector<std::string>& args)
+{
+  auto statistics = m_core.getExplorerCacheStatistics();
+  uint64_t requests = statistics.hits + statistics.misses;
+
+  std::cout << "Explorer cache: " << statistics.blockCount << " blocks, " << statistics.transactionCount << " transactions, "
+            << statistics.size / 1024 << " / " << statistics.maxSize / 1024 << " KB" << std::endl
+            << "Hits: " << statistics.hits << ", misses: " << statistics.misses << ", hit rate: "
+            << (requests == 0 ? 0 : statistics.hits * 100 / requests) << "%" << std::endl;
+
+  return true;
+}
+//--------------------------------------------------------------------------------
 bool DaemonCommandsHandler::status(const std::vector<std::string>& args)
 {
   CryptoNote::COMMAND_RPC_GET_INFO::request ireq;
@@ -0,0 +1,140 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "HttpConnection.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <System/TcpConnection.h>
+
+#include "HttpParserErrorCodes.h"
+
+namespace CryptoNote {
+
+namespace {
+
+const size_t READ_SIZE = 4096;
+// a body is allocated as it arrives, so a bogus Content-Length can't reserve memory up front
+const size_t BODY_CHUNK_SIZE = 1024 * 1024;
+// written messages are sent once this much is collected, however many requests are still buffered
+const size_t MAX_WRITE_BUFFER_SIZE = 1024 * 1024;
+
+}
+
+HttpConnection::HttpConnection(System::TcpConnection& connection) : connection(connection), readBegin(0), readEnd(0) {
+}
+
+bool HttpConnection::readRequest(HttpRequest& request) {
+  size_t headSize;
+  while ((headSize = parser.parseRequestHead(readBuffer.data() + readBegin, readEnd - readBegin, request)) == 0) {
+    if (!fill()) {
+      if (readBegin == readEnd) {
+        return false;
+      }
+
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::END_OF_STREAM));
+    }
+  }
+
+  readBegin += headSize;
+  request.setBody(readBody(HttpParser::getBodyLen(request.getHeaders())));
+  return true;
+}
+
+void HttpConnection::readResponse(HttpResponse& response) {
+  size_t headSize;
+  while ((headSize = parser.parseResponseHead(readBuffer.data() + readBegin, readEnd - readBegin, response)) == 0) {
+    if (!fill()) {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::END_OF_STREAM));
+    }
+  }
+
+  readBegin += headSize;
+  response.setBody(readBody(HttpParser::getBodyLen(response.getHeaders())));
+}
+
+void HttpConnection::writeRequest(const HttpRequest& request) {
+  request.appendTo(writeBuffer);
+  if (writeBuffer.size() >= MAX_WRITE_BUFFER_SIZE) {
+    flush();
+  }
+}
+
+void HttpConnection::writeResponse(const HttpResponse& response) {
+  response.appendTo(writeBuffer);
+  if (writeBuffer.size() >= MAX_WRITE_BUFFER_SIZE) {
+    flush();
+  }
+}
+
+void HttpConnection::flush() {
+  size_t offset = 0;
+  while (offset < writeBuffer.size()) {
+    offset += connection.write(reinterpret_cast<const uint8_t*>(writeBuffer.data()) + offset, writeBuffer.size() - offset);
+  }
+
+  writeBuffer.clear();
+}
+
+bool HttpConnection::fill() {
+  // the peer may be waiting for our answers before sending anything else
+  flush();
+
+  if (readBegin == readEnd) {
+    readBegin = 0;
+    readEnd = 0;
+  } else if (readBegin != 0 && readBuffer.size() - readEnd < READ_SIZE) {
+    std::memmove(readBuffer.data(), readBuffer.data() + readBegin, readEnd - readBegin);
+    readEnd -= readBegin;
+    readBegin = 0;
+  }
+
+  if (readBuffer.size() - readEnd < READ_SIZE) {
+    readBuffer.resize(readEnd + READ_SIZE);
+  }
+
+  size_t transferred = connection.read(reinterpret_cast<uint8_t*>(readBuffer.data()) + readEnd, readBuffer.size() - readEnd);
+  if (transferred == 0) {
+    return false;
+  }
+
+  readEnd += transferred;
+  return true;
+}
+
+std::string HttpConnection::readBody(size_t length) {
+  // the rest of a short body comes through the buffer, together with whatever is pipelined after it
+  while (readEnd - readBegin < length && length - (readEnd - readBegin) <= READ_SIZE) {
+    if (!fill()) {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::END_OF_STREAM));
+    }
+  }
+
+  size_t buffered = std::min(length, readEnd - readBegin);
+  std::string body(readBuffer.data() + readBegin, buffered);
+  readBegin += buffered;
+
+  if (body.size() < length) {
+    flush();
+  }
+
+  while (body.size() < length) {
+    size_t offset = body.size();
+    body.resize(std::min(length, offset + BODY_CHUNK_SIZE));
+
+    while (offset < body.size()) {
+      size_t transferred = connection.read(reinterpret_cast<uint8_t*>(&body[offset]), body.size() - offset);
+      if (transferred == 0) {
+        throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::END_OF_STREAM));
+      }
+
+      offset += transferred;
+    }
+  }
+
+  return body;
+}
+
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "HttpParser.h"
+
+namespace System {
+class TcpConnection;
+}
+
+namespace CryptoNote {
+
+// Reads and writes HTTP messages on a connection through reusable buffers. Heads are parsed in place
+// from the read buffer, bytes of the next pipelined message stay there for the next read, and large
+// bodies are read straight into their own storage. Written messages are collected and sent together
+// before the connection is read again, when flushed, or once 1 MiB is collected, so answers to a
+// pipelined batch go out in one send.
+class HttpConnection {
+public:
+  explicit HttpConnection(System::TcpConnection& connection);
+  HttpConnection(const HttpConnection&) = delete;
+  HttpConnection& operator=(const HttpConnection&) = delete;
+
+  // Returns false if the peer closed the connection before starting another request
+  bool readRequest(HttpRequest& request);
+  void readResponse(HttpResponse& response);
+
+  void writeRequest(const HttpRequest& request);
+  void writeResponse(const HttpResponse& response);
+  void flush();
+
+private:
+  System::TcpConnection& connection;
+  HttpParser parser;
+
+  std::vector<char> readBuffer;
+  // unparsed data is [readBegin, readEnd)
+  size_t readBegin;
+  size_t readEnd;
+  std::string writeBuffer;
+
+  bool fill();
+  std::string readBody(size_t length);
+};
+
+}
@@ -33,6 +33,63 @@ void throwIfNotGood(std::istream& stream) {
   }
 }
 
+// a longer head is refused rather than buffered without limit
+const size_t MAX_HEAD_SIZE = 64 * 1024;
+
+size_t findHeadSize(const char* data, size_t size) {
+  static const char EMPTY_LINE[] = "\r\n\r\n";
+  const char* end = std::search(data, data + size, EMPTY_LINE, EMPTY_LINE + 4);
+  if (end == data + size) {
+    if (size >= MAX_HEAD_SIZE) {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::HEADER_TOO_LARGE));
+    }
+
+    return 0;
+  }
+
+  return end - data + 4;
+}
+
+const char* findLineEnd(const char* begin, const char* end) {
+  const char* lineEnd = std::find(begin, end, '\r');
+  if (end - lineEnd < 2 || lineEnd[1] != '\n') {
+    throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
+  }
+
+  return lineEnd;
+}
+
+const char* findSpace(const char* begin, const char* end) {
+  const char* space = std::find(begin, end, ' ');
+  if (space == end) {
+    throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::UNEXPECTED_SYMBOL));
+  }
+
+  return space;
+}
+
+// Parses the header lines in [line, headEnd), headEnd points after the empty line
+template <typename AddHeader>
+void parseHeaders(const char* line, const char* headEnd, AddHeader addHeader) {
+  while (line != headEnd - 2) {
+    const char* lineEnd = findLineEnd(line, headEnd);
+    const char* colon = std::find(line, lineEnd, ':');
+    if (colon == line) {
+      throw std::system_error(make_error_code(CryptoNote::error::HttpParserErrorCodes::EMPTY_HEADER));
+    }
+
+    const char* value = colon == lineEnd ? lineEnd : colon + 1;
+    while (value != lineEnd && (*value == ' ' || *value == '\t')) {
+      ++value;
+    }
+
+    std::string name(line, colon);
+    std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+    addHeader(name, std::string(value, lineEnd));
+    line = lineEnd + 2;
+  }
+}
+
 }
 
 namespace CryptoNote {
@@ -115,6 +172,46 @@ void HttpParser::receiveResponse(std::istream& stream, HttpResponse& response) {
 }
 
 
+size_t HttpParser::parseRequestHead(const char* data, size_t size, HttpRequest& request) {
+  size_t headSize = findHeadSize(data, size);
+  if (headSize == 0) {
+    return 0;
+  }
+
+  const char* headEnd = data + headSize;
+  const char* lineEnd = findLineEnd(data, headEnd);
+  const char* methodEnd = findSpace(data, lineEnd);
+  const char* urlEnd = findSpace(methodEnd + 1, lineEnd);
+
+  request.method.assign(data, methodEnd);
+  request.url.assign(methodEnd + 1, urlEnd);
+
+  parseHeaders(lineEnd + 2, headEnd, [&request](const std::string& name, const std::string& value) {
+    request.headers[name] = value;
+  });
+
+  return headSize;
+}
+
+size_t HttpParser::parseResponseHead(const char* data, size_t size, HttpResponse& response) {
+  size_t headSize = findHeadSize(data, size);
+  if (headSize == 0) {
+    return 0;
+  }
+
+  const char* headEnd = data + headSize;
+  const char* lineEnd = findLineEnd(data, headEnd);
+  const char* versionEnd = findSpace(data, lineEnd);
+
+  response.setStatus(parseResponseStatusFromString(std::string(versionEnd + 1, lineEnd)));
+
+  parseHeaders(lineEnd + 2, headEnd, [&response](const std::string& name, const std::string& value) {
+    response.addHeader(name, value);
+  });
+
+  return headSize;
+}
+
 void HttpParser::readWord(std::istream& stream, std::string& word) {
   char c;
 
@@ -34,11 +34,17 @@ public:
   void receiveRequest(std::istream& stream, HttpRequest& request);
   void receiveResponse(std::istream& stream, HttpResponse& response);
   static HttpResponse::HTTP_STATUS parseResponseStatusFromString(const std::string& status);
+
+  // Parse the request line or status line and the headers at the start of data, the body is left to the caller.
+  // Return the size of the head including the empty line, or 0 if data doesn't hold the whole head yet.
+  size_t parseRequestHead(const char* data, size_t size, HttpRequest& request);
+  size_t parseResponseHead(const char* data, size_t size, HttpResponse& response);
+
+  static size_t getBodyLen(const HttpRequest::Headers& headers);
 private:
   void readWord(std::istream& stream, std::string& word);
   void readHeaders(std::istream& stream, HttpRequest::Headers &headers);
   bool readHeader(std::istream& stream, std::string& name, std::string& value);
-  size_t getBodyLen(const HttpRequest::Headers& headers);
   void readBody(std::istream& stream, std::string& body, const size_t bodyLen);
 };
 
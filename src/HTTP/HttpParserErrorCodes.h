@@ -27,7 +27,8 @@ enum HttpParserErrorCodes {
   STREAM_NOT_GOOD = 1,
   END_OF_STREAM,
   UNEXPECTED_SYMBOL,
-  EMPTY_HEADER
+  EMPTY_HEADER,
+  HEADER_TOO_LARGE
 };
 
 // custom category:
@@ -49,6 +50,7 @@ public:
       case END_OF_STREAM: return "The stream is ended";
       case UNEXPECTED_SYMBOL: return "Unexpected symbol";
       case EMPTY_HEADER: return "The header name is empty";
+      case HEADER_TOO_LARGE: return "The message header is too large";
       default: return "Unknown error";
     }
   }
@@ -33,8 +33,12 @@ namespace CryptoNote {
 
     void addHeader(const std::string& name, const std::string& value);
     void setBody(const std::string& b);
+    void setBody(std::string&& b);
     void setUrl(const std::string& uri);
 
+    // Appends the request as it is sent
+    void appendTo(std::string& buffer) const;
+
   private:
     friend class HttpParser;
 
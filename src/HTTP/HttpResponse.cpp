@@ -71,7 +71,11 @@ void HttpResponse::addHeader(const std::string& name, const std::string& value)
 }
 
 void HttpResponse::setBody(const std::string& b) {
-  body = b;
+  setBody(std::string(b));
+}
+
+void HttpResponse::setBody(std::string&& b) {
+  body = std::move(b);
   if (!body.empty()) {
     headers["Content-Length"] = std::to_string(body.size());
   } else {
@@ -79,19 +83,26 @@ void HttpResponse::setBody(const std::string& b) {
   }
 }
 
-std::ostream& HttpResponse::printHttpResponse(std::ostream& os) const {
-  os << "HTTP/1.1 " << getStatusString(status) << "\r\n";
+void HttpResponse::appendTo(std::string& buffer) const {
+  buffer += "HTTP/1.1 ";
+  buffer += getStatusString(status);
+  buffer += "\r\n";
 
-  for (auto pair: headers) {
-    os << pair.first << ": " << pair.second << "\r\n";
+  for (const auto& pair: headers) {
+    buffer += pair.first;
+    buffer += ": ";
+    buffer += pair.second;
+    buffer += "\r\n";
   }
-  os << "\r\n";
 
-  if (!body.empty()) {
-    os << body;
-  }
+  buffer += "\r\n";
+  buffer += body;
+}
 
-  return os;
+std::ostream& HttpResponse::printHttpResponse(std::ostream& os) const {
+  std::string buffer;
+  appendTo(buffer);
+  return os << buffer;
 }
 
 } //namespace CryptoNote
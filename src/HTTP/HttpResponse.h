@@ -36,6 +36,10 @@ namespace CryptoNote {
     void setStatus(HTTP_STATUS s);
     void addHeader(const std::string& name, const std::string& value);
     void setBody(const std::string& b);
+    void setBody(std::string&& b);
+
+    // Appends the response as it is sent
+    void appendTo(std::string& buffer) const;
 
     const std::map<std::string, std::string>& getHeaders() const { return headers; }
     HTTP_STATUS getStatus() const { return status; }
@@ -90,6 +90,8 @@ void NodeRpcProxy::resetInternalState() {
   lastLocalBlockHeaderInfo.difficulty = 0;
   lastLocalBlockHeaderInfo.reward = 0;
   m_knownTxs.clear();
+  m_poolSequence = 0;
+  m_poolChangesSinceSupported = true;
 }
 
 void NodeRpcProxy::init(const INode::Callback& callback) {
@@ -175,22 +177,36 @@ void NodeRpcProxy::updateNodeStatus() {
 }
 
 bool NodeRpcProxy::updatePoolStatus() {
-  std::vector<Crypto::Hash> knownTxs = getKnownTxsVector();
   Crypto::Hash tailBlock = lastLocalBlockHeaderInfo.hash;
 
   bool isBcActual = false;
+  uint64_t sequence = 0;
   std::vector<std::unique_ptr<ITransactionReader>> addedTxs;
   std::vector<Crypto::Hash> deletedTxsIds;
 
-  std::error_code ec = doGetPoolSymmetricDifference(std::move(knownTxs), tailBlock, isBcActual, addedTxs, deletedTxsIds);
-  if (ec) {
-    return true;
+  std::error_code ec;
+  if (m_poolChangesSinceSupported) {
+    ec = doGetPoolChangesSince(m_poolSequence, tailBlock, isBcActual, sequence, addedTxs, deletedTxsIds);
+  }
+
+  if (!m_poolChangesSinceSupported || ec) {
+    // the daemon is older than get_pool_changes_since or the request failed, send the whole known list instead
+    addedTxs.clear();
+    deletedTxsIds.clear();
+    sequence = 0;
+
+    ec = doGetPoolSymmetricDifference(getKnownTxsVector(), tailBlock, isBcActual, addedTxs, deletedTxsIds);
+    if (ec) {
+      return true;
+    }
   }
 
   if (!isBcActual) {
     return false;
   }
 
+  m_poolSequence = sequence;
+
   if (!addedTxs.empty() || !deletedTxsIds.empty()) {
     updatePoolState(addedTxs, deletedTxsIds);
     m_observerManager.notify(&INodeObserver::poolChanged);
@@ -674,6 +690,82 @@ std::error_code NodeRpcProxy::doGetPoolSymmetricDifference(std::vector<Crypto::H
   return ec;
 }
 
+std::error_code NodeRpcProxy::doGetPoolChangesSince(uint64_t knownSequence, Crypto::Hash knownBlockId, bool& isBcActual, uint64_t& sequence,
+        std::vector<std::unique_ptr<ITransactionReader>>& newTxs, std::vector<Crypto::Hash>& deletedTxIds) {
+  CryptoNote::COMMAND_RPC_GET_POOL_CHANGES_SINCE::request req = AUTO_VAL_INIT(req);
+  CryptoNote::COMMAND_RPC_GET_POOL_CHANGES_SINCE::response rsp = AUTO_VAL_INIT(rsp);
+
+  req.tailBlockId = knownBlockId;
+  req.sequence = knownSequence;
+
+  m_logger(TRACE) << "Send get_pool_changes_since request, tailBlockId " << req.tailBlockId << ", sequence " << req.sequence;
+
+  std::error_code ec;
+  try {
+    EventLock eventLock(*m_httpEvent);
+
+    HttpRequest httpReq;
+    HttpResponse httpRes;
+
+    httpReq.addHeader("Content-Type", "application/json");
+    httpReq.setUrl("/get_pool_changes_since");
+    httpReq.setBody(storeToJson(req));
+
+    m_httpClient->request(httpReq, httpRes);
+
+    if (httpRes.getStatus() == HttpResponse::STATUS_404) {
+      // the daemon does not know this request, it is not sent to it again
+      m_logger(DEBUGGING) << "Daemon doesn't support get_pool_changes_since, falling back to get_pool_changes_lite";
+      m_poolChangesSinceSupported = false;
+      ec = make_error_code(error::REQUEST_ERROR);
+    } else if (httpRes.getStatus() != HttpResponse::STATUS_200 || !loadFromJson(rsp, httpRes.getBody())) {
+      ec = make_error_code(error::NETWORK_ERROR);
+    } else {
+      ec = interpretResponseStatus(rsp.status);
+    }
+  } catch (const ConnectException&) {
+    ec = make_error_code(error::CONNECT_ERROR);
+  } catch (const std::exception&) {
+    ec = make_error_code(error::NETWORK_ERROR);
+  }
+
+  if (ec) {
+    m_logger(TRACE) << "get_pool_changes_since failed: " << ec << ", " << ec.message();
+    return ec;
+  }
+
+  m_logger(TRACE) << "get_pool_changes_since complete, isTailBlockActual " << rsp.isTailBlockActual << ", isSequenceActual " << rsp.isSequenceActual;
+  isBcActual = rsp.isTailBlockActual;
+  sequence = rsp.sequence;
+
+  if (rsp.isSequenceActual) {
+    deletedTxIds = std::move(rsp.deletedTxsIds);
+
+    for (const auto& tpi : rsp.addedTxs) {
+      newTxs.push_back(createTransactionPrefix(tpi.txPrefix, tpi.txHash));
+    }
+
+    return ec;
+  }
+
+  // the daemon has sent its whole pool, the difference with the known transactions is found here
+  std::unordered_set<Crypto::Hash> poolTxs;
+  for (const auto& tpi : rsp.addedTxs) {
+    poolTxs.insert(tpi.txHash);
+    if (m_knownTxs.count(tpi.txHash) == 0) {
+      newTxs.push_back(createTransactionPrefix(tpi.txPrefix, tpi.txHash));
+    }
+  }
+
+  for (const auto& hash : m_knownTxs) {
+    if (poolTxs.count(hash) == 0) {
+      deletedTxIds.push_back(hash);
+    }
+  }
+
+  return ec;
+}
+
 std::error_code NodeRpcProxy::doGetBlocksByHeight(const std::vector<uint32_t>& blockHeights, std::vector<std::vector<BlockDetails>>& blocks) {
   COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS::request req = AUTO_VAL_INIT(req);
   COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS::response resp = AUTO_VAL_INIT(resp);
@@ -142,6 +142,36 @@ struct COMMAND_RPC_GET_POOL_CHANGES_LITE {
   };
 };
 
+struct COMMAND_RPC_GET_POOL_CHANGES_SINCE {
+  struct request {
+    Crypto::Hash tailBlockId;
+    uint64_t sequence;                         // Pool sequence returned by the previous call, 0 for the first one
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(tailBlockId)
+      KV_MEMBER(sequence)
+    }
+  };
+
+  struct response {
+    bool isTailBlockActual;
+    bool isSequenceActual;                     // If false, addedTxs is the whole pool and deletedTxsIds is empty
+    uint64_t sequence;
+    std::vector<TransactionPrefixInfo> addedTxs;
+    std::vector<Crypto::Hash> deletedTxsIds;
+    std::string status;
+
+    void serialize(ISerializer &s) {
+      KV_MEMBER(isTailBlockActual)
+      KV_MEMBER(isSequenceActual)
+      KV_MEMBER(sequence)
+      KV_MEMBER(addedTxs)
+      KV_MEMBER(deletedTxsIds)
+      KV_MEMBER(status)
+    }
+  };
+};
+
 //-----------------------------------------------
 struct COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES {
   
@@ -17,7 +17,6 @@
 
 #include "HttpClient.h"
 
-#include <HTTP/HttpParser.h>
 #include <System/Ipv4Resolver.h>
 #include <System/Ipv4Address.h>
 #include <System/TcpConnector.h>
@@ -40,11 +39,9 @@ void HttpClient::request(const HttpRequest &req, HttpResponse &res) {
   }
 
   try {
-    std::iostream stream(m_streamBuf.get());
-    HttpParser parser;
-    stream << req;
-    stream.flush();
-    parser.receiveResponse(stream, res);
+    m_httpConnection->writeRequest(req);
+    m_httpConnection->flush();
+    m_httpConnection->readResponse(res);
   } catch (const std::exception &) {
     disconnect();
     throw;
@@ -55,7 +52,7 @@ void HttpClient::connect() {
   try {
     auto ipAddr = System::Ipv4Resolver(m_dispatcher).resolve(m_address);
     m_connection = System::TcpConnector(m_dispatcher).connect(ipAddr, m_port);
-    m_streamBuf.reset(new System::TcpStreambuf(m_connection));
+    m_httpConnection.reset(new HttpConnection(m_connection));
     m_connected = true;
   } catch (const std::exception& e) {
     throw ConnectException(e.what());
@@ -67,7 +64,7 @@ bool HttpClient::isConnected() const {
 }
 
 void HttpClient::disconnect() {
-  m_streamBuf.reset();
+  m_httpConnection.reset();
   try {
     m_connection.write(nullptr, 0); //Socket shutdown.
   } catch (std::exception&) {
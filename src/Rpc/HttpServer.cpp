@@ -18,9 +18,9 @@
 #include "HttpServer.h"
 #include <boost/scope_exit.hpp>
 
-#include <HTTP/HttpParser.h>
+#include <HTTP/HttpConnection.h>
 #include <System/InterruptedException.h>
-#include <System/TcpStream.h>
+#include <System/TcpConnection.h>
 #include <System/Ipv4Address.h>
 
 using namespace Logging;
@@ -68,23 +68,19 @@ void HttpServer::acceptLoop() {
 
     logger(DEBUGGING) << "Incoming connection from " << addr.first.toDottedDecimal() << ":" << addr.second;
 
-    System::TcpStreambuf streambuf(connection);
-    std::iostream stream(&streambuf);
-    HttpParser parser;
+    HttpConnection httpConnection(connection);
 
     for (;;) {
       HttpRequest req;
       HttpResponse resp;
 
-      parser.receiveRequest(stream, req);
-      processRequest(req, resp);
-
-      stream << resp;
-      stream.flush();
-
-      if (stream.peek() == std::iostream::traits_type::eof()) {
+      // responses to pipelined requests are sent together once no more requests are buffered
+      if (!httpConnection.readRequest(req)) {
         break;
       }
+
+      processRequest(req, resp);
+      httpConnection.writeResponse(resp);
     }
 
     logger(DEBUGGING) << "Closing connection from " << addr.first.toDottedDecimal() << ":" << addr.second << " total=" << m_connections.size();
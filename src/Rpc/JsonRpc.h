@@ -159,6 +159,7 @@ public:
 
   void setError(const JsonRpcError& err) {
     psResp.set("error", storeToJsonValue(err));
+    result.clear();
   }
 
   bool getError(JsonRpcError& err) const {
@@ -172,12 +173,27 @@ public:
 
   std::string getBody() {
     psResp.set("jsonrpc", std::string("2.0"));
-    return psResp.toString();
+    std::string body = psResp.toString();
+    if (result.empty()) {
+      return body;
+    }
+
+    // "result" sorts after every other member, so it goes right before the closing brace
+    body.pop_back();
+    if (body.size() > 1) {
+      body += ',';
+    }
+
+    body += "\"result\":";
+    body += result;
+    body += '}';
+    return body;
   }
 
+  // The result is kept as text and only spliced into the body, getResult reads parsed responses
   template <typename T>
   bool setResult(const T& v) {
-    psResp.set("result", storeToJsonValue(v));
+    result = storeToJson(v);
     return true;
   }
 
@@ -193,6 +209,7 @@ public:
 
 private:
   Common::JsonValue psResp;
+  std::string result;
 };
 
 
@@ -102,6 +102,7 @@ std::unordered_map<std::string, RpcServer::RpcHandler<RpcServer::HandlerFunction
   { "/getrandom_outs", { jsonMethod<COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS>(&RpcServer::on_get_random_outs), false } },
   { "/get_pool_changes", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES>(&RpcServer::onGetPoolChanges), false } },
   { "/get_pool_changes_lite", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES_LITE>(&RpcServer::onGetPoolChangesLite), false } },
+  { "/get_pool_changes_since", { jsonMethod<COMMAND_RPC_GET_POOL_CHANGES_SINCE>(&RpcServer::onGetPoolChangesSince), false } },
   { "/get_block_details_by_height", { jsonMethod<COMMAND_RPC_GET_BLOCK_DETAILS_BY_HEIGHT>(&RpcServer::onGetBlockDetailsByHeight), false } },
   { "/get_blocks_details_by_heights", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS>(&RpcServer::onGetBlocksDetailsByHeights), false } },
   { "/get_blocks_details_by_hashes", { jsonMethod<COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HASHES>(&RpcServer::onGetBlocksDetailsByHashes), false } },
@@ -294,17 +295,17 @@ bool RpcServer::on_get_indexes(const COMMAND_RPC_GET_TX_GLOBAL_OUTPUTS_INDEXES::
 bool RpcServer::on_get_random_outs(const COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::request& req, COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS::response& res) {
   res.status = "Failed";
 
-  for (uint64_t amount : req.amounts) {
-    std::vector<uint32_t> globalIndexes;
-    std::vector<Crypto::PublicKey> publicKeys;
-    if (!m_core.getRandomOutputs(amount, static_cast<uint16_t>(req.outs_count), globalIndexes, publicKeys)) {
-      return true;
-    }
+  std::vector<std::vector<uint32_t>> globalIndexes;
+  std::vector<std::vector<Crypto::PublicKey>> publicKeys;
+  if (!m_core.getRandomOutputs(req.amounts, static_cast<uint16_t>(req.outs_count), globalIndexes, publicKeys)) {
+    return true;
+  }
 
-    assert(globalIndexes.size() == publicKeys.size());
-    res.outs.emplace_back(COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount{amount, {}});
-    for (size_t i = 0; i < globalIndexes.size(); ++i) {
-      res.outs.back().outs.push_back({globalIndexes[i], publicKeys[i]});
+  for (size_t i = 0; i < req.amounts.size(); ++i) {
+    assert(globalIndexes[i].size() == publicKeys[i].size());
+    res.outs.emplace_back(COMMAND_RPC_GET_RANDOM_OUTPUTS_FOR_AMOUNTS_outs_for_amount{req.amounts[i], {}});
+    for (size_t j = 0; j < globalIndexes[i].size(); ++j) {
+      res.outs.back().outs.push_back({globalIndexes[i][j], publicKeys[i][j]});
     }
   }
 
@@ -345,6 +346,13 @@ bool RpcServer::onGetPoolChangesLite(const COMMAND_RPC_GET_POOL_CHANGES_LITE::re
   return true;
 }
 
+bool RpcServer::onGetPoolChangesSince(const COMMAND_RPC_GET_POOL_CHANGES_SINCE::request& req, COMMAND_RPC_GET_POOL_CHANGES_SINCE::response& rsp) {
+  rsp.status = CORE_RPC_STATUS_OK;
+  rsp.isTailBlockActual = m_core.getPoolChangesSince(req.tailBlockId, req.sequence, rsp.addedTxs, rsp.deletedTxsIds, rsp.sequence, rsp.isSequenceActual);
+
+  return true;
+}
+
 bool RpcServer::onGetBlocksDetailsByHeights(const COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS::request& req, COMMAND_RPC_GET_BLOCKS_DETAILS_BY_HEIGHTS::response& rsp) {
   try {
     std::vector<BlockDetails> blockDetails;
@@ -459,11 +467,12 @@ bool RpcServer::onGetTransactionHashesByPaymentId(const COMMAND_RPC_GET_TRANSACT
 //
 
 bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RPC_GET_INFO::response& res) {
-  res.height = m_core.getTopBlockIndex() + 1;
-  res.difficulty = m_core.getDifficultyForNextBlock();
-  res.tx_count = m_core.getBlockchainTransactionCount() - res.height; //without coinbase
-  res.tx_pool_size = m_core.getPoolTransactionCount();
-  res.alt_blocks_count = m_core.getAlternativeBlockCount();
+  auto chainStatus = m_core.getChainStatus();
+  res.height = chainStatus->topBlockIndex + 1;
+  res.difficulty = chainStatus->difficulty;
+  res.tx_count = chainStatus->transactionCount - res.height; //without coinbase
+  res.tx_pool_size = chainStatus->poolTransactionCount;
+  res.alt_blocks_count = chainStatus->alternativeBlockCount;
   uint64_t total_conn = m_p2p.get_connections_count();
   res.outgoing_connections_count = m_p2p.get_outgoing_connections_count();
   res.incoming_connections_count = total_conn - res.outgoing_connections_count;
@@ -476,8 +485,8 @@ bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RP
   res.hashrate = (uint32_t)round(res.difficulty / CryptoNote::parameters::DIFFICULTY_TARGET);
   res.synced = ((uint64_t)res.height == (uint64_t)res.network_height);
   res.testnet = m_core.getCurrency().isTestnet();
-  res.major_version = m_core.getBlockDetails(m_core.getTopBlockIndex()).majorVersion;
-  res.minor_version = m_core.getBlockDetails(m_core.getTopBlockIndex()).minorVersion;
+  res.major_version = chainStatus->topBlock.majorVersion;
+  res.minor_version = chainStatus->topBlock.minorVersion;
   res.version = PROJECT_VERSION;
   res.status = CORE_RPC_STATUS_OK;
   res.start_time = (uint64_t)m_core.getStartTime();
@@ -485,7 +494,7 @@ bool RpcServer::on_get_info(const COMMAND_RPC_GET_INFO::request& req, COMMAND_RP
 }
 
 bool RpcServer::on_get_height(const COMMAND_RPC_GET_HEIGHT::request& req, COMMAND_RPC_GET_HEIGHT::response& res) {
-  res.height = m_core.getTopBlockIndex() + 1;
+  res.height = m_core.getChainStatus()->topBlockIndex + 1;
   res.network_height = std::max(static_cast<uint32_t>(1), m_protocol.getBlockchainHeight());
   res.status = CORE_RPC_STATUS_OK;
   return true;
@@ -1012,6 +1021,13 @@ uint64_t get_block_reward(const BlockTemplate& blk) {
 }
 
 void RpcServer::fill_block_header_response(const BlockTemplate& blk, bool orphan_status, uint32_t index, const Hash& hash, block_header_response& response) {
+	BlockDetails blkDetails = m_core.getBlockDetails(hash);
+	fill_block_header_response(blk, orphan_status, index, hash, m_core.getBlockDifficulty(index),
+		static_cast<uint32_t>(blkDetails.transactions.size()), blkDetails.blockSize, response);
+}
+
+void RpcServer::fill_block_header_response(const BlockTemplate& blk, bool orphan_status, uint32_t index, const Hash& hash,
+	uint64_t difficulty, uint32_t transactionCount, uint64_t blockSize, block_header_response& response) {
 	response.major_version = blk.majorVersion;
 	response.minor_version = blk.minorVersion;
 	response.timestamp = blk.timestamp;
@@ -1021,16 +1037,16 @@ void RpcServer::fill_block_header_response(const BlockTemplate& blk, bool orphan
 	response.height = index;
 	response.depth = m_core.getTopBlockIndex() - index;
 	response.hash = Common::podToHex(hash);
-	response.difficulty = m_core.getBlockDifficulty(index);
+	response.difficulty = difficulty;
 	response.reward = get_block_reward(blk);
-	BlockDetails blkDetails = m_core.getBlockDetails(hash);
-	response.num_txes = static_cast<uint32_t>(blkDetails.transactions.size());
-	response.block_size = blkDetails.blockSize;
+	response.num_txes = transactionCount;
+	response.block_size = blockSize;
 }
 
 bool RpcServer::on_get_last_block_header(const COMMAND_RPC_GET_LAST_BLOCK_HEADER::request& req, COMMAND_RPC_GET_LAST_BLOCK_HEADER::response& res) {
-  auto topBlock = m_core.getBlockByHash(m_core.getTopBlockHash());
-  fill_block_header_response(topBlock, false, m_core.getTopBlockIndex(), m_core.getTopBlockHash(), res.block_header);
+  auto chainStatus = m_core.getChainStatus();
+  fill_block_header_response(chainStatus->topBlock, false, chainStatus->topBlockIndex, chainStatus->topBlockHash,
+    chainStatus->blockDifficulty, chainStatus->blockTransactionCount, chainStatus->blockSize, res.block_header);
   res.status = CORE_RPC_STATUS_OK;
   return true;
 }
@@ -0,0 +1,403 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "JsonInputBufferSerializer.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include "Common/StringTools.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+// deeper documents are refused rather than risking the stack
+const size_t MAX_NESTING_DEPTH = 256;
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+}
+
+bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+}
+
+JsonInputBufferSerializer::JsonInputBufferSerializer(const char* data, size_t size) : data(data), size(size) {
+  size_t offset = skipSpaces(0);
+  if (peek(offset) != '{') {
+    throw std::runtime_error("Serializer doesn't support this type of serialization: Object expected.");
+  }
+
+  // the text after the root object is ignored, as JsonValue does
+  parseValue(offset, 0);
+  chain.push_back({0, 1});
+}
+
+JsonInputBufferSerializer::~JsonInputBufferSerializer() {
+}
+
+ISerializer::SerializerType JsonInputBufferSerializer::type() const {
+  return ISerializer::INPUT;
+}
+
+bool JsonInputBufferSerializer::beginObject(Common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    return false;
+  }
+
+  if (token->type != OBJECT) {
+    throw std::runtime_error("JsonInputBufferSerializer: object expected");
+  }
+
+  size_t index = static_cast<size_t>(token - tokens.data());
+  chain.push_back({index, index + 1});
+  return true;
+}
+
+void JsonInputBufferSerializer::endObject() {
+  assert(!chain.empty());
+  chain.pop_back();
+}
+
+bool JsonInputBufferSerializer::beginArray(size_t& size, Common::StringView name) {
+  const Token* token = getValue(name);
+  if (token == nullptr) {
+    size = 0;
+    return false;
+  }
+
+  if (token->type != ARRAY) {
+    throw std::runtime_error("JsonInputBufferSerializer: array expected");
+  }
+
+  size_t index = static_cast<size_t>(token - tokens.data());
+  size = 0;
+  for (size_t i = index + 1; i < token->next; i = tokens[i].next) {
+    ++size;
+  }
+
+  chain.push_back({index, index + 1});
+  return true;
+}
+
+void JsonInputBufferSerializer::endArray() {
+  assert(!chain.empty());
+  chain.pop_back();
+}
+
+bool JsonInputBufferSerializer::operator()(uint16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(int16_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(uint32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(int32_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(int64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(uint64_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(uint8_t& value, Common::StringView name) {
+  return getNumber(name, value);
+}
+
+bool JsonInputBufferSerializer::operator()(double& value, Common::StringView name) {
+  auto ptr = getValue(name);
+  if (ptr == nullptr) {
+    return false;
+  }
+
+  if (ptr->type == REAL) {
+    value = std::strtod(std::string(data + ptr->begin, ptr->end - ptr->begin).c_str(), nullptr);
+  } else {
+    value = static_cast<double>(getInteger(*ptr));
+  }
+
+  return true;
+}
+
+bool JsonInputBufferSerializer::operator()(std::string& value, Common::StringView name) {
+  auto ptr = getValue(name);
+  if (ptr == nullptr) {
+    return false;
+  }
+
+  if (ptr->type != STRING) {
+    throw std::runtime_error("JsonInputBufferSerializer: string expected");
+  }
+
+  value.assign(data + ptr->begin, ptr->end - ptr->begin);
+  return true;
+}
+
+bool JsonInputBufferSerializer::operator()(bool& value, Common::StringView name) {
+  auto ptr = getValue(name);
+  if (ptr == nullptr) {
+    return false;
+  }
+
+  if (ptr->type != BOOL_TRUE && ptr->type != BOOL_FALSE) {
+    throw std::runtime_error("JsonInputBufferSerializer: bool expected");
+  }
+
+  value = ptr->type == BOOL_TRUE;
+  return true;
+}
+
+bool JsonInputBufferSerializer::binary(void* value, size_t size, Common::StringView name) {
+  std::string valueHex;
+  if (!(*this)(valueHex, name)) {
+    return false;
+  }
+
+  Common::fromHex(valueHex, value, size);
+  return true;
+}
+
+bool JsonInputBufferSerializer::binary(std::string& value, Common::StringView name) {
+  std::string valueHex;
+  if (!(*this)(valueHex, name)) {
+    return false;
+  }
+
+  value = Common::asString(Common::fromHex(valueHex));
+  return true;
+}
+
+size_t JsonInputBufferSerializer::parseValue(size_t offset, size_t depth) {
+  if (depth > MAX_NESTING_DEPTH) {
+    throw std::runtime_error("Unable to parse: too deep");
+  }
+
+  char c = peek(offset);
+  if (c == '{' || c == '[') {
+    char close = c == '{' ? '}' : ']';
+    size_t index = tokens.size();
+    tokens.push_back({c == '{' ? OBJECT : ARRAY, offset, 0, 0});
+
+    offset = skipSpaces(offset + 1);
+    if (peek(offset) != close) {
+      for (;;) {
+        if (c == '{') {
+          if (peek(offset) != '"') {
+            throw std::runtime_error("Unable to parse");
+          }
+
+          offset = skipSpaces(parseString(offset, STRING));
+          if (peek(offset) != ':') {
+            throw std::runtime_error("Unable to parse");
+          }
+
+          offset = skipSpaces(offset + 1);
+        }
+
+        offset = skipSpaces(parseValue(offset, depth + 1));
+        if (peek(offset) == close) {
+          break;
+        }
+
+        if (peek(offset) != ',') {
+          throw std::runtime_error("Unable to parse");
+        }
+
+        offset = skipSpaces(offset + 1);
+      }
+    }
+
+    tokens[index].end = offset + 1;
+    tokens[index].next = tokens.size();
+    return offset + 1;
+  }
+
+  if (c == '"') {
+    return parseString(offset, STRING);
+  }
+
+  if (c == '-' || isDigit(c)) {
+    return parseNumber(offset);
+  }
+
+  if (c == 't') {
+    return parseLiteral(offset, "true", BOOL_TRUE);
+  }
+
+  if (c == 'f') {
+    return parseLiteral(offset, "false", BOOL_FALSE);
+  }
+
+  if (c == 'n') {
+    return parseLiteral(offset, "null", NIL);
+  }
+
+  throw std::runtime_error("Unable to parse");
+}
+
+size_t JsonInputBufferSerializer::parseString(size_t offset, TokenType type) {
+  size_t begin = offset + 1;
+  size_t end = begin;
+  for (char c = peek(end); c != '"'; c = peek(end)) {
+    // escapes are kept as they are, only the escaped quote must not end the string
+    end += c == '\\' ? 2 : 1;
+  }
+
+  tokens.push_back({type, begin, end, tokens.size() + 1});
+  return end + 1;
+}
+
+size_t JsonInputBufferSerializer::parseNumber(size_t offset) {
+  size_t begin = offset;
+  if (data[offset] == '-') {
+    ++offset;
+  }
+
+  if (!isDigit(peek(offset))) {
+    throw std::runtime_error("Unable to parse");
+  }
+
+  size_t dots = 0;
+  while (offset < size && (isDigit(data[offset]) || data[offset] == '.')) {
+    dots += data[offset] == '.' ? 1 : 0;
+    ++offset;
+  }
+
+  if (dots > 1) {
+    throw std::runtime_error("Unable to parse");
+  }
+
+  if (dots == 0) {
+    size_t digits = data[begin] == '-' ? begin + 1 : begin;
+    if (offset - digits > 1 && data[digits] == '0') {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    tokens.push_back({INTEGER, begin, offset, tokens.size() + 1});
+    return offset;
+  }
+
+  if (offset < size && data[offset] == 'e') {
+    ++offset;
+    if (peek(offset) == '+' || peek(offset) == '-') {
+      ++offset;
+    }
+
+    if (!isDigit(peek(offset))) {
+      throw std::runtime_error("Unable to parse");
+    }
+
+    while (offset < size && isDigit(data[offset])) {
+      ++offset;
+    }
+  }
+
+  tokens.push_back({REAL, begin, offset, tokens.size() + 1});
+  return offset;
+}
+
+size_t JsonInputBufferSerializer::parseLiteral(size_t offset, const char* literal, TokenType type) {
+  size_t length = strlen(literal);
+  if (size - offset < length || memcmp(data + offset, literal, length) != 0) {
+    throw std::runtime_error("Unable to parse");
+  }
+
+  tokens.push_back({type, offset, offset + length, tokens.size() + 1});
+  return offset + length;
+}
+
+size_t JsonInputBufferSerializer::skipSpaces(size_t offset) const {
+  while (offset < size && isSpace(data[offset])) {
+    ++offset;
+  }
+
+  return offset;
+}
+
+char JsonInputBufferSerializer::peek(size_t offset) const {
+  if (offset >= size) {
+    throw std::runtime_error("Unable to parse: unexpected end of stream");
+  }
+
+  return data[offset];
+}
+
+const JsonInputBufferSerializer::Token* JsonInputBufferSerializer::getValue(Common::StringView name) {
+  Scope& scope = chain.back();
+  const Token& parent = tokens[scope.token];
+
+  if (parent.type == ARRAY) {
+    if (scope.cursor >= parent.next) {
+      throw std::out_of_range("JsonInputBufferSerializer: no more array elements");
+    }
+
+    const Token* value = &tokens[scope.cursor];
+    scope.cursor = value->next;
+    return value;
+  }
+
+  auto matches = [&](size_t key) {
+    const Token& token = tokens[key];
+    return token.end - token.begin == name.getSize() && memcmp(data + token.begin, name.getData(), name.getSize()) == 0;
+  };
+
+  // members are usually asked for in the order they are written, so the search starts after the last one found
+  size_t firstMember = scope.token + 1;
+  for (size_t key = scope.cursor; key < parent.next; key = tokens[key + 1].next) {
+    if (matches(key)) {
+      scope.cursor = tokens[key + 1].next;
+      return &tokens[key + 1];
+    }
+  }
+
+  for (size_t key = firstMember; key < scope.cursor; key = tokens[key + 1].next) {
+    if (matches(key)) {
+      scope.cursor = tokens[key + 1].next;
+      return &tokens[key + 1];
+    }
+  }
+
+  return nullptr;
+}
+
+int64_t JsonInputBufferSerializer::getInteger(const Token& token) const {
+  if (token.type != INTEGER) {
+    throw std::runtime_error("JsonInputBufferSerializer: integer expected");
+  }
+
+  size_t offset = token.begin;
+  bool negative = data[offset] == '-';
+  if (negative) {
+    ++offset;
+  }
+
+  uint64_t limit = negative ? static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1 : static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+  uint64_t value = 0;
+  for (; offset < token.end; ++offset) {
+    uint64_t digit = static_cast<uint64_t>(data[offset] - '0');
+    if (value > (limit - digit) / 10) {
+      throw std::out_of_range("JsonInputBufferSerializer: integer is too big");
+    }
+
+    value = value * 10 + digit;
+  }
+
+  return negative ? static_cast<int64_t>(0 - value) : static_cast<int64_t>(value);
+}
@@ -0,0 +1,104 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <vector>
+
+#include "ISerializer.h"
+
+namespace CryptoNote {
+
+// Reads JSON straight from a contiguous buffer. The buffer is scanned once into a flat list of tokens
+// pointing back into it, and values are only converted when the serializer asks for them, so no
+// JsonValue tree is built. Strings are taken as they are, like JsonValue does. The buffer must outlive
+// the serializer.
+class JsonInputBufferSerializer : public ISerializer {
+public:
+  JsonInputBufferSerializer(const char* data, size_t size);
+  virtual ~JsonInputBufferSerializer();
+
+  SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+private:
+  enum TokenType : uint8_t {
+    OBJECT,
+    ARRAY,
+    STRING,
+    INTEGER,
+    REAL,
+    BOOL_TRUE,
+    BOOL_FALSE,
+    NIL
+  };
+
+  struct Token {
+    TokenType type;
+    // text of the value, without the quotes for strings
+    size_t begin;
+    size_t end;
+    // index of the token following this value and everything inside it
+    size_t next;
+  };
+
+  struct Scope {
+    size_t token;
+    // next element of an array, or the object member to look at first
+    size_t cursor;
+  };
+
+  const char* data;
+  size_t size;
+  // objects are stored as { object, key, value, key, value, ... }
+  std::vector<Token> tokens;
+  std::vector<Scope> chain;
+
+  size_t parseValue(size_t offset, size_t depth);
+  size_t parseString(size_t offset, TokenType type);
+  size_t parseNumber(size_t offset);
+  size_t parseLiteral(size_t offset, const char* literal, TokenType type);
+  size_t skipSpaces(size_t offset) const;
+  char peek(size_t offset) const;
+
+  const Token* getValue(Common::StringView name);
+  int64_t getInteger(const Token& token) const;
+
+  template <typename T>
+  bool getNumber(Common::StringView name, T& v) {
+    auto ptr = getValue(name);
+
+    if (!ptr) {
+      return false;
+    }
+
+    v = static_cast<T>(getInteger(*ptr));
+    return true;
+  }
+};
+
+}
@@ -0,0 +1,166 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "JsonOutputBufferSerializer.h"
+
+#include <cassert>
+#include <cstdio>
+
+#include "Common/StringTools.h"
+
+using namespace CryptoNote;
+
+JsonOutputBufferSerializer::JsonOutputBufferSerializer(std::string& buffer) : buffer(buffer) {
+  buffer += '{';
+  chain.push_back({false, true});
+}
+
+JsonOutputBufferSerializer::~JsonOutputBufferSerializer() {
+}
+
+ISerializer::SerializerType JsonOutputBufferSerializer::type() const {
+  return ISerializer::OUTPUT;
+}
+
+bool JsonOutputBufferSerializer::beginObject(Common::StringView name) {
+  writeName(name);
+  buffer += '{';
+  chain.push_back({false, true});
+  return true;
+}
+
+void JsonOutputBufferSerializer::endObject() {
+  assert(chain.size() > 1 && !chain.back().isArray);
+  chain.pop_back();
+  buffer += '}';
+}
+
+bool JsonOutputBufferSerializer::beginArray(size_t& size, Common::StringView name) {
+  writeName(name);
+  buffer += '[';
+  chain.push_back({true, true});
+  return true;
+}
+
+void JsonOutputBufferSerializer::endArray() {
+  assert(chain.size() > 1 && chain.back().isArray);
+  chain.pop_back();
+  buffer += ']';
+}
+
+bool JsonOutputBufferSerializer::operator()(uint64_t& value, Common::StringView name) {
+  // JsonValue only has signed integers
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputBufferSerializer::operator()(uint16_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputBufferSerializer::operator()(int16_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputBufferSerializer::operator()(uint32_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputBufferSerializer::operator()(int32_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputBufferSerializer::operator()(uint8_t& value, Common::StringView name) {
+  int64_t v = static_cast<int64_t>(value);
+  return operator()(v, name);
+}
+
+bool JsonOutputBufferSerializer::operator()(int64_t& value, Common::StringView name) {
+  writeName(name);
+
+  char text[24];
+  char* end = text + sizeof(text);
+  char* begin = end;
+  uint64_t magnitude = value < 0 ? 0 - static_cast<uint64_t>(value) : static_cast<uint64_t>(value);
+  do {
+    *--begin = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude != 0);
+
+  if (value < 0) {
+    *--begin = '-';
+  }
+
+  buffer.append(begin, end);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(double& value, Common::StringView name) {
+  writeName(name);
+
+  // same text as JsonValue: fixed, 11 digits after the point, trailing zeros dropped but one
+  char text[352];
+  int length = snprintf(text, sizeof(text), "%.11f", value);
+  if (length < 0 || static_cast<size_t>(length) >= sizeof(text)) {
+    length = 0;
+  }
+
+  while (length > 1 && text[length - 2] != '.' && text[length - 1] == '0') {
+    --length;
+  }
+
+  buffer.append(text, length);
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(std::string& value, Common::StringView name) {
+  writeName(name);
+  buffer += '"';
+  buffer += value;
+  buffer += '"';
+  return true;
+}
+
+bool JsonOutputBufferSerializer::operator()(bool& value, Common::StringView name) {
+  writeName(name);
+  buffer += value ? "true" : "false";
+  return true;
+}
+
+bool JsonOutputBufferSerializer::binary(void* value, size_t size, Common::StringView name) {
+  writeName(name);
+  buffer += '"';
+  Common::toHex(value, size, buffer);
+  buffer += '"';
+  return true;
+}
+
+bool JsonOutputBufferSerializer::binary(std::string& value, Common::StringView name) {
+  return binary(const_cast<char*>(value.data()), value.size(), name);
+}
+
+void JsonOutputBufferSerializer::finish() {
+  assert(chain.size() == 1);
+  chain.pop_back();
+  buffer += '}';
+}
+
+void JsonOutputBufferSerializer::writeName(Common::StringView name) {
+  assert(!chain.empty());
+  Frame& frame = chain.back();
+  if (!frame.isEmpty) {
+    buffer += ',';
+  }
+
+  frame.isEmpty = false;
+  if (!frame.isArray) {
+    buffer += '"';
+    buffer.append(name.getData(), name.getSize());
+    buffer += "\":";
+  }
+}
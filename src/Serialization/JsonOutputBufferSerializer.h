@@ -0,0 +1,62 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <vector>
+
+#include "ISerializer.h"
+
+namespace CryptoNote {
+
+// Writes JSON straight into a string as values are serialized, instead of building a JsonValue tree
+// and printing it afterwards. Numbers, strings and reals are written the same way JsonValue writes
+// them, but object members keep the order they were serialized in.
+class JsonOutputBufferSerializer : public ISerializer {
+public:
+  explicit JsonOutputBufferSerializer(std::string& buffer);
+  virtual ~JsonOutputBufferSerializer();
+
+  SerializerType type() const override;
+
+  virtual bool beginObject(Common::StringView name) override;
+  virtual void endObject() override;
+
+  virtual bool beginArray(size_t& size, Common::StringView name) override;
+  virtual void endArray() override;
+
+  virtual bool operator()(uint8_t& value, Common::StringView name) override;
+  virtual bool operator()(int16_t& value, Common::StringView name) override;
+  virtual bool operator()(uint16_t& value, Common::StringView name) override;
+  virtual bool operator()(int32_t& value, Common::StringView name) override;
+  virtual bool operator()(uint32_t& value, Common::StringView name) override;
+  virtual bool operator()(int64_t& value, Common::StringView name) override;
+  virtual bool operator()(uint64_t& value, Common::StringView name) override;
+  virtual bool operator()(double& value, Common::StringView name) override;
+  virtual bool operator()(bool& value, Common::StringView name) override;
+  virtual bool operator()(std::string& value, Common::StringView name) override;
+  virtual bool binary(void* value, size_t size, Common::StringView name) override;
+  virtual bool binary(std::string& value, Common::StringView name) override;
+
+  template<typename T>
+  bool operator()(T& value, Common::StringView name) {
+    return ISerializer::operator()(value, name);
+  }
+
+  // Closes the root object, nothing may be serialized afterwards
+  void finish();
+
+private:
+  struct Frame {
+    bool isArray;
+    bool isEmpty;
+  };
+
+  std::string& buffer;
+  std::vector<Frame> chain;
+
+  void writeName(Common::StringView name);
+};
+
+}
@@ -21,7 +21,9 @@
 #include <vector>
 #include <Common/MemoryInputStream.h>
 #include <Common/StringOutputStream.h>
+#include "JsonInputBufferSerializer.h"
 #include "JsonInputStreamSerializer.h"
+#include "JsonOutputBufferSerializer.h"
 #include "JsonOutputStreamSerializer.h"
 #include "KVBinaryInputStreamSerializer.h"
 #include "KVBinaryOutputStreamSerializer.h"
@@ -110,11 +112,58 @@ void loadFromJsonValue(std::list<T>& v, const Common::JsonValue& js) {
 
 template <typename T>
 std::string storeToJson(const T& v) {
+  std::string buf;
+  JsonOutputBufferSerializer s(buf);
+  serialize(const_cast<T&>(v), s);
+  s.finish();
+  return buf;
+}
+
+// Containers and plain strings are not objects, they still go through JsonValue
+template <typename T>
+std::string storeToJson(const std::vector<T>& v) {
+  return storeToJsonValue(v).toString();
+}
+
+template <typename T>
+std::string storeToJson(const std::list<T>& v) {
+  return storeToJsonValue(v).toString();
+}
+
+inline std::string storeToJson(const std::string& v) {
   return storeToJsonValue(v).toString();
 }
 
 template <typename T>
 bool loadFromJson(T& v, const std::string& buf) {
+  try {
+    if (buf.empty()) {
+      return true;
+    }
+    JsonInputBufferSerializer s(buf.data(), buf.size());
+    serialize(v, s);
+  } catch (std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+bool loadFromJson(std::vector<T>& v, const std::string& buf) {
+  try {
+    if (buf.empty()) {
+      return true;
+    }
+    auto js = Common::JsonValue::fromString(buf);
+    loadFromJsonValue(v, js);
+  } catch (std::exception&) {
+    return false;
+  }
+  return true;
+}
+
+template <typename T>
+bool loadFromJson(std::list<T>& v, const std::string& buf) {
   try {
     if (buf.empty()) {
       return true;
@@ -118,12 +118,12 @@ bool BlockchainSynchronizer::removeConsumer(IBlockchainConsumer* consumer) {
 }
 
 IStreamSerializable* BlockchainSynchronizer::getConsumerState(IBlockchainConsumer* consumer) const {
-  std::unique_lock<std::mutex> lk(m_consumersMutex);
+  std::unique_lock<std::recursive_mutex> lk(m_consumersMutex);
   return getConsumerSynchronizationState(consumer);
 }
 
 std::vector<Crypto::Hash> BlockchainSynchronizer::getConsumerKnownBlocks(IBlockchainConsumer& consumer) const {
-  std::unique_lock<std::mutex> lk(m_consumersMutex);
+  std::unique_lock<std::recursive_mutex> lk(m_consumersMutex);
 
   auto state = getConsumerSynchronizationState(&consumer);
   if (state == nullptr) {
@@ -174,7 +174,7 @@ std::future<void> BlockchainSynchronizer::removeUnconfirmedTransaction(const Cry
 }
 
 std::error_code BlockchainSynchronizer::doAddUnconfirmedTransaction(const ITransactionReader& transaction) {
-  std::unique_lock<std::mutex> lk(m_consumersMutex);
+  std::unique_lock<std::recursive_mutex> lk(m_consumersMutex);
 
   std::error_code ec;
   auto addIt = m_consumers.begin();
@@ -200,7 +200,7 @@ std::error_code BlockchainSynchronizer::doAddUnconfirmedTransaction(const ITrans
 }
 
 void BlockchainSynchronizer::doRemoveUnconfirmedTransaction(const Crypto::Hash& transactionHash) {
-  std::unique_lock<std::mutex> lk(m_consumersMutex);
+  std::unique_lock<std::recursive_mutex> lk(m_consumersMutex);
 
   for (auto& consumer : m_consumers) {
     consumer.first->removeUnconfirmedTransaction(transactionHash);
@@ -379,6 +379,11 @@ void BlockchainSynchronizer::stop() {
   m_logger(INFO, BRIGHT_WHITE) << "Stopped";
 }
 
+void BlockchainSynchronizer::withConsumersLocked(const std::function<void()>& procedure) {
+  std::unique_lock<std::recursive_mutex> lk(m_consumersMutex);
+  procedure();
+}
+
 void BlockchainSynchronizer::localBlockchainUpdated(uint32_t height) {
   m_logger(DEBUGGING) << "Event: localBlockchainUpdated " << height;
   setFutureState(State::blockchainSync);
@@ -396,7 +401,7 @@ void BlockchainSynchronizer::poolChanged() {
 //--------------------------- FSM END ------------------------------------
 
 void BlockchainSynchronizer::getPoolUnionAndIntersection(std::unordered_set<Crypto::Hash>& poolUnion, std::unordered_set<Crypto::Hash>& poolIntersection) const {
-  std::unique_lock<std::mutex> lk(m_consumersMutex);
+  std::unique_lock<std::recursive_mutex> lk(m_consumersMutex);
 
   auto itConsumers = m_consumers.begin();
   poolUnion = itConsumers->first->getKnownPoolTxIds();
@@ -422,7 +427,7 @@ void BlockchainSynchronizer::getPoolUnionAndIntersection(std::unordered_set<Cryp
 
 BlockchainSynchronizer::GetBlocksRequest BlockchainSynchronizer::getCommonHistory() {
   GetBlocksRequest request;
-  std::unique_lock<std::mutex> lk(m_consumersMutex);
+  std::unique_lock<std::recursive_mutex> lk(m_consumersMutex);
   if (m_consumers.empty()) {
     return request;
   }
@@ -527,7 +532,7 @@ void BlockchainSynchronizer::processBlocks(GetBlocksResponse& response) {
   uint32_t processedBlockCount = response.startHeight + static_cast<uint32_t>(response.newBlocks.size());
   if (!checkIfShouldStop()) {
     response.newBlocks.clear();
-    std::unique_lock<std::mutex> lk(m_consumersMutex);
+    std::unique_lock<std::recursive_mutex> lk(m_consumersMutex);
     auto result = updateConsumers(interval, blocks);
     lk.unlock();
 
@@ -648,7 +653,7 @@ void BlockchainSynchronizer::removeOutdatedTransactions() {
   if (!ec) {
     m_logger(DEBUGGING) << "Outdated pool transactions received, " << response.deletedTxIds.size() << ':' << makeContainerFormatter(response.deletedTxIds);
 
-    std::unique_lock<std::mutex> lock(m_consumersMutex);
+    std::unique_lock<std::recursive_mutex> lock(m_consumersMutex);
     for (auto& consumer : m_consumers) {
       ec = consumer.first->onPoolUpdated({}, response.deletedTxIds);
       if (ec) {
@@ -764,7 +769,7 @@ std::error_code BlockchainSynchronizer::processPoolTxs(GetPoolResponse& response
 
   std::error_code error;
   {
-    std::unique_lock<std::mutex> lk(m_consumersMutex);
+    std::unique_lock<std::recursive_mutex> lk(m_consumersMutex);
     for (auto& consumer : m_consumers) {
       if (checkIfShouldStop()) { //if stop, return immediately, without notification
         m_logger(WARNING, BRIGHT_YELLOW) << "Pool transactions processing is interrupted";
@@ -26,6 +26,7 @@
 #include <condition_variable>
 #include <mutex>
 #include <atomic>
+#include <functional>
 #include <future>
 
 #include "Logging/LoggerRef.h"
@@ -52,6 +53,10 @@ public:
   virtual void start() override;
   virtual void stop() override;
 
+  // Runs procedure while no consumer can be updated, so whatever it saves from them is consistent.
+  // Consumers notify their observers while they are updated, so those notifications are all out by then
+  void withConsumersLocked(const std::function<void()>& procedure);
+
   // IStreamSerializable
   virtual void save(std::ostream& os) override;
   virtual void load(std::istream& in) override;
@@ -143,7 +148,8 @@ private:
   std::list<std::pair<const ITransactionReader*, std::promise<std::error_code>>> m_addTransactionTasks;
   std::list<std::pair<const Crypto::Hash*, std::promise<void>>> m_removeTransactionTasks;
 
-  mutable std::mutex m_consumersMutex;
+  // recursive, withConsumersLocked() procedures query consumer states
+  mutable std::recursive_mutex m_consumersMutex;
   mutable std::mutex m_stateMutex;
   std::condition_variable m_hasWork;
 
@@ -33,6 +33,9 @@ namespace {
 
 using namespace CryptoNote;
 
+// number of transactions scanned together by one worker in onNewBlocks
+const size_t TRANSACTIONS_PER_SCAN_BATCH = 64;
+
 class MarkTransactionConfirmedException : public std::exception {
 public:
     MarkTransactionConfirmedException(const Crypto::Hash& txHash) {
@@ -46,55 +49,85 @@ private:
     Crypto::Hash m_txHash;
 };
 
-void checkOutputKey(
-  const KeyDerivation& derivation,
-  const PublicKey& key,
-  size_t keyIndex,
-  size_t outputIndex,
+/* Scans a batch of transactions at once, so that the key derivations and the
+   underived spend keys of all their outputs are computed with the batched
+   crypto functions. outputs[i] receives the outputs of transactions[i]. */
+void findMyOutputs(
+  const std::vector<const ITransactionReader*>& transactions,
+  const PreparedSecretKey& viewSecretKey,
   const std::unordered_set<PublicKey>& spendKeys,
-  std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
+  std::vector<std::unordered_map<PublicKey, std::vector<uint32_t>>>& outputs) {
 
-  PublicKey spendKey;
-  underive_public_key(derivation, keyIndex, key, spendKey);
+  std::vector<PublicKey> txPublicKeys;
+  txPublicKeys.reserve(transactions.size());
 
-  if (spendKeys.find(spendKey) != spendKeys.end()) {
-    outputs[spendKey].push_back(static_cast<uint32_t>(outputIndex));
+  for (const auto tx : transactions) {
+    txPublicKeys.push_back(tx->getTransactionPublicKey());
   }
 
-}
+  std::vector<KeyDerivation> derivations;
+  std::vector<bool> derivationValid;
+  generate_key_derivations(txPublicKeys, viewSecretKey, derivations, derivationValid);
 
-void findMyOutputs(
-  const ITransactionReader& tx,
-  const SecretKey& viewSecretKey,
-  const std::unordered_set<PublicKey>& spendKeys,
-  std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
+  std::vector<KeyDerivation> outputDerivations;
+  std::vector<size_t> keyIndexes;
+  std::vector<PublicKey> outputKeys;
+  // { transaction index in batch, output index in transaction } for each checked key
+  std::vector<std::pair<size_t, uint32_t>> outputPositions;
 
-  auto txPublicKey = tx.getTransactionPublicKey();
-  KeyDerivation derivation;
+  for (size_t i = 0; i < transactions.size(); ++i) {
+    if (!derivationValid[i]) {
+      continue;
+    }
 
-  if (!generate_key_derivation( txPublicKey, viewSecretKey, derivation)) {
-    return;
-  }
+    const auto& tx = *transactions[i];
+    size_t keyIndex = 0;
+    size_t outputCount = tx.getOutputCount();
 
-  size_t keyIndex = 0;
-  size_t outputCount = tx.getOutputCount();
+    for (size_t idx = 0; idx < outputCount; ++idx) {
 
-  for (size_t idx = 0; idx < outputCount; ++idx) {
+      auto outType = tx.getOutputType(size_t(idx));
 
-    auto outType = tx.getOutputType(size_t(idx));
+      if (outType == TransactionTypes::OutputType::Key) {
 
-    if (outType == TransactionTypes::OutputType::Key) {
+        uint64_t amount;
+        KeyOutput out;
+        tx.getOutput(idx, out, amount);
+        outputDerivations.push_back(derivations[i]);
+        keyIndexes.push_back(keyIndex);
+        outputKeys.push_back(out.key);
+        outputPositions.emplace_back(i, static_cast<uint32_t>(idx));
+        ++keyIndex;
 
-      uint64_t amount;
-      KeyOutput out;
-      tx.getOutput(idx, out, amount);
-      checkOutputKey(derivation, out.key, keyIndex, idx, spendKeys, outputs);
-      ++keyIndex;
+      }
+    }
+  }
+
+  std::vector<PublicKey> outputSpendKeys;
+  std::vector<bool> outputSpendKeyValid;
+  underive_public_keys(outputDerivations, keyIndexes, outputKeys, outputSpendKeys, outputSpendKeyValid);
+
+  outputs.clear();
+  outputs.resize(transactions.size());
 
+  for (size_t i = 0; i < outputSpendKeys.size(); ++i) {
+    if (outputSpendKeyValid[i] && spendKeys.find(outputSpendKeys[i]) != spendKeys.end()) {
+      outputs[outputPositions[i].first][outputSpendKeys[i]].push_back(outputPositions[i].second);
     }
   }
 }
 
+void findMyOutputs(
+  const ITransactionReader& tx,
+  const PreparedSecretKey& viewSecretKey,
+  const std::unordered_set<PublicKey>& spendKeys,
+  std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs) {
+
+  std::vector<std::unordered_map<PublicKey, std::vector<uint32_t>>> batchOutputs;
+  findMyOutputs({ &tx }, viewSecretKey, spendKeys, batchOutputs);
+  outputs = std::move(batchOutputs.front());
+}
+
 std::vector<Crypto::Hash> getBlockHashes(const CryptoNote::CompleteBlock* blocks, size_t count) {
   std::vector<Crypto::Hash> result;
   result.reserve(count);
@@ -112,6 +145,7 @@ namespace CryptoNote {
 
 TransfersConsumer::TransfersConsumer(const CryptoNote::Currency& currency, INode& node, Logging::ILogger& logger, const SecretKey& viewSecret) :
   m_node(node), m_viewSecret(viewSecret), m_currency(currency), m_logger(logger, "TransfersConsumer") {
+  prepare_secret_key(m_viewSecret, m_preparedViewSecret);
   updateSyncStart();
 }
 
@@ -216,12 +250,14 @@ uint32_t TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t st
     workers = 2;
   }
 
-  BlockingQueue<Tx> inputQueue(workers * 2);
+  BlockingQueue<std::vector<Tx>> inputQueue(workers * 2);
 
   std::atomic<bool> stopProcessing(false);
   std::atomic<size_t> emptyBlockCount(0);
 
   auto pushingThread = std::async(std::launch::async, [&] {
+    std::vector<Tx> batch;
+
     for( uint32_t i = 0; i < count && !stopProcessing; ++i) {
       const auto& block = blocks[i].block;
 
@@ -250,29 +286,61 @@ uint32_t TransfersConsumer::onNewBlocks(const CompleteBlock* blocks, uint32_t st
 
         bool isLastTransactionInBlock = blockInfo.transactionIndex + 1 == blocks[i].transactions.size();
         Tx item = { blockInfo, tx.get(), isLastTransactionInBlock };
-        inputQueue.push(item);
+        batch.push_back(item);
         ++blockInfo.transactionIndex;
+
+        if (batch.size() == TRANSACTIONS_PER_SCAN_BATCH) {
+          inputQueue.push(std::move(batch));
+          batch.clear();
+        }
       }
     }
 
+    if (!batch.empty()) {
+      inputQueue.push(std::move(batch));
+    }
+
     inputQueue.close();
   });
 
   auto processingFunction = [&] {
-    Tx item;
+    std::vector<Tx> batch;
     std::error_code ec;
-    while (!stopProcessing && inputQueue.pop(item)) {
-      PreprocessedTx output;
-      static_cast<Tx&>(output) = item;
+    while (!stopProcessing && inputQueue.pop(batch)) {
+      std::vector<const ITransactionReader*> transactions;
+      transactions.reserve(batch.size());
+      for (const auto& item : batch) {
+        transactions.push_back(item.tx);
+      }
+
+      std::vector<std::unordered_map<PublicKey, std::vector<uint32_t>>> outputs;
+      try {
+        findMyOutputs(transactions, m_preparedViewSecret, m_spendKeys, outputs);
+      } catch (const std::exception& e) {
+        // fall back to scanning one by one, so only the broken transaction is skipped
+        m_logger(WARNING, BRIGHT_RED) << "Failed to scan transaction batch: " << e.what() << ", scanning transactions one by one";
+        outputs.clear();
+      }
+
+      for (size_t i = 0; i < batch.size(); ++i) {
+        PreprocessedTx output;
+        static_cast<Tx&>(output) = batch[i];
+
+        ec = outputs.empty() ?
+          preprocessOutputs(batch[i].blockInfo, *batch[i].tx, output) :
+          preprocessOutputs(batch[i].blockInfo, *batch[i].tx, outputs[i], output);
+        if (ec) {
+          stopProcessing = true;
+          break;
+        }
+
+        std::lock_guard<std::mutex> lk(preprocessedTransactionsMutex);
+        preprocessedTransactions.push_back(std::move(output));
+      }
 
-      ec = preprocessOutputs(item.blockInfo, *item.tx, output);
       if (ec) {
-        stopProcessing = true;
         break;
       }
-
-      std::lock_guard<std::mutex> lk(preprocessedTransactionsMutex);
-      preprocessedTransactions.push_back(std::move(output));
     }
     return ec;
   };
@@ -500,7 +568,7 @@ std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo&
   std::unordered_map<PublicKey, std::vector<uint32_t>> outputs;
   try
   {
-    findMyOutputs(tx, m_viewSecret, m_spendKeys, outputs);
+    findMyOutputs(tx, m_preparedViewSecret, m_spendKeys, outputs);
   }
   catch (const std::exception& e)
   {
@@ -508,6 +576,11 @@ std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo&
     return std::error_code();
   }
 
+  return preprocessOutputs(blockInfo, tx, outputs, info);
+}
+
+std::error_code TransfersConsumer::preprocessOutputs(const TransactionBlockInfo& blockInfo, const ITransactionReader& tx,
+  const std::unordered_map<PublicKey, std::vector<uint32_t>>& outputs, PreprocessInfo& info) {
   if (outputs.empty())
   {
     return std::error_code();
@@ -0,0 +1,47 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "Chacha8Streams.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Common/StreamTools.h"
+
+namespace CryptoNote {
+
+Chacha8OutputStream::Chacha8OutputStream(Common::IOutputStream& destination, const Crypto::chacha8_key& key, const Crypto::chacha8_iv& iv) :
+  destination(destination) {
+  Crypto::chacha8_init(state, key, iv);
+}
+
+Chacha8OutputStream::~Chacha8OutputStream() {
+  memset(&state, 0, sizeof(state));
+  memset(chunk, 0, sizeof(chunk));
+}
+
+size_t Chacha8OutputStream::writeSome(const void* data, size_t size) {
+  size_t chunkSize = std::min(size, CHUNK_SIZE);
+  Crypto::chacha8_update(state, data, chunkSize, chunk);
+  // the key stream has moved on, so the whole chunk has to reach the destination
+  Common::write(destination, chunk, chunkSize);
+  return chunkSize;
+}
+
+Chacha8InputStream::Chacha8InputStream(Common::IInputStream& source, const Crypto::chacha8_key& key, const Crypto::chacha8_iv& iv) :
+  source(source) {
+  Crypto::chacha8_init(state, key, iv);
+}
+
+Chacha8InputStream::~Chacha8InputStream() {
+  memset(&state, 0, sizeof(state));
+}
+
+size_t Chacha8InputStream::readSome(void* data, size_t size) {
+  size_t readSize = source.readSome(data, size);
+  Crypto::chacha8_update(state, data, readSize, static_cast<char*>(data));
+  return readSize;
+}
+
+}
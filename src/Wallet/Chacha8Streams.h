@@ -0,0 +1,45 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include "Common/IInputStream.h"
+#include "Common/IOutputStream.h"
+#include "crypto/chacha8.h"
+
+namespace CryptoNote {
+
+// Encrypts everything written to it with chacha8 and writes the cipher to the destination stream,
+// a chunk at a time, so the whole plaintext never has to be in memory at once
+class Chacha8OutputStream : public Common::IOutputStream {
+public:
+  Chacha8OutputStream(Common::IOutputStream& destination, const Crypto::chacha8_key& key, const Crypto::chacha8_iv& iv);
+  ~Chacha8OutputStream();
+  Chacha8OutputStream& operator=(const Chacha8OutputStream&) = delete;
+
+  virtual size_t writeSome(const void* data, size_t size) override;
+
+private:
+  static const size_t CHUNK_SIZE = 16 * 1024;
+
+  Common::IOutputStream& destination;
+  Crypto::chacha8_state state;
+  char chunk[CHUNK_SIZE];
+};
+
+// Reads a chacha8 cipher from the source stream and decrypts it as it is read
+class Chacha8InputStream : public Common::IInputStream {
+public:
+  Chacha8InputStream(Common::IInputStream& source, const Crypto::chacha8_key& key, const Crypto::chacha8_iv& iv);
+  ~Chacha8InputStream();
+  Chacha8InputStream& operator=(const Chacha8InputStream&) = delete;
+
+  virtual size_t readSome(void* data, size_t size) override;
+
+private:
+  Common::IInputStream& source;
+  Crypto::chacha8_state state;
+};
+
+}
@@ -23,6 +23,7 @@
 
 #include "ITransaction.h"
 
+#include "Common/MemoryInputStream.h"
 #include "Common/ScopeExit.h"
 #include "Common/ShuffleGenerator.h"
 #include "Common/StdInputStream.h"
@@ -30,6 +31,7 @@
 #include "Common/StreamTools.h"
 #include "Common/StringOutputStream.h"
 #include "Common/StringTools.h"
+#include "Common/VectorOutputStream.h"
 #include "CryptoNoteCore/Account.h"
 #include "CryptoNoteCore/Currency.h"
 #include "CryptoNoteCore/CryptoNoteBasicImpl.h"
@@ -39,6 +41,7 @@
 #include "CryptoNoteCore/TransactionApi.h"
 #include "crypto/crypto.h"
 #include "Transfers/TransfersContainer.h"
+#include "Chacha8Streams.h"
 #include "WalletSerializationV2.h"
 #include "WalletErrors.h"
 #include "WalletUtils.h"
@@ -116,6 +119,89 @@ uint64_t calculateDonationAmount(uint64_t freeAmount, uint64_t donationThreshold
   return donationAmount;
 }
 
+/* The container suffix is { suffixIv, encryptedContainer } as written by BinaryOutputStreamSerializer,
+   which stores a BinaryArray as its varint size followed by every byte as a varint, so bytes from 0x80
+   up take two. These write and read that layout directly instead of through the serializer byte by byte. */
+void writeContainerSuffix(ContainerStorage& storage, const Crypto::chacha8_iv& suffixIv, const BinaryArray& encryptedContainer) {
+  std::string suffixHeader;
+  Common::StringOutputStream suffixHeaderStream(suffixHeader);
+  BinaryOutputStreamSerializer suffixSerializer(suffixHeaderStream);
+  Crypto::chacha8_iv iv = suffixIv;
+  suffixSerializer(iv, "suffixIv");
+  writeVarint(suffixHeaderStream, static_cast<uint64_t>(encryptedContainer.size()));
+
+  size_t encodedSize = encryptedContainer.size();
+  for (auto byte : encryptedContainer) {
+    encodedSize += byte >> 7;
+  }
+
+  storage.resizeSuffix(suffixHeader.size() + encodedSize);
+  uint8_t* out = std::copy(suffixHeader.begin(), suffixHeader.end(), storage.suffix());
+  for (auto byte : encryptedContainer) {
+    *out++ = byte;
+    if (byte >= 0x80) {
+      *out++ = 1;
+    }
+  }
+}
+
+void readContainerSuffix(const ContainerStorage& storage, Crypto::chacha8_iv& suffixIv, BinaryArray& encryptedContainer) {
+  Common::MemoryInputStream suffixStream(storage.suffix(), storage.suffixSize());
+  BinaryInputStreamSerializer suffixSerializer(suffixStream);
+  suffixSerializer(suffixIv, "suffixIv");
+  uint64_t size;
+  readVarint(suffixStream, size);
+
+  const uint8_t* in = storage.suffix() + suffixStream.getPosition();
+  const uint8_t* end = storage.suffix() + storage.suffixSize();
+  if (size > static_cast<uint64_t>(end - in)) {
+    throw std::runtime_error("Encrypted container is truncated");
+  }
+
+  encryptedContainer.resize(static_cast<size_t>(size));
+  for (auto& byte : encryptedContainer) {
+    if (in == end) {
+      throw std::runtime_error("Encrypted container is truncated");
+    }
+
+    byte = *in++;
+    if (byte >= 0x80) {
+      // the only valid second byte of a varint below 0x100
+      if (in == end || *in != 1) {
+        throw std::runtime_error("Encrypted container has invalid byte representation");
+      }
+
+      ++in;
+    }
+  }
+}
+
+Crypto::chacha8_iv readContainerSuffixIv(const ContainerStorage& storage) {
+  // a container that has never been saved has no suffix, its journal follows the bare keys
+  Crypto::chacha8_iv suffixIv = Crypto::chacha8_iv();
+  if (storage.suffixSize() > 0) {
+    Common::MemoryInputStream suffixStream(storage.suffix(), storage.suffixSize());
+    BinaryInputStreamSerializer suffixSerializer(suffixStream);
+    suffixSerializer(suffixIv, "suffixIv");
+  }
+
+  return suffixIv;
+}
+
+const uint8_t JOURNAL_TRANSACTION_RECORD = 1;
+const uint8_t JOURNAL_SYNC_HEIGHT_RECORD = 2;
+
+// The journal is folded into the container once it has grown this big, or once this many blocks
+// have been synchronized since the container was saved, which bounds the rescan after a crash
+const uint64_t JOURNAL_COMPACTION_SIZE = 4 * 1024 * 1024;
+const uint32_t JOURNAL_COMPACTION_BLOCKS = 10000;
+
+const uint32_t INVALID_BLOCK_INDEX = std::numeric_limits<uint32_t>::max();
+
+std::string getJournalPath(const std::string& path) {
+  return path + ".journal";
+}
+
 }
 
 namespace CryptoNote {
@@ -131,12 +217,16 @@ WalletGreen::WalletGreen(System::Dispatcher& dispatcher, const Currency& currenc
   m_synchronizer(currency, logger, m_blockchainSynchronizer, node),
   m_eventOccurred(m_dispatcher),
   m_readyEvent(m_dispatcher),
+  m_saveEvent(m_dispatcher),
   m_state(WalletState::NOT_INITIALIZED),
   m_actualBalance(0),
   m_pendingBalance(0),
-  m_transactionSoftLockTime(transactionSoftLockTime)
+  m_transactionSoftLockTime(transactionSoftLockTime),
+  m_journalSnapshotHeight(0),
+  m_journalSyncHeight(0)
 {
   m_readyEvent.set();
+  m_saveEvent.set();
 }
 
 WalletGreen::~WalletGreen() {
@@ -188,6 +278,8 @@ void WalletGreen::initializeWithViewKey(const std::string& path, const std::stri
 }
 
 void WalletGreen::shutdown() {
+  System::EventLock lk(m_saveEvent);
+
   throwIfNotInitialized();
   doShutdown();
 
@@ -205,6 +297,7 @@ void WalletGreen::doShutdown() {
   m_blockchainSynchronizer.removeObserver(this);
 
   m_containerStorage.close();
+  m_journal.close();
   m_walletsContainer.clear();
 
   clearCaches(true, true);
@@ -369,6 +462,10 @@ void WalletGreen::initWithKeys(const std::string& path, const std::string& passw
   m_containerStorage.swap(newStorage);
   incNextIv();
 
+  m_journal.create(getJournalPath(path), m_key, readContainerSuffixIv(m_containerStorage));
+  m_journalSnapshotHeight = 0;
+  m_journalSyncHeight = 0;
+
   m_viewPublicKey = viewPublicKey;
   m_viewSecretKey = viewSecretKey;
   m_password = password;
@@ -386,20 +483,19 @@ void WalletGreen::initWithKeys(const std::string& path, const std::string& passw
 void WalletGreen::save(WalletSaveLevel saveLevel, const std::string& extra) {
   m_logger(INFO, BRIGHT_WHITE) << "Saving container...";
 
+  System::EventLock lk(m_saveEvent);
+
   throwIfNotInitialized();
   throwIfStopped();
 
-  stopBlockchainSynchronizer();
-
+  // the synchronizer keeps running, saveWalletCache() takes a consistent snapshot of it
   try {
     saveWalletCache(m_containerStorage, m_key, saveLevel, extra);
   } catch (const std::exception& e) {
     m_logger(ERROR, BRIGHT_RED) << "Failed to save container: " << e.what();
-    startBlockchainSynchronizer();
     throw;
   }
 
-  startBlockchainSynchronizer();
   m_logger(INFO, BRIGHT_WHITE) << "Container saved";
 }
 
@@ -483,6 +579,7 @@ void WalletGreen::load(const std::string& path, const std::string& password, std
         std::unordered_set<Crypto::PublicKey> addedSpendKeys;
         std::unordered_set<Crypto::PublicKey> deletedSpendKeys;
         loadWalletCache(addedSpendKeys, deletedSpendKeys, extra);
+        replayJournal(path);
 
         if (!addedSpendKeys.empty()) {
           m_logger(WARNING, BRIGHT_YELLOW) << "Found addresses not saved in container cache. Resynchronize container";
@@ -502,7 +599,10 @@ void WalletGreen::load(const std::string& path, const std::string& password, std
         m_logger(ERROR, BRIGHT_RED) << "Failed to load cache: " << e.what() << ", reset wallet data";
         clearCaches(true, true);
         subscribeWallets();
+        m_journal.create(getJournalPath(path), m_key, readContainerSuffixIv(m_containerStorage));
       }
+    } else {
+      replayJournal(path);
     }
   }
 
@@ -587,8 +687,10 @@ void WalletGreen::loadContainerStorage(const std::string& path) {
 void WalletGreen::loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKeys, std::unordered_set<Crypto::PublicKey>& deletedKeys, std::string& extra) {
   assert(m_containerStorage.isOpened());
 
-  BinaryArray contanerData;
-  loadAndDecryptContainerData(m_containerStorage, m_key, contanerData);
+  // decrypted as it is deserialized, so the plain container is never in memory as a whole
+  Crypto::chacha8_iv suffixIv;
+  BinaryArray encryptedContainer;
+  readContainerSuffix(m_containerStorage, suffixIv, encryptedContainer);
 
   WalletSerializerV2 s(
     *this,
@@ -606,7 +708,8 @@ void WalletGreen::loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKe
     m_transactionSoftLockTime
   );
 
-  Common::MemoryInputStream containerStream(contanerData.data(), contanerData.size());
+  Common::MemoryInputStream encryptedContainerStream(encryptedContainer.data(), encryptedContainer.size());
+  Chacha8InputStream containerStream(encryptedContainerStream, m_key, suffixIv);
   s.load(containerStream, reinterpret_cast<const ContainerStoragePrefix*>(m_containerStorage.prefix())->version);
   addedKeys = std::move(s.addedKeys());
   deletedKeys = std::move(s.deletedKeys());
@@ -617,6 +720,12 @@ void WalletGreen::loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKe
 void WalletGreen::saveWalletCache(ContainerStorage& storage, const Crypto::chacha8_key& key, WalletSaveLevel saveLevel, const std::string& extra) {
   m_logger(DEBUGGING) << "Saving cache...";
 
+  // taken first, as it lets the wallet catch up with the synchronizer state being saved
+  std::string transfersSynchronizerState;
+  if (saveLevel == WalletSaveLevel::SAVE_ALL) {
+    transfersSynchronizerState = saveTransfersSynchronizerState();
+  }
+
   WalletTransactions transactions;
   WalletTransfers transfers;
 
@@ -637,8 +746,14 @@ void WalletGreen::saveWalletCache(ContainerStorage& storage, const Crypto::chach
     });
   }
 
-  std::string containerData;
-  Common::StringOutputStream containerStream(containerData);
+  ContainerStoragePrefix* prefix = reinterpret_cast<ContainerStoragePrefix*>(storage.prefix());
+  Crypto::chacha8_iv suffixIv = prefix->nextIv;
+  incIv(prefix->nextIv);
+
+  // encrypted as it is serialized, so the plain container is never in memory as a whole
+  BinaryArray encryptedContainer;
+  Common::VectorOutputStream encryptedContainerStream(encryptedContainer);
+  Chacha8OutputStream containerStream(encryptedContainerStream, key, suffixIv);
 
   WalletSerializerV2 s(
     *this,
@@ -656,16 +771,245 @@ void WalletGreen::saveWalletCache(ContainerStorage& storage, const Crypto::chach
     m_transactionSoftLockTime
   );
 
-  s.save(containerStream, saveLevel);
+  s.save(containerStream, saveLevel, transfersSynchronizerState);
 
-  encryptAndSaveContainerData(storage, key, containerData.data(), containerData.size());
+  writeContainerSuffix(storage, suffixIv, encryptedContainer);
   storage.flush();
 
   m_extra = extra;
 
+  if (&storage == &m_containerStorage && m_journal.isOpened()) {
+    // everything journaled so far is in the container now, the new journal starts at its height
+    m_journal.restart(key, suffixIv);
+    m_journalSnapshotHeight = 0;
+    journalSyncHeight(m_journalSyncHeight);
+    commitJournal();
+  }
+
   m_logger(DEBUGGING) << "Container saving finished";
 }
 
+std::string WalletGreen::saveTransfersSynchronizerState() {
+  std::stringstream stream;
+
+  if (!m_blockchainSynchronizerStarted) {
+    m_synchronizer.save(stream);
+    return stream.str();
+  }
+
+  // The synchronizer is not stopped: its consumers are only locked while they are saved. Every event of
+  // the state saved has been queued to the dispatcher by then, so once the event queued behind them runs
+  // the wallet is at least as far as that state. A wallet ahead of it is caught up again on load.
+  System::Event eventsApplied(m_dispatcher);
+  m_blockchainSynchronizer.withConsumersLocked([this, &stream, &eventsApplied] {
+    m_synchronizer.save(stream);
+    m_dispatcher.remoteSpawn([&eventsApplied] { eventsApplied.set(); });
+  });
+
+  eventsApplied.wait();
+  throwIfNotInitialized();
+
+  return stream.str();
+}
+
+void WalletGreen::replayJournal(const std::string& path) {
+  m_journalSnapshotHeight = 0;
+  m_journalSyncHeight = 0;
+
+  try {
+    std::vector<BinaryArray> records;
+    m_journal.open(getJournalPath(path), m_key, readContainerSuffixIv(m_containerStorage), records);
+
+    for (const auto& record : records) {
+      applyJournalRecord(record);
+    }
+
+    if (!records.empty()) {
+      m_logger(INFO, BRIGHT_WHITE) << "Wallet journal replayed, records " << records.size() << ", synchronized height " << m_journalSyncHeight;
+    }
+  } catch (const std::exception& e) {
+    m_logger(ERROR, BRIGHT_RED) << "Failed to replay wallet journal: " << e.what() << ", continue from the saved container";
+    m_journal.create(getJournalPath(path), m_key, readContainerSuffixIv(m_containerStorage));
+  }
+}
+
+void WalletGreen::applyJournalRecord(const BinaryArray& record) {
+  Common::MemoryInputStream stream(record.data(), record.size());
+  BinaryInputStreamSerializer s(stream);
+
+  uint8_t type;
+  s(type, "type");
+
+  if (type == JOURNAL_SYNC_HEIGHT_RECORD) {
+    uint32_t height;
+    s(height, "height");
+    if (m_journalSnapshotHeight == 0) {
+      m_journalSnapshotHeight = height;
+    }
+
+    m_journalSyncHeight = height;
+    return;
+  }
+
+  if (type != JOURNAL_TRANSACTION_RECORD) {
+    throw std::runtime_error("Unknown wallet journal record type " + std::to_string(type));
+  }
+
+  WalletTransaction transaction;
+  WalletSerializerV2::serializeTransaction(s, transaction);
+
+  uint64_t transferCount;
+  s(transferCount, "transferCount");
+
+  WalletTransfers transfers;
+  for (uint64_t i = 0; i < transferCount; ++i) {
+    WalletTransfer transfer;
+    WalletSerializerV2::serializeTransfer(s, transfer);
+    transfers.emplace_back(0, std::move(transfer));
+  }
+
+  bool isUncommited;
+  s(isUncommited, "isUncommited");
+
+  CryptoNote::Transaction uncommitedTransaction;
+  if (isUncommited) {
+    s(uncommitedTransaction, "uncommitedTransaction");
+  }
+
+  // the latest record of a transaction has all of it, so it simply replaces what is known
+  size_t transactionId;
+  auto& hashIndex = m_transactions.get<TransactionIndex>();
+  auto it = hashIndex.find(transaction.hash);
+  WalletTransfers::iterator transfersPosition;
+  if (it != hashIndex.end()) {
+    transactionId = std::distance(m_transactions.get<RandomAccessIndex>().begin(), m_transactions.project<RandomAccessIndex>(it));
+    hashIndex.replace(it, transaction);
+
+    auto range = getTransactionTransfersRange(transactionId);
+    transfersPosition = m_transfers.erase(range.first, range.second);
+  } else {
+    transactionId = m_transactions.get<RandomAccessIndex>().size();
+    m_transactions.get<RandomAccessIndex>().push_back(transaction);
+    transfersPosition = m_transfers.end();
+  }
+
+  for (auto& transfer : transfers) {
+    transfer.first = transactionId;
+  }
+
+  m_transfers.insert(transfersPosition, transfers.begin(), transfers.end());
+  m_fusionTxsCache.erase(transactionId);
+
+  if (isUncommited) {
+    m_uncommitedTransactions[transactionId] = std::move(uncommitedTransaction);
+  } else {
+    m_uncommitedTransactions.erase(transactionId);
+  }
+}
+
+void WalletGreen::journalTransaction(size_t transactionId) {
+  if (!m_journal.isOpened()) {
+    return;
+  }
+
+  WalletTransaction transaction = m_transactions.get<RandomAccessIndex>()[transactionId];
+  auto range = getTransactionTransfersRange(transactionId);
+  auto uncommited = m_uncommitedTransactions.find(transactionId);
+
+  BinaryArray record;
+  Common::VectorOutputStream stream(record);
+  BinaryOutputStreamSerializer s(stream);
+
+  uint8_t type = JOURNAL_TRANSACTION_RECORD;
+  s(type, "type");
+  WalletSerializerV2::serializeTransaction(s, transaction);
+
+  uint64_t transferCount = std::distance(range.first, range.second);
+  s(transferCount, "transferCount");
+  for (auto it = range.first; it != range.second; ++it) {
+    WalletTransfer transfer = it->second;
+    WalletSerializerV2::serializeTransfer(s, transfer);
+  }
+
+  bool isUncommited = uncommited != m_uncommitedTransactions.end();
+  s(isUncommited, "isUncommited");
+  if (isUncommited) {
+    s(uncommited->second, "uncommitedTransaction");
+  }
+
+  try {
+    m_journal.append(record);
+  } catch (const std::exception& e) {
+    // the change is still saved with the container, only a crash before that would lose it
+    m_logger(ERROR, BRIGHT_RED) << "Failed to journal transaction " << transaction.hash << ": " << e.what();
+  }
+}
+
+void WalletGreen::journalSyncHeight(uint32_t height) {
+  if (m_journalSnapshotHeight == 0) {
+    m_journalSnapshotHeight = height;
+  }
+
+  // a restarted journal is empty and starts with the height of the container save it follows
+  if (height == m_journalSyncHeight && m_journal.recordCount() != 0) {
+    return;
+  }
+
+  m_journalSyncHeight = height;
+  if (!m_journal.isOpened()) {
+    return;
+  }
+
+  BinaryArray record;
+  Common::VectorOutputStream stream(record);
+  BinaryOutputStreamSerializer s(stream);
+
+  uint8_t type = JOURNAL_SYNC_HEIGHT_RECORD;
+  s(type, "type");
+  s(height, "height");
+
+  try {
+    m_journal.append(record);
+  } catch (const std::exception& e) {
+    m_logger(ERROR, BRIGHT_RED) << "Failed to journal synchronized height " << height << ": " << e.what();
+  }
+}
+
+void WalletGreen::commitJournal() {
+  if (!m_journal.isOpened()) {
+    return;
+  }
+
+  try {
+    m_journal.commit();
+  } catch (const std::exception& e) {
+    m_logger(ERROR, BRIGHT_RED) << "Failed to commit wallet journal: " << e.what();
+  }
+}
+
+void WalletGreen::compactJournalIfNeeded() {
+  // a save, or another compaction, may be running and waiting for the wallet to catch up with
+  // the synchronizer state it saves, so the journal is checked once it is finished
+  System::EventLock lk(m_saveEvent);
+
+  if (!m_journal.isOpened() || m_state != WalletState::INITIALIZED || m_stopped) {
+    return;
+  }
+
+  if (m_journal.size() < JOURNAL_COMPACTION_SIZE && m_journalSyncHeight < m_journalSnapshotHeight + JOURNAL_COMPACTION_BLOCKS) {
+    return;
+  }
+
+  m_logger(DEBUGGING) << "Compacting wallet journal, records " << m_journal.recordCount() << ", size " << m_journal.size() <<
+    ", blocks since save " << (m_journalSyncHeight - m_journalSnapshotHeight);
+
+  try {
+    saveWalletCache(m_containerStorage, m_key, WalletSaveLevel::SAVE_ALL, m_extra);
+  } catch (const std::exception& e) {
+    m_logger(ERROR, BRIGHT_RED) << "Failed to compact wallet journal: " << e.what();
+  }
+}
+
 void WalletGreen::copyContainerStorageKeys(ContainerStorage& src, const chacha8_key& srcKey, ContainerStorage& dst, const chacha8_key& dstKey) {
   m_logger(DEBUGGING) << "Copying wallet keys...";
   dst.reserve(src.size());
@@ -723,26 +1067,13 @@ void WalletGreen::encryptAndSaveContainerData(ContainerStorage& storage, const C
   encryptedContainer.resize(containerDataSize);
   chacha8(containerData, containerDataSize, key, suffixIv, reinterpret_cast<char*>(encryptedContainer.data()));
 
-  std::string suffix;
-  Common::StringOutputStream suffixStream(suffix);
-  BinaryOutputStreamSerializer suffixSerializer(suffixStream);
-  suffixSerializer(suffixIv, "suffixIv");
-  suffixSerializer(encryptedContainer, "encryptedContainer");
-
-  storage.resizeSuffix(suffix.size());
-  std::copy(suffix.begin(), suffix.end(), storage.suffix());
+  writeContainerSuffix(storage, suffixIv, encryptedContainer);
 }
 
 void WalletGreen::loadAndDecryptContainerData(ContainerStorage& storage, const Crypto::chacha8_key& key, BinaryArray& containerData) {
-  Common::MemoryInputStream suffixStream(storage.suffix(), storage.suffixSize());
-  BinaryInputStreamSerializer suffixSerializer(suffixStream);
   Crypto::chacha8_iv suffixIv;
-  BinaryArray encryptedContainer;
-  suffixSerializer(suffixIv, "suffixIv");
-  suffixSerializer(encryptedContainer, "encryptedContainer");
-
-  containerData.resize(encryptedContainer.size());
-  chacha8(encryptedContainer.data(), encryptedContainer.size(), key, suffixIv, reinterpret_cast<char*>(containerData.data()));
+  readContainerSuffix(storage, suffixIv, containerData);
+  chacha8(containerData.data(), containerData.size(), key, suffixIv, reinterpret_cast<char*>(containerData.data()));
 }
 
 void WalletGreen::initTransactionPool() {
@@ -871,6 +1202,10 @@ void WalletGreen::changePassword(const std::string& oldPassword, const std::stri
   m_key = newKey;
   m_password = newPassword;
 
+  if (m_journal.isOpened()) {
+    m_journal.rekey(m_key, readContainerSuffixIv(m_containerStorage));
+  }
+
   m_logger(INFO, BRIGHT_WHITE) << "Container password changed";
 }
 
@@ -1893,8 +2228,10 @@ void WalletGreen::commitTransaction(size_t transactionId) {
   completion.wait();
 
   if (!ec) {
-    updateTransactionStateAndPushEvent(transactionId, WalletTransactionState::SUCCEEDED);
+    // erased first, the event journals the transaction as it is from now on
     m_uncommitedTransactions.erase(transactionId);
+    updateTransactionStateAndPushEvent(transactionId, WalletTransactionState::SUCCEEDED);
+    commitJournal();
   } else {
     m_logger(ERROR, BRIGHT_RED) << "Failed to relay transaction: " << ec << ", " << ec.message() << ". Transaction index " << transactionId;
     throw std::system_error(ec);
@@ -1928,6 +2265,8 @@ void WalletGreen::rollbackUncommitedTransaction(size_t transactionId) {
 
   removeUnconfirmedTransaction(getObjectHash(m_uncommitedTransactions[transactionId]));
   m_uncommitedTransactions.erase(transactionId);
+  journalTransaction(transactionId);
+  commitJournal();
 
   m_logger(INFO, BRIGHT_WHITE) << "Delayed transaction rolled back, ID " << transactionId << ", hash " << m_transactions[transactionId].hash;
 }
@@ -1956,6 +2295,7 @@ size_t WalletGreen::insertOutgoingTransactionAndPushEvent(const Hash& transactio
   insertTx.totalAmount = 0; // 0 until transactionHandlingEnd() is called
   insertTx.timestamp = 0; //0 until included in a block
   insertTx.isBase = false;
+  insertTx.paymentId = getPaymentIdFromExtra(insertTx.extra);
 
   size_t txId = m_transactions.get<RandomAccessIndex>().size();
   m_transactions.get<RandomAccessIndex>().push_back(std::move(insertTx));
@@ -2013,6 +2353,7 @@ bool WalletGreen::updateWalletTransactionInfo(size_t transactionId, const Crypto
     // Fix LegacyWallet error. Some old versions didn't fill extra field
     if (transaction.extra.empty() && !info.extra.empty()) {
       transaction.extra = Common::asString(info.extra);
+      transaction.paymentId = info.paymentId;
       updated = true;
     }
 
@@ -2055,6 +2396,7 @@ size_t WalletGreen::insertBlockchainTransaction(const TransactionInformation& in
   tx.extra.assign(reinterpret_cast<const char*>(info.extra.data()), info.extra.size());
   tx.totalAmount = txBalance;
   tx.creationTime = info.timestamp;
+  tx.paymentId = info.paymentId;
 
   size_t txId = index.size();
   index.push_back(std::move(tx));
@@ -2343,6 +2685,11 @@ size_t WalletGreen::validateSaveAndSendTransaction(const ITransactionReader& tra
     throw std::system_error(make_error_code(error::INTERNAL_WALLET_ERROR), "Failed to deserialize created transaction");
   }
 
+  // the transaction is on the disk before the caller learns about it, rolled back or not
+  Tools::ScopeExit commitTransactionJournal([this] {
+    commitJournal();
+  });
+
   uint64_t fee = transaction.getInputTotalAmount() - transaction.getOutputTotalAmount();
   size_t transactionId = insertOutgoingTransactionAndPushEvent(transaction.getTransactionHash(), fee, transaction.getExtra(), transaction.getUnlockTime());
   m_logger(DEBUGGING) << "Transaction added to container, ID " << transactionId <<
@@ -2355,6 +2702,7 @@ size_t WalletGreen::validateSaveAndSendTransaction(const ITransactionReader& tra
 
   m_fusionTxsCache.emplace(transactionId, isFusion);
   pushBackOutgoingTransfers(transactionId, destinations);
+  journalTransaction(transactionId);
 
   addUnconfirmedTransaction(transaction);
   Tools::ScopeExit rollbackAddingUnconfirmedTransaction([this, &transaction] {
@@ -2374,6 +2722,7 @@ size_t WalletGreen::validateSaveAndSendTransaction(const ITransactionReader& tra
   } else {
     assert(m_uncommitedTransactions.count(transactionId) == 0);
     m_uncommitedTransactions.emplace(transactionId, std::move(cryptoNoteTransaction));
+    journalTransaction(transactionId);
     m_logger(DEBUGGING) << "Transaction delayed, ID " << transactionId << ", hash " << transaction.getTransactionHash();
   }
 
@@ -2619,15 +2968,11 @@ std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(const Crypto::
   throwIfNotInitialized();
   throwIfStopped();
 
-  auto& hashIndex = m_blockchain.get<BlockHashIndex>();
-  auto it = hashIndex.find(blockHash);
-  if (it == hashIndex.end()) {
+  uint32_t blockIndex = getBlockIndexByHash(blockHash);
+  if (blockIndex == INVALID_BLOCK_INDEX) {
     return std::vector<TransactionsInBlockInfo>();
   }
 
-  auto heightIt = m_blockchain.project<BlockHeightIndex>(it);
-
-  uint32_t blockIndex = static_cast<uint32_t>(std::distance(m_blockchain.get<BlockHeightIndex>().begin(), heightIt));
   return getTransactionsInBlocks(blockIndex, count);
 }
 
@@ -2638,6 +2983,25 @@ std::vector<TransactionsInBlockInfo> WalletGreen::getTransactions(uint32_t block
   return getTransactionsInBlocks(blockIndex, count);
 }
 
+std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsByPaymentId(const Crypto::Hash& paymentId, const Crypto::Hash& blockHash, size_t count) const {
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  uint32_t blockIndex = getBlockIndexByHash(blockHash);
+  if (blockIndex == INVALID_BLOCK_INDEX) {
+    return std::vector<TransactionsInBlockInfo>();
+  }
+
+  return getTransactionsInBlocksByPaymentId(paymentId, blockIndex, count);
+}
+
+std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsByPaymentId(const Crypto::Hash& paymentId, uint32_t blockIndex, size_t count) const {
+  throwIfNotInitialized();
+  throwIfStopped();
+
+  return getTransactionsInBlocksByPaymentId(paymentId, blockIndex, count);
+}
+
 std::vector<Crypto::Hash> WalletGreen::getBlockHashes(uint32_t blockIndex, size_t count) const {
   throwIfNotInitialized();
   throwIfStopped();
@@ -2748,18 +3112,27 @@ void WalletGreen::synchronizationCompleted(std::error_code result) {
 void WalletGreen::onSynchronizationProgressUpdated(uint32_t processedBlockCount, uint32_t totalBlockCount) {
   assert(processedBlockCount > 0);
 
-  System::EventLock lk(m_readyEvent);
+  {
+    System::EventLock lk(m_readyEvent);
 
-  m_logger(TRACE) << "onSynchronizationProgressUpdated processedBlockCount " << processedBlockCount << ", totalBlockCount " << totalBlockCount;
+    m_logger(TRACE) << "onSynchronizationProgressUpdated processedBlockCount " << processedBlockCount << ", totalBlockCount " << totalBlockCount;
 
-  if (m_state == WalletState::NOT_INITIALIZED) {
-    return;
-  }
+    if (m_state == WalletState::NOT_INITIALIZED) {
+      return;
+    }
 
-  pushEvent(makeSyncProgressUpdatedEvent(processedBlockCount, totalBlockCount));
+    pushEvent(makeSyncProgressUpdatedEvent(processedBlockCount, totalBlockCount));
 
-  uint32_t currentHeight = processedBlockCount - 1;
-  unlockBalances(currentHeight);
+    uint32_t currentHeight = processedBlockCount - 1;
+    unlockBalances(currentHeight);
+
+    // the last event of a synchronizer batch, everything the batch journaled goes to the disk at once
+    journalSyncHeight(currentHeight);
+    commitJournal();
+  }
+
+  // saving waits for the events queued before it, and they take m_readyEvent, so it is released by now
+  compactJournalIfNeeded();
 }
 
 void WalletGreen::onSynchronizationCompleted() {
@@ -2771,6 +3144,8 @@ void WalletGreen::onSynchronizationCompleted() {
     return;
   }
 
+  // pool updates end the synchronizer round without a progress update
+  commitJournal();
   pushEvent(makeSyncCompletedEvent());
 }
 
@@ -2938,6 +3313,12 @@ void WalletGreen::transactionUpdated(const TransactionInformation& transactionIn
 }
 
 void WalletGreen::pushEvent(const WalletEvent& event) {
+  if (event.type == WalletEventType::TRANSACTION_CREATED) {
+    journalTransaction(event.transactionCreated.transactionIndex);
+  } else if (event.type == WalletEventType::TRANSACTION_UPDATED) {
+    journalTransaction(event.transactionUpdated.transactionIndex);
+  }
+
   m_events.push(event);
   m_eventOccurred.set();
 }
@@ -3496,6 +3877,70 @@ std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsInBlocks(uint32
   return result;
 }
 
+std::vector<TransactionsInBlockInfo> WalletGreen::getTransactionsInBlocksByPaymentId(const Crypto::Hash& paymentId, uint32_t blockIndex, size_t count) const {
+  if (count == 0) {
+    m_logger(ERROR, BRIGHT_RED) << "Bad argument: block count must be greater than zero";
+    throw std::system_error(make_error_code(error::WRONG_PARAMETERS), "blocks count must be greater than zero");
+  }
+
+  if (blockIndex == 0) {
+    m_logger(ERROR, BRIGHT_RED) << "Bad argument: blockIndex must be greater than zero";
+    throw std::system_error(make_error_code(error::WRONG_PARAMETERS), "blockIndex must be greater than zero");
+  }
+
+  std::vector<TransactionsInBlockInfo> result;
+
+  if (blockIndex >= m_blockchain.size()) {
+    return result;
+  }
+
+  uint32_t stopIndex = static_cast<uint32_t>(std::min(m_blockchain.size(), blockIndex + count));
+
+  // { block height, transaction id }, so the transactions come out in the same order getTransactionsInBlocks() gives them
+  std::vector<std::pair<uint32_t, size_t>> found;
+  auto& transactionIdIndex = m_transactions.get<RandomAccessIndex>();
+  auto bounds = m_transactions.get<PaymentIdIndex>().equal_range(paymentId);
+  for (auto it = bounds.first; it != bounds.second; ++it) {
+    if (it->state != WalletTransactionState::SUCCEEDED || it->blockHeight < blockIndex || it->blockHeight >= stopIndex) {
+      continue;
+    }
+
+    auto idIt = m_transactions.project<RandomAccessIndex>(it);
+    found.emplace_back(it->blockHeight, static_cast<size_t>(std::distance(transactionIdIndex.begin(), idIt)));
+  }
+
+  std::sort(found.begin(), found.end());
+
+  for (const auto& entry : found) {
+    if (result.empty() || result.back().blockHash != m_blockchain[entry.first - 1]) {
+      TransactionsInBlockInfo info;
+      info.blockHash = m_blockchain[entry.first - 1];
+      result.emplace_back(std::move(info));
+    }
+
+    const WalletTransaction& transaction = transactionIdIndex[entry.second];
+
+    WalletTransactionWithTransfers transactionWithTransfers;
+    transactionWithTransfers.transaction = transaction;
+    transactionWithTransfers.transfers = getTransactionTransfers(transaction);
+
+    result.back().transactions.emplace_back(std::move(transactionWithTransfers));
+  }
+
+  return result;
+}
+
+uint32_t WalletGreen::getBlockIndexByHash(const Crypto::Hash& blockHash) const {
+  auto& hashIndex = m_blockchain.get<BlockHashIndex>();
+  auto it = hashIndex.find(blockHash);
+  if (it == hashIndex.end()) {
+    return INVALID_BLOCK_INDEX;
+  }
+
+  auto heightIt = m_blockchain.project<BlockHeightIndex>(it);
+  return static_cast<uint32_t>(std::distance(m_blockchain.get<BlockHeightIndex>().begin(), heightIt));
+}
+
 Crypto::Hash WalletGreen::getBlockHashByIndex(uint32_t blockIndex) const {
   assert(blockIndex < m_blockchain.size());
   return m_blockchain.get<BlockHeightIndex>()[blockIndex];
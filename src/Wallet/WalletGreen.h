@@ -24,6 +24,7 @@
 
 #include "IFusionManager.h"
 #include "WalletIndices.h"
+#include "WalletJournal.h"
 
 #include "Logging/LoggerRef.h"
 #include <System/Dispatcher.h>
@@ -87,6 +88,8 @@ public:
   virtual WalletTransactionWithTransfers getTransaction(const Crypto::Hash& transactionHash) const override;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(const Crypto::Hash& blockHash, size_t count) const override;
   virtual std::vector<TransactionsInBlockInfo> getTransactions(uint32_t blockIndex, size_t count) const override;
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByPaymentId(const Crypto::Hash& paymentId, const Crypto::Hash& blockHash, size_t count) const override;
+  virtual std::vector<TransactionsInBlockInfo> getTransactionsByPaymentId(const Crypto::Hash& paymentId, uint32_t blockIndex, size_t count) const override;
   virtual std::vector<Crypto::Hash> getBlockHashes(uint32_t blockIndex, size_t count) const override;
   virtual uint32_t getBlockCount() const override;
   virtual std::vector<WalletTransactionWithTransfers> getUnconfirmedTransactions() const override;
@@ -323,6 +326,13 @@ protected:
   void loadContainerStorage(const std::string& path);
   void loadWalletCache(std::unordered_set<Crypto::PublicKey>& addedKeys, std::unordered_set<Crypto::PublicKey>& deletedKeys, std::string& extra);
   void saveWalletCache(ContainerStorage& storage, const Crypto::chacha8_key& key, WalletSaveLevel saveLevel, const std::string& extra);
+  std::string saveTransfersSynchronizerState();
+  void replayJournal(const std::string& path);
+  void applyJournalRecord(const BinaryArray& record);
+  void journalTransaction(size_t transactionId);
+  void journalSyncHeight(uint32_t height);
+  void commitJournal();
+  void compactJournalIfNeeded();
   void subscribeWallets();
 
   std::vector<OutputToTransfer> pickRandomFusionInputs(const std::vector<std::string>& addresses,
@@ -344,6 +354,8 @@ protected:
 
   TransfersRange getTransactionTransfersRange(size_t transactionIndex) const;
   std::vector<TransactionsInBlockInfo> getTransactionsInBlocks(uint32_t blockIndex, size_t count) const;
+  std::vector<TransactionsInBlockInfo> getTransactionsInBlocksByPaymentId(const Crypto::Hash& paymentId, uint32_t blockIndex, size_t count) const;
+  uint32_t getBlockIndexByHash(const Crypto::Hash& blockHash) const;
   Crypto::Hash getBlockHashByIndex(uint32_t blockIndex) const;
 
   std::vector<WalletTransfer> getTransactionTransfers(const WalletTransaction& transaction) const;
@@ -377,6 +389,9 @@ protected:
   System::Event m_eventOccurred;
   std::queue<WalletEvent> m_events;
   mutable System::Event m_readyEvent;
+  // save and journal compaction wait for the wallet to catch up with the synchronizer, this keeps them
+  // apart from each other and from shutdown
+  System::Event m_saveEvent;
 
   WalletState m_state;
 
@@ -395,6 +410,11 @@ protected:
 
   BlockHashesContainer m_blockchain;
 
+  // changes made since the container was last saved
+  WalletJournal m_journal;
+  uint32_t m_journalSnapshotHeight;
+  uint32_t m_journalSyncHeight;
+
   friend std::ostream& operator<<(std::ostream& os, CryptoNote::WalletGreen::WalletState state);
   friend std::ostream& operator<<(std::ostream& os, CryptoNote::WalletGreen::WalletTrackingMode mode);
   friend class TransferListFormatter;
@@ -64,6 +64,7 @@ struct BlockHeightIndex {};
 
 struct TransactionHashIndex {};
 struct TransactionIndex {};
+struct PaymentIdIndex {};
 struct BlockHashIndex {};
 
 typedef boost::multi_index_container <
@@ -104,6 +105,9 @@ typedef boost::multi_index_container <
     >,
     boost::multi_index::ordered_non_unique < boost::multi_index::tag <BlockHeightIndex>,
       boost::multi_index::member<CryptoNote::WalletTransaction, uint32_t, &CryptoNote::WalletTransaction::blockHeight >
+    >,
+    boost::multi_index::hashed_non_unique < boost::multi_index::tag <PaymentIdIndex>,
+      boost::multi_index::member<CryptoNote::WalletTransaction, Crypto::Hash, &CryptoNote::WalletTransaction::paymentId >
     >
   >
 > WalletTransactions;
@@ -0,0 +1,268 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "WalletJournal.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <boost/filesystem.hpp>
+
+#include "crypto/crypto.h"
+#include "crypto/hash.h"
+
+namespace CryptoNote {
+
+namespace {
+
+const uint32_t JOURNAL_SIGNATURE = 0x4c4e524a; // "JRNL"
+const uint8_t JOURNAL_VERSION = 1;
+
+const size_t HEADER_SIZE = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(Crypto::chacha8_iv);
+// record is { size, iv, cipher, checksum }, the checksum covers everything before it
+const size_t RECORD_OVERHEAD = sizeof(uint32_t) + sizeof(Crypto::chacha8_iv) + sizeof(Crypto::Hash);
+
+}
+
+WalletJournal::WalletJournal() : m_file(nullptr), m_size(0), m_recordCount(0), m_uncommitted(false) {
+}
+
+WalletJournal::~WalletJournal() {
+  close();
+}
+
+void WalletJournal::create(const std::string& path, const Crypto::chacha8_key& key, const Crypto::chacha8_iv& snapshotIv) {
+  close();
+
+  m_path = path;
+  m_key = key;
+  m_snapshotIv = snapshotIv;
+  writeHeader();
+}
+
+void WalletJournal::open(const std::string& path, const Crypto::chacha8_key& key, const Crypto::chacha8_iv& snapshotIv, std::vector<BinaryArray>& records) {
+  close();
+
+  m_path = path;
+  m_key = key;
+  m_snapshotIv = snapshotIv;
+
+  records.clear();
+  readRecords(records);
+  if (m_size == 0) {
+    // missing or stale, nothing in it applies to the container as it is saved
+    writeHeader();
+    return;
+  }
+
+  openFile("ab");
+}
+
+void WalletJournal::close() {
+  closeFile();
+
+  memset(&m_key, 0, sizeof(m_key));
+  m_size = 0;
+  m_recordCount = 0;
+}
+
+bool WalletJournal::isOpened() const {
+  return m_file != nullptr;
+}
+
+void WalletJournal::restart(const Crypto::chacha8_key& key, const Crypto::chacha8_iv& snapshotIv) {
+  closeFile();
+
+  m_key = key;
+  m_snapshotIv = snapshotIv;
+  writeHeader();
+}
+
+void WalletJournal::rekey(const Crypto::chacha8_key& key, const Crypto::chacha8_iv& snapshotIv) {
+  closeFile();
+
+  std::vector<BinaryArray> records;
+  readRecords(records);
+
+  restart(key, snapshotIv);
+  for (const auto& record : records) {
+    append(record);
+  }
+
+  commit();
+}
+
+void WalletJournal::append(const BinaryArray& record) {
+  if (m_file == nullptr) {
+    throw std::runtime_error("Wallet journal is not opened");
+  }
+
+  uint32_t recordSize = static_cast<uint32_t>(record.size());
+  Crypto::chacha8_iv iv = Crypto::rand<Crypto::chacha8_iv>();
+
+  BinaryArray frame(RECORD_OVERHEAD + record.size());
+  uint8_t* out = frame.data();
+  memcpy(out, &recordSize, sizeof(recordSize));
+  out += sizeof(recordSize);
+  memcpy(out, &iv, sizeof(iv));
+  out += sizeof(iv);
+  Crypto::chacha8(record.data(), record.size(), m_key, iv, reinterpret_cast<char*>(out));
+  out += record.size();
+
+  Crypto::Hash checksum = Crypto::cn_fast_hash(frame.data(), out - frame.data());
+  memcpy(out, &checksum, sizeof(checksum));
+
+  write(frame.data(), frame.size());
+
+  m_size += frame.size();
+  ++m_recordCount;
+  m_uncommitted = true;
+}
+
+void WalletJournal::commit() {
+  if (m_file == nullptr) {
+    throw std::runtime_error("Wallet journal is not opened");
+  }
+
+  if (m_uncommitted) {
+    sync();
+  }
+}
+
+uint64_t WalletJournal::size() const {
+  return m_size;
+}
+
+size_t WalletJournal::recordCount() const {
+  return m_recordCount;
+}
+
+void WalletJournal::readRecords(std::vector<BinaryArray>& records) {
+  m_size = 0;
+  m_recordCount = 0;
+
+  std::ifstream file(m_path, std::ios_base::binary);
+  if (!file) {
+    return;
+  }
+
+  uint32_t signature;
+  uint8_t version;
+  Crypto::chacha8_iv snapshotIv;
+  file.read(reinterpret_cast<char*>(&signature), sizeof(signature));
+  file.read(reinterpret_cast<char*>(&version), sizeof(version));
+  file.read(reinterpret_cast<char*>(&snapshotIv), sizeof(snapshotIv));
+  if (!file || signature != JOURNAL_SIGNATURE || version != JOURNAL_VERSION || memcmp(&snapshotIv, &m_snapshotIv, sizeof(snapshotIv)) != 0) {
+    return;
+  }
+
+  file.seekg(0, std::ios_base::end);
+  uint64_t fileSize = file.tellg();
+  file.seekg(HEADER_SIZE);
+
+  uint64_t offset = HEADER_SIZE;
+  BinaryArray frame;
+  while (fileSize - offset >= RECORD_OVERHEAD) {
+    uint32_t recordSize;
+    file.read(reinterpret_cast<char*>(&recordSize), sizeof(recordSize));
+    if (!file || recordSize > fileSize - offset - RECORD_OVERHEAD) {
+      break;
+    }
+
+    frame.resize(RECORD_OVERHEAD + recordSize);
+    memcpy(frame.data(), &recordSize, sizeof(recordSize));
+    file.read(reinterpret_cast<char*>(frame.data() + sizeof(recordSize)), frame.size() - sizeof(recordSize));
+    if (!file) {
+      break;
+    }
+
+    size_t checkedSize = frame.size() - sizeof(Crypto::Hash);
+    Crypto::Hash checksum = Crypto::cn_fast_hash(frame.data(), checkedSize);
+    if (memcmp(&checksum, frame.data() + checkedSize, sizeof(checksum)) != 0) {
+      break;
+    }
+
+    Crypto::chacha8_iv iv;
+    memcpy(&iv, frame.data() + sizeof(recordSize), sizeof(iv));
+    const uint8_t* cipher = frame.data() + sizeof(recordSize) + sizeof(iv);
+
+    BinaryArray record(recordSize);
+    Crypto::chacha8(cipher, recordSize, m_key, iv, reinterpret_cast<char*>(record.data()));
+    records.emplace_back(std::move(record));
+
+    offset += frame.size();
+    ++m_recordCount;
+  }
+
+  file.close();
+
+  if (offset != fileSize) {
+    // the last record was cut short by a crash, the records before it are intact
+    boost::filesystem::resize_file(m_path, offset);
+  }
+
+  m_size = offset;
+}
+
+void WalletJournal::writeHeader() {
+  openFile("wb");
+
+  uint8_t header[HEADER_SIZE];
+  memcpy(header, &JOURNAL_SIGNATURE, sizeof(JOURNAL_SIGNATURE));
+  memcpy(header + sizeof(JOURNAL_SIGNATURE), &JOURNAL_VERSION, sizeof(JOURNAL_VERSION));
+  memcpy(header + sizeof(JOURNAL_SIGNATURE) + sizeof(JOURNAL_VERSION), &m_snapshotIv, sizeof(m_snapshotIv));
+  write(header, sizeof(header));
+  sync();
+
+  m_size = HEADER_SIZE;
+  m_recordCount = 0;
+}
+
+void WalletJournal::openFile(const char* mode) {
+  m_file = fopen(m_path.c_str(), mode);
+  if (m_file == nullptr) {
+    throw std::runtime_error("Failed to open wallet journal " + m_path);
+  }
+}
+
+void WalletJournal::closeFile() {
+  if (m_file != nullptr) {
+    fclose(m_file);
+    m_file = nullptr;
+  }
+
+  m_uncommitted = false;
+}
+
+void WalletJournal::write(const void* data, size_t size) {
+  if (fwrite(data, 1, size, m_file) != size) {
+    throw std::runtime_error("Failed to write wallet journal " + m_path);
+  }
+}
+
+void WalletJournal::sync() {
+  if (fflush(m_file) != 0) {
+    throw std::runtime_error("Failed to write wallet journal " + m_path);
+  }
+
+#ifdef _WIN32
+  int result = _commit(_fileno(m_file));
+#else
+  int result = fsync(fileno(m_file));
+#endif
+  if (result != 0) {
+    throw std::runtime_error("Failed to sync wallet journal " + m_path);
+  }
+
+  m_uncommitted = false;
+}
+
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "CryptoNote.h"
+#include "crypto/chacha8.h"
+
+namespace CryptoNote {
+
+// Append-only log of the wallet changes made after the last container save. Every record is
+// encrypted on its own and checksummed, so a record torn by a crash is cut off on the next open.
+// Records are buffered until commit(), which puts all of them on the disk with one sync.
+// The journal remembers the suffix iv of the container save it follows, so a journal left over
+// from an older save is recognised as stale and started over.
+class WalletJournal {
+public:
+  WalletJournal();
+  ~WalletJournal();
+  WalletJournal& operator=(const WalletJournal&) = delete;
+
+  // Creates an empty journal, replacing whatever is at path
+  void create(const std::string& path, const Crypto::chacha8_key& key, const Crypto::chacha8_iv& snapshotIv);
+  // Opens the journal at path and returns its records, if it follows the given save
+  void open(const std::string& path, const Crypto::chacha8_key& key, const Crypto::chacha8_iv& snapshotIv, std::vector<BinaryArray>& records);
+  void close();
+  bool isOpened() const;
+
+  // Drops all records, the journal follows a new container save from now on
+  void restart(const Crypto::chacha8_key& key, const Crypto::chacha8_iv& snapshotIv);
+  // Reencrypts the records with another key, after the container save they follow has been reencrypted too
+  void rekey(const Crypto::chacha8_key& key, const Crypto::chacha8_iv& snapshotIv);
+
+  void append(const BinaryArray& record);
+  // Writes the records appended since the last commit and waits until they are on the disk
+  void commit();
+
+  uint64_t size() const;
+  size_t recordCount() const;
+
+private:
+  void readRecords(std::vector<BinaryArray>& records);
+  void writeHeader();
+  void openFile(const char* mode);
+  void closeFile();
+  void write(const void* data, size_t size);
+  void sync();
+
+  std::string m_path;
+  FILE* m_file;
+  Crypto::chacha8_key m_key;
+  Crypto::chacha8_iv m_snapshotIv;
+  uint64_t m_size;
+  size_t m_recordCount;
+  bool m_uncommitted;
+};
+
+}
@@ -18,6 +18,7 @@
 #include "WalletSerializationV2.h"
 
 #include "CryptoNoteCore/CryptoNoteSerialization.h"
+#include "Wallet/WalletUtils.h"
 #include "Serialization/BinaryInputStreamSerializer.h"
 #include "Serialization/BinaryOutputStreamSerializer.h"
 
@@ -165,7 +166,7 @@ void WalletSerializerV2::load(Common::IInputStream& source, uint8_t version) {
   s(m_extra, "extra");
 }
 
-void WalletSerializerV2::save(Common::IOutputStream& destination, WalletSaveLevel saveLevel) {
+void WalletSerializerV2::save(Common::IOutputStream& destination, WalletSaveLevel saveLevel, const std::string& transfersSynchronizerState) {
   CryptoNote::BinaryOutputStreamSerializer s(destination);
 
   uint8_t saveLevelValue = static_cast<uint8_t>(saveLevel);
@@ -179,7 +180,7 @@ void WalletSerializerV2::save(Common::IOutputStream& destination, WalletSaveLeve
   }
 
   if (saveLevel == WalletSaveLevel::SAVE_ALL) {
-    saveTransfersSynchronizer(s);
+    saveTransfersSynchronizer(s, transfersSynchronizerState);
     saveUnlockTransactionsJobs(s);
     s(m_uncommitedTransactions, "uncommitedTransactions");
   }
@@ -187,6 +188,36 @@ void WalletSerializerV2::save(Common::IOutputStream& destination, WalletSaveLeve
   s(m_extra, "extra");
 }
 
+void WalletSerializerV2::serializeTransaction(CryptoNote::ISerializer& serializer, WalletTransaction& transaction) {
+  WalletTransactionDtoV2 dto(transaction);
+  serializer(dto, "transaction");
+
+  if (serializer.type() == CryptoNote::ISerializer::INPUT) {
+    transaction.state = dto.state;
+    transaction.timestamp = dto.timestamp;
+    transaction.blockHeight = dto.blockHeight;
+    transaction.hash = dto.hash;
+    transaction.totalAmount = dto.totalAmount;
+    transaction.fee = dto.fee;
+    transaction.creationTime = dto.creationTime;
+    transaction.unlockTime = dto.unlockTime;
+    transaction.extra = dto.extra;
+    transaction.isBase = dto.isBase;
+    transaction.paymentId = getPaymentIdFromExtra(transaction.extra);
+  }
+}
+
+void WalletSerializerV2::serializeTransfer(CryptoNote::ISerializer& serializer, WalletTransfer& transfer) {
+  WalletTransferDtoV2 dto(transfer);
+  serializer(dto, "transfer");
+
+  if (serializer.type() == CryptoNote::ISerializer::INPUT) {
+    transfer.address = dto.address;
+    transfer.amount = dto.amount;
+    transfer.type = static_cast<WalletTransferType>(dto.type);
+  }
+}
+
 std::unordered_set<Crypto::PublicKey>& WalletSerializerV2::addedKeys() {
   return m_addedKeys;
 }
@@ -273,6 +304,8 @@ void WalletSerializerV2::loadTransactions(CryptoNote::ISerializer& serializer) {
     tx.unlockTime = dto.unlockTime;
     tx.extra = dto.extra;
     tx.isBase = dto.isBase;
+    // not stored, the payment ID index is rebuilt from extra
+    tx.paymentId = getPaymentIdFromExtra(tx.extra);
 
     m_transactions.get<RandomAccessIndex>().emplace_back(std::move(tx));
   }
@@ -332,13 +365,8 @@ void WalletSerializerV2::loadTransfersSynchronizer(CryptoNote::ISerializer& seri
   m_synchronizer.load(stream);
 }
 
-void WalletSerializerV2::saveTransfersSynchronizer(CryptoNote::ISerializer& serializer) {
-  std::stringstream stream;
-  m_synchronizer.save(stream);
-  stream.flush();
-
-  std::string transfersSynchronizerData = stream.str();
-  serializer(transfersSynchronizerData, "transfersSynchronizer");
+void WalletSerializerV2::saveTransfersSynchronizer(CryptoNote::ISerializer& serializer, const std::string& transfersSynchronizerState) {
+  serializer(const_cast<std::string&>(transfersSynchronizerState), "transfersSynchronizer");
 }
 
 void WalletSerializerV2::loadUnlockTransactionsJobs(CryptoNote::ISerializer& serializer) {
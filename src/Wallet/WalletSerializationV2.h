@@ -44,7 +44,12 @@ public:
   );
 
   void load(Common::IInputStream& source, uint8_t version);
-  void save(Common::IOutputStream& destination, WalletSaveLevel saveLevel);
+  // transfersSynchronizerState is the saved TransfersSyncronizer, taken while its consumers were locked
+  void save(Common::IOutputStream& destination, WalletSaveLevel saveLevel, const std::string& transfersSynchronizerState);
+
+  // Wallet journal records store transactions and transfers in the same layout as the container
+  static void serializeTransaction(CryptoNote::ISerializer& serializer, WalletTransaction& transaction);
+  static void serializeTransfer(CryptoNote::ISerializer& serializer, WalletTransfer& transfer);
 
   std::unordered_set<Crypto::PublicKey>& addedKeys();
   std::unordered_set<Crypto::PublicKey>& deletedKeys();
@@ -63,7 +68,7 @@ private:
   void saveTransfers(CryptoNote::ISerializer& serializer);
 
   void loadTransfersSynchronizer(CryptoNote::ISerializer& serializer);
-  void saveTransfersSynchronizer(CryptoNote::ISerializer& serializer);
+  void saveTransfersSynchronizer(CryptoNote::ISerializer& serializer, const std::string& transfersSynchronizerState);
 
   void loadUnlockTransactionsJobs(CryptoNote::ISerializer& serializer);
   void saveUnlockTransactionsJobs(CryptoNote::ISerializer& serializer);
@@ -19,6 +19,9 @@
 
 #include "CryptoNote.h"
 #include "crypto/crypto.h"
+#include "Common/StringTools.h"
+#include "CryptoNoteCore/CryptoNoteBasic.h"
+#include "CryptoNoteCore/TransactionExtra.h"
 #include "Wallet/WalletErrors.h"
 
 namespace CryptoNote {
@@ -56,6 +59,15 @@ bool validateAddress(const std::string& address, const CryptoNote::Currency& cur
   return currency.parseAccountAddressString(address, ignore);
 }
 
+Crypto::Hash getPaymentIdFromExtra(const std::string& extra) {
+  Crypto::Hash paymentId;
+  if (!getPaymentIdFromTxExtra(Common::asBinaryArray(extra), paymentId)) {
+    paymentId = NULL_HASH;
+  }
+
+  return paymentId;
+}
+
 std::ostream& operator<<(std::ostream& os, CryptoNote::WalletTransactionState state) {
   switch (state) {
   case CryptoNote::WalletTransactionState::SUCCEEDED:
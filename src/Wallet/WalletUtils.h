@@ -28,6 +28,8 @@ namespace CryptoNote {
 uint64_t getDefaultMixinByHeight(const uint64_t height);
 void throwIfKeysMismatch(const Crypto::SecretKey& secretKey, const Crypto::PublicKey& expectedPublicKey, const std::string& message = "");
 bool validateAddress(const std::string& address, const CryptoNote::Currency& currency);
+// NULL_HASH if extra has no payment ID
+Crypto::Hash getPaymentIdFromExtra(const std::string& extra);
 
 std::ostream& operator<<(std::ostream& os, CryptoNote::WalletTransactionState state);
 std::ostream& operator<<(std::ostream& os, CryptoNote::WalletTransferType type);
@@ -81,24 +81,6 @@ Crypto::Hash parsePaymentId(const std::string& paymentIdStr) {
   return paymentId;
 }
 
-bool getPaymentIdFromExtra(const std::string& binaryString, Crypto::Hash& paymentId) {
-  return CryptoNote::getPaymentIdFromTxExtra(Common::asBinaryArray(binaryString), paymentId);
-}
-
-std::string getPaymentIdStringFromExtra(const std::string& binaryString) {
-  Crypto::Hash paymentId;
-
-  try {
-    if (!getPaymentIdFromExtra(binaryString, paymentId)) {
-      return std::string();
-    }
-  } catch (std::exception&) {
-    return std::string();
-  }
-
-  return Common::podToHex(paymentId);
-}
-
 }
 
 struct TransactionsInBlockInfoFilter {
@@ -114,15 +96,8 @@ struct TransactionsInBlockInfoFilter {
   }
 
   bool checkTransaction(const CryptoNote::WalletTransactionWithTransfers& transaction) const {
-    if (havePaymentId) {
-      Crypto::Hash transactionPaymentId;
-      if (!getPaymentIdFromExtra(transaction.transaction.extra, transactionPaymentId)) {
-        return false;
-      }
-
-      if (paymentId != transactionPaymentId) {
-        return false;
-      }
+    if (havePaymentId && paymentId != transaction.transaction.paymentId) {
+      return false;
     }
 
     if (addresses.empty()) {
@@ -214,7 +189,7 @@ PaymentService::TransactionRpcInfo convertTransactionWithTransfersToTransactionR
   transactionInfo.amount = transactionWithTransfers.transaction.totalAmount;
   transactionInfo.fee = transactionWithTransfers.transaction.fee;
   transactionInfo.extra = Common::toHex(transactionWithTransfers.transaction.extra.data(), transactionWithTransfers.transaction.extra.size());
-  transactionInfo.paymentId = getPaymentIdStringFromExtra(transactionWithTransfers.transaction.extra);
+  transactionInfo.paymentId = transactionWithTransfers.transaction.paymentId == CryptoNote::NULL_HASH ? std::string() : Common::podToHex(transactionWithTransfers.transaction.paymentId);
 
   for (const CryptoNote::WalletTransfer& transfer: transactionWithTransfers.transfers) {
     PaymentService::TransferRpcInfo rpcTransfer;
@@ -1395,7 +1370,17 @@ void WalletService::reset(const uint64_t scanHeight) {
   wallet.reset(scanHeight);
 }
 
-std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(const Crypto::Hash& blockHash, size_t blockCount) const {
+std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
+  if (filter.havePaymentId) {
+    // looked up in the wallet payment ID index instead of walking every block in the range
+    std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactionsByPaymentId(filter.paymentId, blockHash, blockCount);
+    if (result.empty() && wallet.getTransactions(blockHash, 1).empty()) {
+      throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
+    }
+
+    return result;
+  }
+
   std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(blockHash, blockCount);
   if (result.empty()) {
     throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
@@ -1404,7 +1389,16 @@ std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(
   return result;
 }
 
-std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(uint32_t firstBlockIndex, size_t blockCount) const {
+std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
+  if (filter.havePaymentId) {
+    std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactionsByPaymentId(filter.paymentId, firstBlockIndex, blockCount);
+    if (result.empty() && firstBlockIndex >= wallet.getBlockCount()) {
+      throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
+    }
+
+    return result;
+  }
+
   std::vector<CryptoNote::TransactionsInBlockInfo> result = wallet.getTransactions(firstBlockIndex, blockCount);
   if (result.empty()) {
     throw std::system_error(make_error_code(CryptoNote::error::WalletServiceErrorCode::OBJECT_NOT_FOUND));
@@ -1414,25 +1408,25 @@ std::vector<CryptoNote::TransactionsInBlockInfo> WalletService::getTransactions(
 }
 
 std::vector<TransactionHashesInBlockRpcInfo> WalletService::getRpcTransactionHashes(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount);
+  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount, filter);
   std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
   return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(filteredTransactions);
 }
 
 std::vector<TransactionHashesInBlockRpcInfo> WalletService::getRpcTransactionHashes(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount);
+  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount, filter);
   std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
   return convertTransactionsInBlockInfoToTransactionHashesInBlockRpcInfo(filteredTransactions);
 }
 
 std::vector<TransactionsInBlockRpcInfo> WalletService::getRpcTransactions(const Crypto::Hash& blockHash, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount);
+  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(blockHash, blockCount, filter);
   std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
   return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(filteredTransactions);
 }
 
 std::vector<TransactionsInBlockRpcInfo> WalletService::getRpcTransactions(uint32_t firstBlockIndex, size_t blockCount, const TransactionsInBlockInfoFilter& filter) const {
-  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount);
+  std::vector<CryptoNote::TransactionsInBlockInfo> allTransactions = getTransactions(firstBlockIndex, blockCount, filter);
   std::vector<CryptoNote::TransactionsInBlockInfo> filteredTransactions = filterTransactions(allTransactions, filter);
   return convertTransactionsInBlockInfoToTransactionsInBlockRpcInfo(filteredTransactions);
 }
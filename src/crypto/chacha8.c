@@ -37,131 +37,232 @@ Public domain.
 
 static const char sigma[] = "expand 32-byte k";
 
-void chacha8(const void* data, size_t length, const uint8_t* key, const uint8_t* iv, char* cipher) {
+/* number of blocks chacha8_blocks_vector generates at once */
+#define CHACHA8_LANES 8
+
+typedef void (*chacha8_blocks_fn)(const uint32_t input[16], uint8_t* keystream);
+
+static void chacha8_counter_add(uint32_t input[16], uint64_t blocks) {
+  uint64_t counter = (((uint64_t)input[13] << 32) | input[12]) + blocks;
+  input[12] = U32V(counter);
+  input[13] = U32V(counter >> 32);
+  /* stopping at 2^70 bytes per iv is user's responsibility */
+}
+
+/* keystream = the block at input's counter, which is then advanced by one */
+static void chacha8_block(uint32_t input[16], uint8_t* keystream) {
   uint32_t x0, x1, x2, x3, x4, x5, x6, x7, x8, x9, x10, x11, x12, x13, x14, x15;
-  uint32_t j0, j1, j2, j3, j4, j5, j6, j7, j8, j9, j10, j11, j12, j13, j14, j15;
-  char* ctarget = 0;
-  char tmp[64];
   int i;
 
-  if (!length) return;
-
-  j0  = U8TO32_LITTLE(sigma + 0);
-  j1  = U8TO32_LITTLE(sigma + 4);
-  j2  = U8TO32_LITTLE(sigma + 8);
-  j3  = U8TO32_LITTLE(sigma + 12);
-  j4  = U8TO32_LITTLE(key + 0);
-  j5  = U8TO32_LITTLE(key + 4);
-  j6  = U8TO32_LITTLE(key + 8);
-  j7  = U8TO32_LITTLE(key + 12);
-  j8  = U8TO32_LITTLE(key + 16);
-  j9  = U8TO32_LITTLE(key + 20);
-  j10 = U8TO32_LITTLE(key + 24);
-  j11 = U8TO32_LITTLE(key + 28);
-  j12 = 0;
-  j13 = 0;
-  j14 = U8TO32_LITTLE(iv + 0);
-  j15 = U8TO32_LITTLE(iv + 4);
-
-  for (;;) {
-    if (length < 64) {
-      memcpy(tmp, data, length);
-      data = tmp;
-      ctarget = cipher;
-      cipher = tmp;
-    }
-    x0  = j0;
-    x1  = j1;
-    x2  = j2;
-    x3  = j3;
-    x4  = j4;
-    x5  = j5;
-    x6  = j6;
-    x7  = j7;
-    x8  = j8;
-    x9  = j9;
-    x10 = j10;
-    x11 = j11;
-    x12 = j12;
-    x13 = j13;
-    x14 = j14;
-    x15 = j15;
-    for (i = 8;i > 0;i -= 2) {
-      QUARTERROUND( x0, x4, x8,x12)
-      QUARTERROUND( x1, x5, x9,x13)
-      QUARTERROUND( x2, x6,x10,x14)
-      QUARTERROUND( x3, x7,x11,x15)
-      QUARTERROUND( x0, x5,x10,x15)
-      QUARTERROUND( x1, x6,x11,x12)
-      QUARTERROUND( x2, x7, x8,x13)
-      QUARTERROUND( x3, x4, x9,x14)
-    }
-    x0  = PLUS( x0, j0);
-    x1  = PLUS( x1, j1);
-    x2  = PLUS( x2, j2);
-    x3  = PLUS( x3, j3);
-    x4  = PLUS( x4, j4);
-    x5  = PLUS( x5, j5);
-    x6  = PLUS( x6, j6);
-    x7  = PLUS( x7, j7);
-    x8  = PLUS( x8, j8);
-    x9  = PLUS( x9, j9);
-    x10 = PLUS(x10,j10);
-    x11 = PLUS(x11,j11);
-    x12 = PLUS(x12,j12);
-    x13 = PLUS(x13,j13);
-    x14 = PLUS(x14,j14);
-    x15 = PLUS(x15,j15);
-
-    x0  = XOR( x0,U8TO32_LITTLE((uint8_t*)data +  0));
-    x1  = XOR( x1,U8TO32_LITTLE((uint8_t*)data +  4));
-    x2  = XOR( x2,U8TO32_LITTLE((uint8_t*)data +  8));
-    x3  = XOR( x3,U8TO32_LITTLE((uint8_t*)data + 12));
-    x4  = XOR( x4,U8TO32_LITTLE((uint8_t*)data + 16));
-    x5  = XOR( x5,U8TO32_LITTLE((uint8_t*)data + 20));
-    x6  = XOR( x6,U8TO32_LITTLE((uint8_t*)data + 24));
-    x7  = XOR( x7,U8TO32_LITTLE((uint8_t*)data + 28));
-    x8  = XOR( x8,U8TO32_LITTLE((uint8_t*)data + 32));
-    x9  = XOR( x9,U8TO32_LITTLE((uint8_t*)data + 36));
-    x10 = XOR(x10,U8TO32_LITTLE((uint8_t*)data + 40));
-    x11 = XOR(x11,U8TO32_LITTLE((uint8_t*)data + 44));
-    x12 = XOR(x12,U8TO32_LITTLE((uint8_t*)data + 48));
-    x13 = XOR(x13,U8TO32_LITTLE((uint8_t*)data + 52));
-    x14 = XOR(x14,U8TO32_LITTLE((uint8_t*)data + 56));
-    x15 = XOR(x15,U8TO32_LITTLE((uint8_t*)data + 60));
-
-    j12 = PLUSONE(j12);
-    if (!j12)
-    {
-      j13 = PLUSONE(j13);
-      /* stopping at 2^70 bytes per iv is user's responsibility */
-    }
+  x0  = input[0];
+  x1  = input[1];
+  x2  = input[2];
+  x3  = input[3];
+  x4  = input[4];
+  x5  = input[5];
+  x6  = input[6];
+  x7  = input[7];
+  x8  = input[8];
+  x9  = input[9];
+  x10 = input[10];
+  x11 = input[11];
+  x12 = input[12];
+  x13 = input[13];
+  x14 = input[14];
+  x15 = input[15];
+  for (i = 8;i > 0;i -= 2) {
+    QUARTERROUND( x0, x4, x8,x12)
+    QUARTERROUND( x1, x5, x9,x13)
+    QUARTERROUND( x2, x6,x10,x14)
+    QUARTERROUND( x3, x7,x11,x15)
+    QUARTERROUND( x0, x5,x10,x15)
+    QUARTERROUND( x1, x6,x11,x12)
+    QUARTERROUND( x2, x7, x8,x13)
+    QUARTERROUND( x3, x4, x9,x14)
+  }
+  U32TO8_LITTLE(keystream +  0,PLUS( x0,input[0]));
+  U32TO8_LITTLE(keystream +  4,PLUS( x1,input[1]));
+  U32TO8_LITTLE(keystream +  8,PLUS( x2,input[2]));
+  U32TO8_LITTLE(keystream + 12,PLUS( x3,input[3]));
+  U32TO8_LITTLE(keystream + 16,PLUS( x4,input[4]));
+  U32TO8_LITTLE(keystream + 20,PLUS( x5,input[5]));
+  U32TO8_LITTLE(keystream + 24,PLUS( x6,input[6]));
+  U32TO8_LITTLE(keystream + 28,PLUS( x7,input[7]));
+  U32TO8_LITTLE(keystream + 32,PLUS( x8,input[8]));
+  U32TO8_LITTLE(keystream + 36,PLUS( x9,input[9]));
+  U32TO8_LITTLE(keystream + 40,PLUS(x10,input[10]));
+  U32TO8_LITTLE(keystream + 44,PLUS(x11,input[11]));
+  U32TO8_LITTLE(keystream + 48,PLUS(x12,input[12]));
+  U32TO8_LITTLE(keystream + 52,PLUS(x13,input[13]));
+  U32TO8_LITTLE(keystream + 56,PLUS(x14,input[14]));
+  U32TO8_LITTLE(keystream + 60,PLUS(x15,input[15]));
+
+  chacha8_counter_add(input, 1);
+}
+
+/*
+ * CHACHA8_LANES consecutive blocks computed together: word i of every block
+ * lives in x[i], one block per vector lane.
+ */
+#if defined(__GNUC__)
+#define CHACHA8_VECTORS 1
+typedef uint32_t chacha8_vector __attribute__((vector_size(4 * CHACHA8_LANES)));
 
-    U32TO8_LITTLE(cipher +  0,x0);
-    U32TO8_LITTLE(cipher +  4,x1);
-    U32TO8_LITTLE(cipher +  8,x2);
-    U32TO8_LITTLE(cipher + 12,x3);
-    U32TO8_LITTLE(cipher + 16,x4);
-    U32TO8_LITTLE(cipher + 20,x5);
-    U32TO8_LITTLE(cipher + 24,x6);
-    U32TO8_LITTLE(cipher + 28,x7);
-    U32TO8_LITTLE(cipher + 32,x8);
-    U32TO8_LITTLE(cipher + 36,x9);
-    U32TO8_LITTLE(cipher + 40,x10);
-    U32TO8_LITTLE(cipher + 44,x11);
-    U32TO8_LITTLE(cipher + 48,x12);
-    U32TO8_LITTLE(cipher + 52,x13);
-    U32TO8_LITTLE(cipher + 56,x14);
-    U32TO8_LITTLE(cipher + 60,x15);
-
-    if (length <= 64) {
-      if (length < 64) {
-        memcpy(ctarget, cipher, length);
-      }
-      return;
+#define VROTATE(v,c) (((v) << (c)) | ((v) >> (32 - (c))))
+
+#define VQUARTERROUND(a,b,c,d) \
+  a += b; d = VROTATE(d ^ a,16); \
+  c += d; b = VROTATE(b ^ c,12); \
+  a += b; d = VROTATE(d ^ a, 8); \
+  c += d; b = VROTATE(b ^ c, 7);
+
+/* always inlined, so that every caller below is compiled for its own instruction set */
+static inline __attribute__((always_inline)) void chacha8_blocks_vector(const uint32_t input[16], uint8_t* keystream) {
+  chacha8_vector j[16], x[16];
+  uint64_t counter = ((uint64_t)input[13] << 32) | input[12];
+  int i, l;
+
+  for (i = 0; i < 16; i++) {
+    j[i] = (chacha8_vector){ 0 } + input[i];
+  }
+  for (l = 0; l < CHACHA8_LANES; l++) {
+    j[12][l] = U32V(counter + l);
+    j[13][l] = U32V((counter + l) >> 32);
+  }
+  for (i = 0; i < 16; i++) {
+    x[i] = j[i];
+  }
+
+  for (i = 8;i > 0;i -= 2) {
+    VQUARTERROUND(x[0], x[4], x[8],x[12])
+    VQUARTERROUND(x[1], x[5], x[9],x[13])
+    VQUARTERROUND(x[2], x[6],x[10],x[14])
+    VQUARTERROUND(x[3], x[7],x[11],x[15])
+    VQUARTERROUND(x[0], x[5],x[10],x[15])
+    VQUARTERROUND(x[1], x[6],x[11],x[12])
+    VQUARTERROUND(x[2], x[7], x[8],x[13])
+    VQUARTERROUND(x[3], x[4], x[9],x[14])
+  }
+
+  for (i = 0; i < 16; i++) {
+    x[i] += j[i];
+  }
+  for (l = 0; l < CHACHA8_LANES; l++) {
+    for (i = 0; i < 16; i++) {
+      U32TO8_LITTLE(keystream + 64 * l + 4 * i, x[i][l]);
     }
-    length -= 64;
-    cipher += 64;
-    data = (uint8_t*)data + 64;
   }
 }
+
+static void chacha8_blocks_default(const uint32_t input[16], uint8_t* keystream) {
+  chacha8_blocks_vector(input, keystream);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void chacha8_blocks_avx2(const uint32_t input[16], uint8_t* keystream) {
+  chacha8_blocks_vector(input, keystream);
+}
+#endif
+
+#else
+
+static void chacha8_blocks_default(const uint32_t input[16], uint8_t* keystream) {
+  uint32_t j[16];
+  int l;
+
+  memcpy(j, input, sizeof(j));
+  for (l = 0; l < CHACHA8_LANES; l++) {
+    chacha8_block(j, keystream + 64 * l);
+  }
+}
+
+#endif
+
+static chacha8_blocks_fn chacha8_blocks_select(void) {
+#if defined(CHACHA8_VECTORS) && (defined(__x86_64__) || defined(__i386__))
+  if (__builtin_cpu_supports("avx2"))
+    return chacha8_blocks_avx2;
+#endif
+  return chacha8_blocks_default;
+}
+
+static void chacha8_xor(const uint8_t* data, const uint8_t* keystream, size_t length, uint8_t* cipher) {
+  uint64_t d, k;
+  size_t i;
+
+  for (i = 0; i + 8 <= length; i += 8) {
+    memcpy(&d, data + i, 8);
+    memcpy(&k, keystream + i, 8);
+    d ^= k;
+    memcpy(cipher + i, &d, 8);
+  }
+  for (; i < length; i++) {
+    cipher[i] = data[i] ^ keystream[i];
+  }
+}
+
+void chacha8_init(chacha8_state* state, const uint8_t* key, const uint8_t* iv) {
+  state->input[0]  = U8TO32_LITTLE(sigma + 0);
+  state->input[1]  = U8TO32_LITTLE(sigma + 4);
+  state->input[2]  = U8TO32_LITTLE(sigma + 8);
+  state->input[3]  = U8TO32_LITTLE(sigma + 12);
+  state->input[4]  = U8TO32_LITTLE(key + 0);
+  state->input[5]  = U8TO32_LITTLE(key + 4);
+  state->input[6]  = U8TO32_LITTLE(key + 8);
+  state->input[7]  = U8TO32_LITTLE(key + 12);
+  state->input[8]  = U8TO32_LITTLE(key + 16);
+  state->input[9]  = U8TO32_LITTLE(key + 20);
+  state->input[10] = U8TO32_LITTLE(key + 24);
+  state->input[11] = U8TO32_LITTLE(key + 28);
+  state->input[12] = 0;
+  state->input[13] = 0;
+  state->input[14] = U8TO32_LITTLE(iv + 0);
+  state->input[15] = U8TO32_LITTLE(iv + 4);
+  state->keystream_used = sizeof(state->keystream);
+}
+
+void chacha8_update(chacha8_state* state, const void* data, size_t length, char* cipher) {
+  const uint8_t* in = (const uint8_t*)data;
+  uint8_t* out = (uint8_t*)cipher;
+  uint8_t blocks[64 * CHACHA8_LANES];
+  chacha8_blocks_fn generate;
+  size_t n;
+
+  /* the rest of the block left over by the previous call */
+  n = sizeof(state->keystream) - state->keystream_used;
+  n = n < length ? n : length;
+  chacha8_xor(in, state->keystream + state->keystream_used, n, out);
+  state->keystream_used += n;
+  in += n;
+  out += n;
+  length -= n;
+
+  if (length >= sizeof(blocks)) {
+    generate = chacha8_blocks_select();
+    do {
+      generate(state->input, blocks);
+      chacha8_counter_add(state->input, CHACHA8_LANES);
+      chacha8_xor(in, blocks, sizeof(blocks), out);
+      in += sizeof(blocks);
+      out += sizeof(blocks);
+      length -= sizeof(blocks);
+    } while (length >= sizeof(blocks));
+  }
+
+  while (length > 0) {
+    chacha8_block(state->input, state->keystream);
+    n = length < sizeof(state->keystream) ? length : sizeof(state->keystream);
+    chacha8_xor(in, state->keystream, n, out);
+    state->keystream_used = n;
+    in += n;
+    out += n;
+    length -= n;
+  }
+}
+
+void chacha8(const void* data, size_t length, const uint8_t* key, const uint8_t* iv, char* cipher) {
+  chacha8_state state;
+  chacha8_init(&state, key, iv);
+  chacha8_update(&state, data, length, cipher);
+}
@@ -21,6 +21,17 @@ namespace Crypto {
   extern "C" {
 #endif
     void chacha8(const void* data, size_t length, const uint8_t* key, const uint8_t* iv, char* cipher);
+
+    /* Streaming form of chacha8: encrypting in several chacha8_update calls
+       gives the same cipher as one chacha8 call over the concatenated data */
+    typedef struct {
+      uint32_t input[16];
+      uint8_t keystream[64];
+      size_t keystream_used;
+    } chacha8_state;
+
+    void chacha8_init(chacha8_state* state, const uint8_t* key, const uint8_t* iv);
+    void chacha8_update(chacha8_state* state, const void* data, size_t length, char* cipher);
 #if defined(__cplusplus)
   }
 
@@ -41,6 +52,14 @@ namespace Crypto {
     chacha8(data, length, reinterpret_cast<const uint8_t*>(&key), reinterpret_cast<const uint8_t*>(&iv), cipher);
   }
 
+  inline void chacha8_init(chacha8_state& state, const chacha8_key& key, const chacha8_iv& iv) {
+    chacha8_init(&state, reinterpret_cast<const uint8_t*>(&key), reinterpret_cast<const uint8_t*>(&iv));
+  }
+
+  inline void chacha8_update(chacha8_state& state, const void* data, size_t length, char* cipher) {
+    chacha8_update(&state, data, length, cipher);
+  }
+
   inline void generate_chacha8_key(const std::string& password, chacha8_key& key) {
     static_assert(sizeof(chacha8_key) <= sizeof(Hash), "Size of hash must be at least that of chacha8_key");
     Hash pwd_hash;
@@ -51,6 +51,316 @@ static uint64_t load_4(const unsigned char *in)
   return result;
 }
 
+#if defined(CRYPTO_OPS_FE51)
+
+/*
+Radix 2^51 field arithmetic for 64-bit targets.
+
+An element is h[0]+2^51*h[1]+2^102*h[2]+2^153*h[3]+2^204*h[4] with unsigned
+limbs. Every function below leaves its output carried, i.e. h[1]..h[4] are
+below 2^51 and h[0] is below 2^51 plus a small multiple of 19, so the
+multiplication inputs always stay far enough from 2^64 for the 128-bit
+accumulators and the final carry by 19.
+*/
+
+typedef unsigned __int128 uint128_t;
+
+#define FE51_MASK ((((uint64_t) 1) << 51) - 1)
+
+/* 4 * p, limb by limb, so that subtraction never underflows */
+#define FE51_FOUR_P0 (((uint64_t) 0x7ffffffffffed) << 2)
+#define FE51_FOUR_P1 (((uint64_t) 0x7ffffffffffff) << 2)
+
+static uint64_t load_8(const unsigned char *in) {
+  uint64_t result;
+  result = (uint64_t) in[0];
+  result |= ((uint64_t) in[1]) << 8;
+  result |= ((uint64_t) in[2]) << 16;
+  result |= ((uint64_t) in[3]) << 24;
+  result |= ((uint64_t) in[4]) << 32;
+  result |= ((uint64_t) in[5]) << 40;
+  result |= ((uint64_t) in[6]) << 48;
+  result |= ((uint64_t) in[7]) << 56;
+  return result;
+}
+
+static void store_8(unsigned char *out, uint64_t in) {
+  out[0] = (unsigned char) in;
+  out[1] = (unsigned char) (in >> 8);
+  out[2] = (unsigned char) (in >> 16);
+  out[3] = (unsigned char) (in >> 24);
+  out[4] = (unsigned char) (in >> 32);
+  out[5] = (unsigned char) (in >> 40);
+  out[6] = (unsigned char) (in >> 48);
+  out[7] = (unsigned char) (in >> 56);
+}
+
+static void fe_carry(fe h) {
+  uint64_t c;
+  c = h[0] >> 51; h[0] &= FE51_MASK; h[1] += c;
+  c = h[1] >> 51; h[1] &= FE51_MASK; h[2] += c;
+  c = h[2] >> 51; h[2] &= FE51_MASK; h[3] += c;
+  c = h[3] >> 51; h[3] &= FE51_MASK; h[4] += c;
+  c = h[4] >> 51; h[4] &= FE51_MASK; h[0] += c * 19;
+}
+
+/*
+h = 0
+*/
+
+static void fe_0(fe h) {
+  h[0] = 0;
+  h[1] = 0;
+  h[2] = 0;
+  h[3] = 0;
+  h[4] = 0;
+}
+
+/*
+h = 1
+*/
+
+static void fe_1(fe h) {
+  h[0] = 1;
+  h[1] = 0;
+  h[2] = 0;
+  h[3] = 0;
+  h[4] = 0;
+}
+
+/*
+h = f + g
+Can overlap h with f or g.
+*/
+
+static void fe_add(fe h, const fe f, const fe g) {
+  h[0] = f[0] + g[0];
+  h[1] = f[1] + g[1];
+  h[2] = f[2] + g[2];
+  h[3] = f[3] + g[3];
+  h[4] = f[4] + g[4];
+  fe_carry(h);
+}
+
+/*
+Replace (f,g) with (g,g) if b == 1;
+replace (f,g) with (f,g) if b == 0.
+
+Preconditions: b in {0,1}.
+*/
+
+static void fe_cmov(fe f, const fe g, unsigned int b) {
+  uint64_t mask = (uint64_t) 0 - (uint64_t) b;
+  f[0] ^= (f[0] ^ g[0]) & mask;
+  f[1] ^= (f[1] ^ g[1]) & mask;
+  f[2] ^= (f[2] ^ g[2]) & mask;
+  f[3] ^= (f[3] ^ g[3]) & mask;
+  f[4] ^= (f[4] ^ g[4]) & mask;
+}
+
+/*
+h = f
+*/
+
+static void fe_copy(fe h, const fe f) {
+  h[0] = f[0];
+  h[1] = f[1];
+  h[2] = f[2];
+  h[3] = f[3];
+  h[4] = f[4];
+}
+
+/*
+h = f * g
+Can overlap h with f or g.
+
+Schoolbook multiplication, with the limbs that wrap past 2^255 folded back
+in with a factor of 19 before accumulating.
+*/
+
+static void fe_mul(fe h, const fe f, const fe g) {
+  uint64_t f0 = f[0];
+  uint64_t f1 = f[1];
+  uint64_t f2 = f[2];
+  uint64_t f3 = f[3];
+  uint64_t f4 = f[4];
+  uint64_t g0 = g[0];
+  uint64_t g1 = g[1];
+  uint64_t g2 = g[2];
+  uint64_t g3 = g[3];
+  uint64_t g4 = g[4];
+  uint64_t g1_19 = 19 * g1;
+  uint64_t g2_19 = 19 * g2;
+  uint64_t g3_19 = 19 * g3;
+  uint64_t g4_19 = 19 * g4;
+  uint128_t t0;
+  uint128_t t1;
+  uint128_t t2;
+  uint128_t t3;
+  uint128_t t4;
+  uint64_t c;
+
+  t0 = (uint128_t) f0 * g0 + (uint128_t) f1 * g4_19 + (uint128_t) f2 * g3_19 + (uint128_t) f3 * g2_19 + (uint128_t) f4 * g1_19;
+  t1 = (uint128_t) f0 * g1 + (uint128_t) f1 * g0 + (uint128_t) f2 * g4_19 + (uint128_t) f3 * g3_19 + (uint128_t) f4 * g2_19;
+  t2 = (uint128_t) f0 * g2 + (uint128_t) f1 * g1 + (uint128_t) f2 * g0 + (uint128_t) f3 * g4_19 + (uint128_t) f4 * g3_19;
+  t3 = (uint128_t) f0 * g3 + (uint128_t) f1 * g2 + (uint128_t) f2 * g1 + (uint128_t) f3 * g0 + (uint128_t) f4 * g4_19;
+  t4 = (uint128_t) f0 * g4 + (uint128_t) f1 * g3 + (uint128_t) f2 * g2 + (uint128_t) f3 * g1 + (uint128_t) f4 * g0;
+
+  h[0] = (uint64_t) t0 & FE51_MASK; c = (uint64_t) (t0 >> 51);
+  t1 += c; h[1] = (uint64_t) t1 & FE51_MASK; c = (uint64_t) (t1 >> 51);
+  t2 += c; h[2] = (uint64_t) t2 & FE51_MASK; c = (uint64_t) (t2 >> 51);
+  t3 += c; h[3] = (uint64_t) t3 & FE51_MASK; c = (uint64_t) (t3 >> 51);
+  t4 += c; h[4] = (uint64_t) t4 & FE51_MASK; c = (uint64_t) (t4 >> 51);
+  h[0] += c * 19; c = h[0] >> 51; h[0] &= FE51_MASK;
+  h[1] += c;
+}
+
+/*
+h = -f
+*/
+
+static void fe_neg(fe h, const fe f) {
+  h[0] = FE51_FOUR_P0 - f[0];
+  h[1] = FE51_FOUR_P1 - f[1];
+  h[2] = FE51_FOUR_P1 - f[2];
+  h[3] = FE51_FOUR_P1 - f[3];
+  h[4] = FE51_FOUR_P1 - f[4];
+  fe_carry(h);
+}
+
+/*
+h = f * f
+Can overlap h with f.
+*/
+
+static void fe_sq(fe h, const fe f) {
+  uint64_t f0 = f[0];
+  uint64_t f1 = f[1];
+  uint64_t f2 = f[2];
+  uint64_t f3 = f[3];
+  uint64_t f4 = f[4];
+  uint64_t f0_2 = 2 * f0;
+  uint64_t f1_2 = 2 * f1;
+  uint64_t f1_38 = 38 * f1;
+  uint64_t f2_38 = 38 * f2;
+  uint64_t f3_38 = 38 * f3;
+  uint64_t f3_19 = 19 * f3;
+  uint64_t f4_19 = 19 * f4;
+  uint128_t t0;
+  uint128_t t1;
+  uint128_t t2;
+  uint128_t t3;
+  uint128_t t4;
+  uint64_t c;
+
+  t0 = (uint128_t) f0 * f0 + (uint128_t) f1_38 * f4 + (uint128_t) f2_38 * f3;
+  t1 = (uint128_t) f0_2 * f1 + (uint128_t) f2_38 * f4 + (uint128_t) f3_19 * f3;
+  t2 = (uint128_t) f0_2 * f2 + (uint128_t) f1 * f1 + (uint128_t) f3_38 * f4;
+  t3 = (uint128_t) f0_2 * f3 + (uint128_t) f1_2 * f2 + (uint128_t) f4_19 * f4;
+  t4 = (uint128_t) f0_2 * f4 + (uint128_t) f1_2 * f3 + (uint128_t) f2 * f2;
+
+  h[0] = (uint64_t) t0 & FE51_MASK; c = (uint64_t) (t0 >> 51);
+  t1 += c; h[1] = (uint64_t) t1 & FE51_MASK; c = (uint64_t) (t1 >> 51);
+  t2 += c; h[2] = (uint64_t) t2 & FE51_MASK; c = (uint64_t) (t2 >> 51);
+  t3 += c; h[3] = (uint64_t) t3 & FE51_MASK; c = (uint64_t) (t3 >> 51);
+  t4 += c; h[4] = (uint64_t) t4 & FE51_MASK; c = (uint64_t) (t4 >> 51);
+  h[0] += c * 19; c = h[0] >> 51; h[0] &= FE51_MASK;
+  h[1] += c;
+}
+
+/*
+h = 2 * f * f
+Can overlap h with f.
+*/
+
+static void fe_sq2(fe h, const fe f) {
+  fe_sq(h, f);
+  h[0] <<= 1;
+  h[1] <<= 1;
+  h[2] <<= 1;
+  h[3] <<= 1;
+  h[4] <<= 1;
+  fe_carry(h);
+}
+
+/*
+h = f - g
+Can overlap h with f or g.
+*/
+
+static void fe_sub(fe h, const fe f, const fe g) {
+  h[0] = f[0] + FE51_FOUR_P0 - g[0];
+  h[1] = f[1] + FE51_FOUR_P1 - g[1];
+  h[2] = f[2] + FE51_FOUR_P1 - g[2];
+  h[3] = f[3] + FE51_FOUR_P1 - g[3];
+  h[4] = f[4] + FE51_FOUR_P1 - g[4];
+  fe_carry(h);
+}
+
+/*
+Fully reduces h modulo p = 2^255 - 19 and writes the canonical little-endian
+encoding, matching the output of the 32-bit fe_tobytes exactly.
+*/
+
+static void fe_tobytes(unsigned char *s, const fe h) {
+  fe t;
+
+  fe_copy(t, h);
+  fe_carry(t);
+  fe_carry(t);
+  /* now t is between 0 and 2^255-1, properly carried */
+  /* case 1: between 0 and 2^255-20. case 2: between 2^255-19 and 2^255-1. */
+
+  t[0] += 19;
+  fe_carry(t);
+  /* now between 19 and 2^255-1 in both cases, and offset by 19 */
+
+  t[0] += FE51_MASK + 1 - 19;
+  t[1] += FE51_MASK;
+  t[2] += FE51_MASK;
+  t[3] += FE51_MASK;
+  t[4] += FE51_MASK;
+  /* now between 2^255 and 2^256-20, and offset by 2^255 */
+
+  t[1] += t[0] >> 51; t[0] &= FE51_MASK;
+  t[2] += t[1] >> 51; t[1] &= FE51_MASK;
+  t[3] += t[2] >> 51; t[2] &= FE51_MASK;
+  t[4] += t[3] >> 51; t[3] &= FE51_MASK;
+  t[4] &= FE51_MASK;
+
+  store_8(s, t[0] | (t[1] << 51));
+  store_8(s + 8, (t[1] >> 13) | (t[2] << 38));
+  store_8(s + 16, (t[2] >> 26) | (t[3] << 25));
+  store_8(s + 24, (t[3] >> 39) | (t[4] << 12));
+}
+
+/*
+Loads the low 255 bits of s into h; the top bit is ignored.
+Returns -1 if the value is not canonical (i.e. not below p), 0 otherwise.
+*/
+
+static int fe_frombytes(fe h, const unsigned char *s) {
+  uint64_t w0 = load_8(s);
+  uint64_t w1 = load_8(s + 8);
+  uint64_t w2 = load_8(s + 16);
+  uint64_t w3 = load_8(s + 24);
+
+  h[0] = w0 & FE51_MASK;
+  h[1] = ((w0 >> 51) | (w1 << 13)) & FE51_MASK;
+  h[2] = ((w1 >> 38) | (w2 << 26)) & FE51_MASK;
+  h[3] = ((w2 >> 25) | (w3 << 39)) & FE51_MASK;
+  h[4] = (w3 >> 12) & FE51_MASK;
+
+  if (h[4] == FE51_MASK && h[3] == FE51_MASK && h[2] == FE51_MASK && h[1] == FE51_MASK &&
+    h[0] >= FE51_MASK - 18) {
+    return -1;
+  }
+
+  return 0;
+}
+
+#else
+
 /* From fe_0.c */
 
 /*
@@ -239,6 +549,8 @@ static void fe_copy(fe h, const fe f) {
   h[9] = f9;
 }
 
+#endif
+
 /* From fe_invert.c */
 
 static void fe_invert(fe out, const fe z) {
@@ -326,6 +638,8 @@ static int fe_isnonzero(const fe f) {
     s[27] | s[28] | s[29] | s[30] | s[31]) - 1) >> 8) + 1;
 }
 
+#if !defined(CRYPTO_OPS_FE51)
+
 /* From fe_mul.c */
 
 /*
@@ -1106,6 +1420,8 @@ static void fe_tobytes(unsigned char *s, const fe h) {
   s[31] = h9 >> 18;
 }
 
+#endif
+
 /* From ge_add.c */
 
 void ge_add(ge_p1p1 *r, const ge_p3 *p, const ge_cached *q) {
@@ -1227,6 +1543,12 @@ int ge_frombytes_vartime(ge_p3 *h, const unsigned char *s) {
   fe vxx;
   fe check;
 
+#if defined(CRYPTO_OPS_FE51)
+  /* Validate the number to be canonical */
+  if (fe_frombytes(h->Y, s) != 0) {
+    return -1;
+  }
+#else
   /* From fe_frombytes.c */
 
   int64_t h0 = load_4(s);
@@ -1281,6 +1603,7 @@ int ge_frombytes_vartime(ge_p3 *h, const unsigned char *s) {
   h->Y[9] = (int32_t) h9;
 
   /* End fe_frombytes.c */
+#endif
 
   fe_1(h->Z);
   fe_sq(u, h->Y);
@@ -1985,6 +2308,53 @@ void ge_scalarmult(ge_p2 *r, const unsigned char *a, const ge_p3 *A) {
   }
 }
 
+/*
+Recodes a (with a[31] <= 127) into the signed sliding window digits used by
+ge_scalarmult_prepared_vartime, so that a scalar which multiplies many
+different points only has to be recoded once. aslide must hold 256 digits.
+*/
+
+void ge_scalarmult_prepare(signed char *aslide, const unsigned char *a) {
+  slide(aslide, a);
+}
+
+/*
+r = a * A, where aslide is the output of ge_scalarmult_prepare for a.
+
+Unlike ge_scalarmult this runs in variable time, also with respect to a.
+It is meant for keys like the wallet view key while scanning the chain,
+where the multiplications cannot be timed from outside.
+*/
+
+void ge_scalarmult_prepared_vartime(ge_p2 *r, const signed char *aslide, const ge_p3 *A) {
+  ge_dsmp Ai; /* A, 3A, 5A, 7A, 9A, 11A, 13A, 15A */
+  ge_p1p1 t;
+  ge_p3 u;
+  int i;
+
+  ge_dsm_precomp(Ai, A);
+
+  ge_p2_0(r);
+
+  for (i = 255; i >= 0; --i) {
+    if (aslide[i]) break;
+  }
+
+  for (; i >= 0; --i) {
+    ge_p2_dbl(&t, r);
+
+    if (aslide[i] > 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_add(&t, &u, &Ai[aslide[i]/2]);
+    } else if (aslide[i] < 0) {
+      ge_p1p1_to_p3(&u, &t);
+      ge_sub(&t, &u, &Ai[(-aslide[i])/2]);
+    }
+
+    ge_p1p1_to_p2(r, &t);
+  }
+}
+
 void ge_double_scalarmult_precomp_vartime(ge_p2 *r, const unsigned char *a, const ge_p3 *A, const unsigned char *b, const ge_dsmp Bi) {
   signed char aslide[256];
   signed char bslide[256];
@@ -2591,6 +2961,11 @@ void ge_fromfe_frombytes_vartime(ge_p2 *r, const unsigned char *s) {
   fe u, v, w, x, y, z;
   unsigned char sign;
 
+#if defined(CRYPTO_OPS_FE51)
+  /* All 256 bits are used here; the top one is worth 2^255 = 19 (mod p) */
+  fe_frombytes(u, s);
+  u[0] += 19 * (s[31] >> 7);
+#else
   /* From fe_frombytes.c */
 
   int64_t h0 = load_4(s);
@@ -2638,6 +3013,7 @@ void ge_fromfe_frombytes_vartime(ge_p2 *r, const unsigned char *s) {
   u[9] = (int32_t) h9;
 
   /* End fe_frombytes.c */
+#endif
 
   fe_sq2(v, u); /* 2 * u^2 */
   fe_1(w);
@@ -2703,6 +3079,52 @@ setsign:
 #endif
 }
 
+/*
+Same as calling ge_tobytes on each of the count points of h, writing 32 bytes
+per point to s, but with one field inversion for the whole batch instead of
+one per point (Montgomery's trick). scratch must hold count field elements.
+*/
+
+void ge_tobytes_batch(unsigned char *s, const ge_p2 *h, fe *scratch, size_t count) {
+  fe inv;
+  fe recip;
+  fe x;
+  fe y;
+  size_t i;
+
+  if (count == 0) {
+    return;
+  }
+
+  /* scratch[i] = Z_0 * Z_1 * ... * Z_i */
+  fe_copy(scratch[0], h[0].Z);
+  for (i = 1; i < count; i++) {
+    fe_mul(scratch[i], scratch[i - 1], h[i].Z);
+  }
+
+  /* A single Z = 0 would zero the whole product, so encode such batches one by one */
+  if (!fe_isnonzero(scratch[count - 1])) {
+    for (i = 0; i < count; i++) {
+      ge_tobytes(s + 32 * i, &h[i]);
+    }
+    return;
+  }
+
+  fe_invert(inv, scratch[count - 1]);
+  for (i = count - 1; i > 0; i--) {
+    fe_mul(recip, inv, scratch[i - 1]); /* 1 / Z_i */
+    fe_mul(inv, inv, h[i].Z); /* 1 / (Z_0 * ... * Z_(i-1)) */
+    fe_mul(x, h[i].X, recip);
+    fe_mul(y, h[i].Y, recip);
+    fe_tobytes(s + 32 * i, y);
+    s[32 * i + 31] ^= fe_isnegative(x) << 7;
+  }
+  fe_mul(x, h[0].X, inv);
+  fe_mul(y, h[0].Y, inv);
+  fe_tobytes(s, y);
+  s[31] ^= fe_isnegative(x) << 7;
+}
+
 void sc_0(unsigned char *s) {
   int i;
   for (i = 0; i < 32; i++) {
@@ -1,8 +1,26 @@
 #pragma once
 
+#if !defined(__cplusplus)
+#include <stddef.h>
+#endif
+
 /* From fe.h */
 
+/*
+CRYPTO_OPS_FE51 selects the 64-bit field backend (five 51-bit limbs with
+128-bit products) instead of ref10's ten 25.5-bit limbs. Both produce
+identical results; the 64-bit one needs compiler support for __int128.
+*/
+
+#if defined(CRYPTO_OPS_FE51) && !defined(__SIZEOF_INT128__)
+#undef CRYPTO_OPS_FE51
+#endif
+
+#if defined(CRYPTO_OPS_FE51)
+typedef uint64_t fe[5];
+#else
 typedef int32_t fe[10];
+#endif
 
 /* From ge.h */
 
@@ -101,6 +119,8 @@ void sc_reduce(unsigned char *);
 /* New code */
 
 void ge_scalarmult(ge_p2 *, const unsigned char *, const ge_p3 *);
+void ge_scalarmult_prepare(signed char *, const unsigned char *);
+void ge_scalarmult_prepared_vartime(ge_p2 *, const signed char *, const ge_p3 *);
 void ge_double_scalarmult_precomp_vartime(ge_p2 *, const unsigned char *, const ge_p3 *, const unsigned char *, const ge_dsmp);
 int ge_check_subgroup_precomp_vartime(const ge_dsmp);
 void ge_mul8(ge_p1p1 *, const ge_p2 *);
@@ -111,6 +131,7 @@ extern const fe fe_fffb2;
 extern const fe fe_fffb3;
 extern const fe fe_fffb4;
 void ge_fromfe_frombytes_vartime(ge_p2 *, const unsigned char *);
+void ge_tobytes_batch(unsigned char *, const ge_p2 *, fe *, size_t);
 void sc_0(unsigned char *);
 void sc_reduce32(unsigned char *);
 void sc_add(unsigned char *, const unsigned char *, const unsigned char *);
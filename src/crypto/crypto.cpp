@@ -112,6 +112,78 @@ namespace Crypto {
     return true;
   }
 
+  /* Encodes the valid points and scatters them to the positions of result flagged in valid */
+  template<typename T>
+  static void batch_tobytes(const std::vector<ge_p2> &points, const std::vector<bool> &valid, std::vector<T> &result) {
+    std::unique_ptr<fe[]> scratch(new fe[points.size()]);
+    std::vector<T> encoded(points.size());
+    ge_tobytes_batch(reinterpret_cast<unsigned char*>(encoded.data()), points.data(), scratch.get(), points.size());
+
+    result.resize(valid.size());
+    for (size_t i = 0, j = 0; i < valid.size(); i++) {
+      if (valid[i]) {
+        result[i] = encoded[j++];
+      }
+    }
+  }
+
+  /* multiply(point, result) computes result = key * point */
+  template<typename F>
+  static void generate_key_derivations(const std::vector<PublicKey> &keys, F multiply,
+    std::vector<KeyDerivation> &derivations, std::vector<bool> &valid) {
+    std::vector<ge_p2> points;
+    points.reserve(keys.size());
+    valid.assign(keys.size(), false);
+    for (size_t i = 0; i < keys.size(); i++) {
+      ge_p3 point;
+      ge_p2 point2;
+      ge_p1p1 point3;
+      if (ge_frombytes_vartime(&point, reinterpret_cast<const unsigned char*>(&keys[i])) != 0) {
+        continue;
+      }
+      multiply(point, point2);
+      ge_mul8(&point3, &point2);
+      ge_p1p1_to_p2(&point2, &point3);
+      points.push_back(point2);
+      valid[i] = true;
+    }
+    batch_tobytes(points, valid, derivations);
+  }
+
+  void crypto_ops::generate_key_derivations(const std::vector<PublicKey> &keys, const SecretKey &key2,
+    std::vector<KeyDerivation> &derivations, std::vector<bool> &valid) {
+    assert(sc_check(reinterpret_cast<const unsigned char*>(&key2)) == 0);
+    Crypto::generate_key_derivations(keys, [&key2](const ge_p3 &point, ge_p2 &result) {
+      ge_scalarmult(&result, reinterpret_cast<const unsigned char*>(&key2), &point);
+    }, derivations, valid);
+  }
+
+  void crypto_ops::prepare_secret_key(const SecretKey &key, PreparedSecretKey &prepared) {
+    assert(sc_check(reinterpret_cast<const unsigned char*>(&key)) == 0);
+    ge_scalarmult_prepare(prepared.digits, reinterpret_cast<const unsigned char*>(&key));
+  }
+
+  bool crypto_ops::generate_key_derivation(const PublicKey &key1, const PreparedSecretKey &key2, KeyDerivation &derivation) {
+    ge_p3 point;
+    ge_p2 point2;
+    ge_p1p1 point3;
+    if (ge_frombytes_vartime(&point, reinterpret_cast<const unsigned char*>(&key1)) != 0) {
+      return false;
+    }
+    ge_scalarmult_prepared_vartime(&point2, key2.digits, &point);
+    ge_mul8(&point3, &point2);
+    ge_p1p1_to_p2(&point2, &point3);
+    ge_tobytes(reinterpret_cast<unsigned char*>(&derivation), &point2);
+    return true;
+  }
+
+  void crypto_ops::generate_key_derivations(const std::vector<PublicKey> &keys, const PreparedSecretKey &key2,
+    std::vector<KeyDerivation> &derivations, std::vector<bool> &valid) {
+    Crypto::generate_key_derivations(keys, [&key2](const ge_p3 &point, ge_p2 &result) {
+      ge_scalarmult_prepared_vartime(&result, key2.digits, &point);
+    }, derivations, valid);
+  }
+
   static void derivation_to_scalar(const KeyDerivation &derivation, size_t output_index, EllipticCurveScalar &res) {
     struct {
       KeyDerivation derivation;
@@ -256,6 +328,33 @@ namespace Crypto {
     return true;
   }
 
+  void crypto_ops::underive_public_keys(const std::vector<KeyDerivation> &derivations, const std::vector<size_t> &output_indexes,
+    const std::vector<PublicKey> &derived_keys, std::vector<PublicKey> &bases, std::vector<bool> &valid) {
+    std::vector<ge_p2> points;
+    assert(derivations.size() == derived_keys.size() && output_indexes.size() == derived_keys.size());
+    points.reserve(derived_keys.size());
+    valid.assign(derived_keys.size(), false);
+    for (size_t i = 0; i < derived_keys.size(); i++) {
+      EllipticCurveScalar scalar;
+      ge_p3 point1;
+      ge_p3 point2;
+      ge_cached point3;
+      ge_p1p1 point4;
+      ge_p2 point5;
+      if (ge_frombytes_vartime(&point1, reinterpret_cast<const unsigned char*>(&derived_keys[i])) != 0) {
+        continue;
+      }
+      derivation_to_scalar(derivations[i], output_indexes[i], scalar);
+      ge_scalarmult_base(&point2, reinterpret_cast<unsigned char*>(&scalar));
+      ge_p3_to_cached(&point3, &point2);
+      ge_sub(&point4, &point1, &point3);
+      ge_p1p1_to_p2(&point5, &point4);
+      points.push_back(point5);
+      valid[i] = true;
+    }
+    batch_tobytes(points, valid, bases);
+  }
+
 
   struct s_comm {
     Hash h;
@@ -34,6 +34,12 @@ struct EllipticCurveScalar {
   uint8_t data[32];
 };
 
+/* A secret key recoded once into signed window digits, for keys that multiply
+   many different points, like the view key while scanning for outputs */
+struct PreparedSecretKey {
+  signed char digits[256];
+};
+
   class crypto_ops {
     crypto_ops();
     crypto_ops(const crypto_ops &);
@@ -52,6 +58,14 @@ struct EllipticCurveScalar {
     friend bool secret_key_to_public_key(const SecretKey &, PublicKey &);
     static bool generate_key_derivation(const PublicKey &, const SecretKey &, KeyDerivation &);
     friend bool generate_key_derivation(const PublicKey &, const SecretKey &, KeyDerivation &);
+    static void generate_key_derivations(const std::vector<PublicKey> &, const SecretKey &, std::vector<KeyDerivation> &, std::vector<bool> &);
+    friend void generate_key_derivations(const std::vector<PublicKey> &, const SecretKey &, std::vector<KeyDerivation> &, std::vector<bool> &);
+    static void prepare_secret_key(const SecretKey &, PreparedSecretKey &);
+    friend void prepare_secret_key(const SecretKey &, PreparedSecretKey &);
+    static bool generate_key_derivation(const PublicKey &, const PreparedSecretKey &, KeyDerivation &);
+    friend bool generate_key_derivation(const PublicKey &, const PreparedSecretKey &, KeyDerivation &);
+    static void generate_key_derivations(const std::vector<PublicKey> &, const PreparedSecretKey &, std::vector<KeyDerivation> &, std::vector<bool> &);
+    friend void generate_key_derivations(const std::vector<PublicKey> &, const PreparedSecretKey &, std::vector<KeyDerivation> &, std::vector<bool> &);
     static bool derive_public_key(const KeyDerivation &, size_t, const PublicKey &, PublicKey &);
     friend bool derive_public_key(const KeyDerivation &, size_t, const PublicKey &, PublicKey &);
     friend bool derive_public_key(const KeyDerivation &, size_t, const PublicKey &, const uint8_t*, size_t, PublicKey &);
@@ -70,6 +84,8 @@ struct EllipticCurveScalar {
     friend bool underive_public_key(const KeyDerivation &, size_t, const PublicKey &, PublicKey &);
     static bool underive_public_key(const KeyDerivation &, size_t, const PublicKey &, const uint8_t*, size_t, PublicKey &);
     friend bool underive_public_key(const KeyDerivation &, size_t, const PublicKey &, const uint8_t*, size_t, PublicKey &);
+    static void underive_public_keys(const std::vector<KeyDerivation> &, const std::vector<size_t> &, const std::vector<PublicKey> &, std::vector<PublicKey> &, std::vector<bool> &);
+    friend void underive_public_keys(const std::vector<KeyDerivation> &, const std::vector<size_t> &, const std::vector<PublicKey> &, std::vector<PublicKey> &, std::vector<bool> &);
     static void generate_signature(const Hash &, const PublicKey &, const SecretKey &, Signature &);
     friend void generate_signature(const Hash &, const PublicKey &, const SecretKey &, Signature &);
     static bool check_signature(const Hash &, const PublicKey &, const Signature &);
@@ -165,6 +181,32 @@ struct EllipticCurveScalar {
     return crypto_ops::generate_key_derivation(key1, key2, derivation);
   }
 
+  /* Batched generate_key_derivation for wallet scanning: derivations[i] is derived from keys[i] and the
+   * (view) secret key. The final point encodings share a single field inversion, which makes this cheaper
+   * than calling generate_key_derivation in a loop. valid[i] is false where keys[i] is not a valid point.
+   */
+  inline void generate_key_derivations(const std::vector<PublicKey> &keys, const SecretKey &key2,
+    std::vector<KeyDerivation> &derivations, std::vector<bool> &valid) {
+    crypto_ops::generate_key_derivations(keys, key2, derivations, valid);
+  }
+
+  /* Recodes a secret key for the PreparedSecretKey overloads of generate_key_derivation(s), which give
+   * the same results but skip the recoding and use a sliding window multiplication. These run in
+   * variable time, so only use them where the timing of the key cannot be observed (wallet scanning).
+   */
+  inline void prepare_secret_key(const SecretKey &key, PreparedSecretKey &prepared) {
+    crypto_ops::prepare_secret_key(key, prepared);
+  }
+
+  inline bool generate_key_derivation(const PublicKey &key1, const PreparedSecretKey &key2, KeyDerivation &derivation) {
+    return crypto_ops::generate_key_derivation(key1, key2, derivation);
+  }
+
+  inline void generate_key_derivations(const std::vector<PublicKey> &keys, const PreparedSecretKey &key2,
+    std::vector<KeyDerivation> &derivations, std::vector<bool> &valid) {
+    crypto_ops::generate_key_derivations(keys, key2, derivations, valid);
+  }
+
   inline bool derive_public_key(const KeyDerivation &derivation, size_t output_index,
     const PublicKey &base, const uint8_t* prefix, size_t prefixLength, PublicKey &derived_key) {
     return crypto_ops::derive_public_key(derivation, output_index, base, prefix, prefixLength, derived_key);
@@ -204,6 +246,15 @@ struct EllipticCurveScalar {
     return crypto_ops::underive_public_key(derivation, output_index, derived_key, base);
   }
 
+  /* Batched underive_public_key: bases[i] is underived from derivations[i], output_indexes[i] and
+   * derived_keys[i], sharing one field inversion for the whole batch. valid[i] is false where
+   * derived_keys[i] is not a valid point.
+   */
+  inline void underive_public_keys(const std::vector<KeyDerivation> &derivations, const std::vector<size_t> &output_indexes,
+    const std::vector<PublicKey> &derived_keys, std::vector<PublicKey> &bases, std::vector<bool> &valid) {
+    crypto_ops::underive_public_keys(derivations, output_indexes, derived_keys, bases, valid);
+  }
+
   /* Generation and checking of a standard signature.
    */
   inline void generate_signature(const Hash &prefix_hash, const PublicKey &pub, const SecretKey &sec, Signature &sig) {
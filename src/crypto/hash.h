@@ -55,6 +55,11 @@ namespace Crypto {
     return h;
   }
 
+  /* hashes[i] = cn_fast_hash(data[i], lengths[i]) for all i < count, computed several at a time */
+  inline void cn_fast_hash_many(const void *const *data, const size_t *lengths, Hash *const *hashes, size_t count) {
+    cn_fast_hash_many(data, lengths, reinterpret_cast<char *const *>(hashes), count);
+  }
+
   // Standard CryptoNight
   inline void cn_slow_hash_v0(const void *data, size_t length, Hash &hash) {
     cn_slow_hash(data, length, reinterpret_cast<char *>(&hash), 0, 0, 0, CN_PAGE_SIZE, CN_SCRATCHPAD, CN_ITERATIONS);
@@ -117,3 +117,196 @@ void keccak1600(const uint8_t *in, int inlen, uint8_t *md)
 {
     keccak(in, inlen, md, sizeof(state_t));
 }
+
+// keccak_many keeps the states of KECCAK_MANY_LANES messages interleaved, word i of
+// lane l in st.w[i][l], so that one vector operation updates the same word of all lanes
+
+#if defined(__GNUC__)
+#define KECCAK_MANY_VECTORS 1
+typedef uint64_t keccak_vector __attribute__((vector_size(8 * KECCAK_MANY_LANES)));
+#endif
+
+typedef union {
+#if defined(KECCAK_MANY_VECTORS)
+    keccak_vector v[25];
+#endif
+    uint64_t w[25][KECCAK_MANY_LANES];
+} keccak_many_state;
+
+typedef void (*keccakf_many_fn)(keccak_many_state *, int);
+
+#if defined(KECCAK_MANY_VECTORS)
+
+// keccakf on all lanes; always inlined, so that every caller below is
+// compiled for its own instruction set
+
+static inline __attribute__((always_inline)) void keccakf_vector(keccak_vector st[25], int rounds)
+{
+    int i, j, round;
+    keccak_vector t, bc[5];
+
+    for (round = 0; round < rounds; round++) {
+
+        // Theta
+        for (i = 0; i < 5; i++)
+            bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+
+        for (i = 0; i < 5; i++) {
+            t = bc[(i + 4) % 5] ^ ROTL64(bc[(i + 1) % 5], 1);
+            for (j = 0; j < 25; j += 5)
+                st[j + i] ^= t;
+        }
+
+        // Rho Pi
+        t = st[1];
+        for (i = 0; i < 24; i++) {
+            j = keccakf_piln[i];
+            bc[0] = st[j];
+            st[j] = ROTL64(t, keccakf_rotc[i]);
+            t = bc[0];
+        }
+
+        //  Chi
+        for (j = 0; j < 25; j += 5) {
+            for (i = 0; i < 5; i++)
+                bc[i] = st[j + i];
+            for (i = 0; i < 5; i++)
+                st[j + i] ^= (~bc[(i + 1) % 5]) & bc[(i + 2) % 5];
+        }
+
+        //  Iota
+        st[0] ^= keccakf_rndc[round];
+    }
+}
+
+static void keccakf_many_default(keccak_many_state *st, int rounds)
+{
+    keccakf_vector(st->v, rounds);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+__attribute__((target("avx2")))
+static void keccakf_many_avx2(keccak_many_state *st, int rounds)
+{
+    keccakf_vector(st->v, rounds);
+}
+
+__attribute__((target("avx512f")))
+static void keccakf_many_avx512(keccak_many_state *st, int rounds)
+{
+    keccakf_vector(st->v, rounds);
+}
+#endif
+
+#else
+
+static void keccakf_many_default(keccak_many_state *st, int rounds)
+{
+    uint64_t lane[25];
+    int i, l;
+
+    for (l = 0; l < KECCAK_MANY_LANES; l++) {
+        for (i = 0; i < 25; i++)
+            lane[i] = st->w[i][l];
+        keccakf(lane, rounds);
+        for (i = 0; i < 25; i++)
+            st->w[i][l] = lane[i];
+    }
+}
+
+#endif
+
+static keccakf_many_fn keccakf_many_select(void)
+{
+#if defined(KECCAK_MANY_VECTORS) && (defined(__x86_64__) || defined(__i386__))
+    if (__builtin_cpu_supports("avx512f"))
+        return keccakf_many_avx512;
+    if (__builtin_cpu_supports("avx2"))
+        return keccakf_many_avx2;
+#endif
+    return keccakf_many_default;
+}
+
+// every lane works on its own message and takes the next one as soon as it is
+// done, so messages of different lengths do not leave lanes idle until the end
+
+void keccak_many(const uint8_t *const *in, const size_t *inlen, uint8_t *const *md, int mdlen, size_t count)
+{
+    keccak_many_state st;
+    keccakf_many_fn permute = keccakf_many_select();
+    size_t message[KECCAK_MANY_LANES], offset[KECCAK_MANY_LANES];
+    size_t next = 0, active = 0;
+    uint8_t temp[144];
+    uint64_t word;
+    int i, l, n, rsiz, rsizw;
+
+    const int HASH_DATA_AREA = 136;
+
+    rsiz = sizeof(state_t) == mdlen ? HASH_DATA_AREA : 200 - 2 * mdlen;
+    rsizw = rsiz / 8;
+
+    memset(&st, 0, sizeof(st));
+
+    for (l = 0; l < KECCAK_MANY_LANES; l++) {
+        if (next < count) {
+            message[l] = next++;
+            offset[l] = 0;
+            active++;
+        } else {
+            message[l] = count;
+        }
+    }
+
+    while (active > 0) {
+        for (l = 0; l < KECCAK_MANY_LANES; l++) {
+            const uint8_t *block;
+            if (message[l] == count)
+                continue;
+
+            if (inlen[message[l]] - offset[l] >= (size_t)rsiz) {
+                block = in[message[l]] + offset[l];
+            } else {
+                // last block and padding
+                n = (int)(inlen[message[l]] - offset[l]);
+                memcpy(temp, in[message[l]] + offset[l], n);
+                temp[n++] = 1;
+                memset(temp + n, 0, rsiz - n);
+                temp[rsiz - 1] |= 0x80;
+                block = temp;
+            }
+
+            for (i = 0; i < rsizw; i++) {
+                memcpy(&word, block + 8 * i, 8);
+                st.w[i][l] ^= word;
+            }
+        }
+
+        permute(&st, KECCAK_ROUNDS);
+
+        for (l = 0; l < KECCAK_MANY_LANES; l++) {
+            if (message[l] == count)
+                continue;
+
+            if (inlen[message[l]] - offset[l] >= (size_t)rsiz) {
+                offset[l] += rsiz;
+                continue;
+            }
+
+            for (i = 0; 8 * i < mdlen; i++) {
+                n = mdlen - 8 * i < 8 ? mdlen - 8 * i : 8;
+                memcpy(md[message[l]] + 8 * i, &st.w[i][l], n);
+            }
+
+            for (i = 0; i < 25; i++)
+                st.w[i][l] = 0;
+
+            if (next < count) {
+                message[l] = next++;
+                offset[l] = 0;
+            } else {
+                message[l] = count;
+                active--;
+            }
+        }
+    }
+}
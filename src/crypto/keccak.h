@@ -23,4 +23,11 @@ void keccakf(uint64_t st[25], int norounds);
 
 void keccak1600(const uint8_t *in, int inlen, uint8_t *md);
 
+// number of states keccak_many permutes together
+#define KECCAK_MANY_LANES 8
+
+// compute the keccak hashes md[i] of given byte length from in[i] for all i < count,
+// several messages at a time in SIMD lanes; md[i] may only overlap with in[i]
+void keccak_many(const uint8_t *const *in, const size_t *inlen, uint8_t *const *md, int mdlen, size_t count);
+
 #endif
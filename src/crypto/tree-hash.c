@@ -22,6 +22,20 @@
 
 #include "hash-ops.h"
 
+/* out[k] = cn_fast_hash(pairs[2k] || pairs[2k + 1]) for all k < count, with all the pairs of a level hashed together */
+static void hash_pairs(const char (*pairs)[HASH_SIZE], size_t count, char (*out)[HASH_SIZE]) {
+  size_t k;
+  const void **data = alloca(count * sizeof(const void *));
+  size_t *length = alloca(count * sizeof(size_t));
+  char **hash = alloca(count * sizeof(char *));
+  for (k = 0; k < count; ++k) {
+    data[k] = pairs[2 * k];
+    length[k] = 2 * HASH_SIZE;
+    hash[k] = out[k];
+  }
+  cn_fast_hash_many(data, length, hash, count);
+}
+
 void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
   assert(count > 0);
   if (count == 1) {
@@ -29,24 +43,25 @@ void tree_hash(const char (*hashes)[HASH_SIZE], size_t count, char *root_hash) {
   } else if (count == 2) {
     cn_fast_hash(hashes, 2 * HASH_SIZE, root_hash);
   } else {
-    size_t i, j;
+    size_t i;
     size_t cnt = count - 1;
     char (*ints)[HASH_SIZE];
+    char (*next)[HASH_SIZE];
+    char (*swap)[HASH_SIZE];
     for (i = 1; i < 8 * sizeof(size_t); i <<= 1) {
       cnt |= cnt >> i;
     }
     cnt &= ~(cnt >> 1);
     ints = alloca(cnt * HASH_SIZE);
+    next = alloca(cnt / 2 * HASH_SIZE);
     memcpy(ints, hashes, (2 * cnt - count) * HASH_SIZE);
-    for (i = 2 * cnt - count, j = 2 * cnt - count; j < cnt; i += 2, ++j) {
-      cn_fast_hash(hashes[i], 2 * HASH_SIZE, ints[j]);
-    }
-    assert(i == count);
+    hash_pairs(hashes + 2 * cnt - count, count - cnt, ints + 2 * cnt - count);
     while (cnt > 2) {
       cnt >>= 1;
-      for (i = 0, j = 0; j < cnt; i += 2, ++j) {
-        cn_fast_hash(ints[i], 2 * HASH_SIZE, ints[j]);
-      }
+      hash_pairs((const char (*)[HASH_SIZE]) ints, cnt, next);
+      swap = ints;
+      ints = next;
+      next = swap;
     }
     cn_fast_hash(ints[0], 2 * HASH_SIZE, root_hash);
   }
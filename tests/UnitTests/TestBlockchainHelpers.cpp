@@ -0,0 +1,158 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "TestBlockchainHelpers.h"
+
+#include <ctime>
+#include <system_error>
+
+#include <boost/filesystem.hpp>
+
+#include "rocksdb/db.h"
+
+#include "crypto/crypto.h"
+#include "CryptoNoteCore/BlockchainReadBatch.h"
+#include "CryptoNoteCore/CachedBlock.h"
+#include "CryptoNoteCore/Checkpoints.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/DatabaseBlockchainCache.h"
+#include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
+#include "CryptoNoteCore/MainChainStorage.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+
+namespace CryptoNote {
+
+TemporaryDirectory::TemporaryDirectory() {
+  boost::filesystem::path directory = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("turtlecoin-test-%%%%-%%%%-%%%%");
+  boost::filesystem::create_directories(directory);
+  path = directory.string();
+}
+
+TemporaryDirectory::~TemporaryDirectory() {
+  boost::system::error_code ignored;
+  boost::filesystem::remove_all(path, ignored);
+}
+
+DataBaseConfig makeTestDataBaseConfig(const std::string& dataDir) {
+  DataBaseConfig config;
+  config.setDataDir(dataDir);
+  config.setWriteBufferSize(4 * 1024 * 1024);
+  config.setReadCacheSize(4 * 1024 * 1024);
+  return config;
+}
+
+std::map<std::string, std::string> dumpDataBase(const DataBaseConfig& config) {
+  rocksdb::DB* dbPtr;
+  rocksdb::Status status = rocksdb::DB::OpenForReadOnly(rocksdb::Options(), config.getDataDir() + "/DB", &dbPtr);
+  if (!status.ok()) {
+    throw std::runtime_error("Can't open DB to dump it: " + status.ToString());
+  }
+
+  std::unique_ptr<rocksdb::DB> db(dbPtr);
+  std::unique_ptr<rocksdb::Iterator> it(db->NewIterator(rocksdb::ReadOptions()));
+
+  std::map<std::string, std::string> contents;
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    contents.emplace(it->key().ToString(), it->value().ToString());
+  }
+
+  if (!it->status().ok()) {
+    throw std::runtime_error("Can't dump DB: " + it->status().ToString());
+  }
+
+  return contents;
+}
+
+uint32_t getDataBaseTopBlockIndex(IDataBase& database) {
+  auto readBatch = BlockchainReadBatch().requestLastBlockIndex();
+  auto error = database.read(readBatch);
+  if (error) {
+    throw std::system_error(error);
+  }
+
+  return readBatch.extractResult().getLastBlockIndex().first;
+}
+
+TestNode::TestNode(const Currency& currency, Logging::ILogger& logger, System::Dispatcher& dispatcher, const std::string& dataDir,
+                   uint32_t memorySegmentDepth) :
+  currency(currency), logger(logger), dispatcher(dispatcher), dataDir(dataDir), memorySegmentDepth(memorySegmentDepth),
+  config(makeTestDataBaseConfig(dataDir)), database(logger), firstTimestamp(std::time(nullptr) - 30 * 24 * 60 * 60) {
+  Crypto::SecretKey secretKey;
+  Crypto::generate_keys(minerAddress.spendPublicKey, secretKey);
+  Crypto::generate_keys(minerAddress.viewPublicKey, secretKey);
+}
+
+TestNode::~TestNode() {
+  if (core) {
+    stop();
+  }
+}
+
+void TestNode::start() {
+  database.init(config);
+  if (!DatabaseBlockchainCache::checkDBSchemeVersion(database, logger)) {
+    database.shutdown();
+    database.destroy(config);
+    database.init(config);
+  }
+
+  std::unique_ptr<IMainChainStorage> mainChainStorage = createSwappedMainChainStorage(dataDir, currency);
+  std::unique_ptr<IBlockchainCacheFactory> blockchainCacheFactory(new DatabaseBlockchainCacheFactory(database, *mainChainStorage, "", logger));
+  core.reset(new Core(currency, logger, Checkpoints(logger), dispatcher, std::move(blockchainCacheFactory), std::move(mainChainStorage)));
+  core->setMemorySegmentDepth(memorySegmentDepth);
+  core->load();
+}
+
+void TestNode::stop() {
+  core->save();
+  core.reset();
+  database.shutdown();
+}
+
+BlockTemplate TestNode::makeBlock(const std::string& extraNonce) {
+  BlockTemplate block;
+  uint64_t difficulty;
+  uint32_t height;
+  if (!core->getBlockTemplate(block, minerAddress, BinaryArray(extraNonce.begin(), extraNonce.end()), difficulty, height)) {
+    throw std::runtime_error("Can't get block template");
+  }
+
+  // blocks exactly the target apart keep the difficulty at its minimum, competing blocks share the timestamp
+  block.timestamp = firstTimestamp + height * currency.difficultyTarget();
+
+  // the template leaves the merge mining tag empty, the miner fills it once the header is final
+  for (;; ++block.nonce) {
+    if (block.majorVersion >= BLOCK_MAJOR_VERSION_2) {
+      TransactionExtraMergeMiningTag mmTag;
+      mmTag.depth = 0;
+      mmTag.merkleRoot = CachedBlock(block).getAuxiliaryBlockHeaderHash();
+
+      block.parentBlock.baseTransaction.extra.clear();
+      if (!appendMergeMiningTagToExtra(block.parentBlock.baseTransaction.extra, mmTag)) {
+        throw std::runtime_error("Couldn't append merge mining tag");
+      }
+    }
+
+    if (currency.checkProofOfWork(CachedBlock(block), difficulty)) {
+      return block;
+    }
+  }
+}
+
+std::error_code TestNode::addBlock(const BlockTemplate& block) {
+  RawBlock rawBlock;
+  rawBlock.block = toBinaryArray(block);
+  return core->addBlock(std::move(rawBlock));
+}
+
+void TestNode::addBlocks(uint32_t count) {
+  for (uint32_t i = 0; i < count; ++i) {
+    auto error = addBlock(makeBlock());
+    if (error != error::AddBlockErrorCode::ADDED_TO_MAIN) {
+      throw std::system_error(error);
+    }
+  }
+}
+
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "CryptoNote.h"
+#include "CryptoNoteCore/Core.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/DataBaseConfig.h"
+#include "CryptoNoteCore/IMainChainStorage.h"
+#include "CryptoNoteCore/RocksDBWrapper.h"
+#include "Logging/ILogger.h"
+#include "System/Dispatcher.h"
+
+namespace CryptoNote {
+
+// A directory under the system temporary directory, removed with everything in it on destruction
+class TemporaryDirectory {
+public:
+  TemporaryDirectory();
+  ~TemporaryDirectory();
+
+  const std::string& getPath() const { return path; }
+
+private:
+  std::string path;
+};
+
+DataBaseConfig makeTestDataBaseConfig(const std::string& dataDir);
+
+// Every key and value of a closed DB
+std::map<std::string, std::string> dumpDataBase(const DataBaseConfig& config);
+
+// The last block index the DB has, the root segment's top
+uint32_t getDataBaseTopBlockIndex(IDataBase& database);
+
+// A core over a DB and a main chain storage in dataDir, set up the way the daemon does it. Blocks come from the core's
+// own templates, their timestamps are a minute apart so the difficulty stays at 1 and any nonce is a valid proof of work.
+class TestNode {
+public:
+  TestNode(const Currency& currency, Logging::ILogger& logger, System::Dispatcher& dispatcher, const std::string& dataDir,
+           uint32_t memorySegmentDepth);
+  ~TestNode();
+
+  // destroys and recreates the DB if its scheme version is older, as the daemon does
+  void start();
+  void stop();
+
+  Core& getCore() { return *core; }
+  RocksDBWrapper& getDataBase() { return database; }
+  const DataBaseConfig& getDataBaseConfig() const { return config; }
+
+  // templates on top of the main chain, extraNonce makes the base transactions of competing blocks differ
+  BlockTemplate makeBlock(const std::string& extraNonce = std::string());
+  std::error_code addBlock(const BlockTemplate& block);
+  void addBlocks(uint32_t count);
+
+private:
+  const Currency& currency;
+  Logging::ILogger& logger;
+  System::Dispatcher& dispatcher;
+  std::string dataDir;
+  uint32_t memorySegmentDepth;
+  DataBaseConfig config;
+  RocksDBWrapper database;
+  std::unique_ptr<Core> core;
+  AccountPublicAddress minerAddress;
+  uint64_t firstTimestamp;
+};
+
+}
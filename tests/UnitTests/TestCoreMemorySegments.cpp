@@ -0,0 +1,106 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "gtest/gtest.h"
+
+#include "CryptoNoteCore/AddBlockErrors.h"
+#include "CryptoNoteCore/CachedBlock.h"
+#include "Logging/LoggerGroup.h"
+
+#include "TestBlockchainHelpers.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint32_t MEMORY_SEGMENT_DEPTH = 3;
+
+class CoreMemorySegmentsTest : public ::testing::Test {
+public:
+  CoreMemorySegmentsTest() :
+    currency(CurrencyBuilder(logger).currency()),
+    node(currency, logger, dispatcher, directory.getPath(), MEMORY_SEGMENT_DEPTH) {
+  }
+
+protected:
+  virtual void SetUp() override {
+    node.start();
+  }
+
+  // adds two blocks on top of the main chain, the second one stays an alternative block
+  uint32_t addOrphan() {
+    BlockTemplate mainBlock = node.makeBlock("main");
+    BlockTemplate alternativeBlock = node.makeBlock("alternative");
+
+    EXPECT_EQ(make_error_code(error::AddBlockErrorCode::ADDED_TO_MAIN), node.addBlock(mainBlock));
+    EXPECT_EQ(make_error_code(error::AddBlockErrorCode::ADDED_TO_ALTERNATIVE), node.addBlock(alternativeBlock));
+    EXPECT_EQ(1, node.getCore().getAlternativeBlockCount());
+
+    return node.getCore().getTopBlockIndex();
+  }
+
+  uint32_t getDataBaseTop() {
+    return getDataBaseTopBlockIndex(node.getDataBase());
+  }
+
+  Logging::LoggerGroup logger;
+  System::Dispatcher dispatcher;
+  Currency currency;
+  TemporaryDirectory directory;
+  TestNode node;
+};
+
+TEST_F(CoreMemorySegmentsTest, keepsBlocksWithinDepthInMemory) {
+  node.addBlocks(20);
+
+  uint32_t top = node.getCore().getTopBlockIndex();
+  uint32_t dataBaseTop = getDataBaseTop();
+  ASSERT_EQ(20, top);
+  ASSERT_LT(dataBaseTop, top);
+  ASSERT_LE(top - dataBaseTop, 2 * MEMORY_SEGMENT_DEPTH);
+  ASSERT_GE(top - dataBaseTop, MEMORY_SEGMENT_DEPTH);
+}
+
+TEST_F(CoreMemorySegmentsTest, keepsShallowOrphan) {
+  node.addBlocks(10);
+  addOrphan();
+  node.addBlocks(MEMORY_SEGMENT_DEPTH - 1);
+
+  ASSERT_EQ(1, node.getCore().getAlternativeBlockCount());
+}
+
+TEST_F(CoreMemorySegmentsTest, commitsMainChainPastBuriedOrphan) {
+  node.addBlocks(10);
+  uint32_t forkTop = addOrphan();
+  node.addBlocks(5 * MEMORY_SEGMENT_DEPTH);
+
+  uint32_t top = node.getCore().getTopBlockIndex();
+  uint32_t dataBaseTop = getDataBaseTop();
+  ASSERT_EQ(0, node.getCore().getAlternativeBlockCount());
+  ASSERT_GT(dataBaseTop, forkTop);
+  ASSERT_LE(top - dataBaseTop, 2 * MEMORY_SEGMENT_DEPTH);
+}
+
+TEST_F(CoreMemorySegmentsTest, reloadsMainChainAfterDroppingOrphan) {
+  node.addBlocks(10);
+  addOrphan();
+  node.addBlocks(5 * MEMORY_SEGMENT_DEPTH);
+
+  uint32_t top = node.getCore().getTopBlockIndex();
+  Crypto::Hash topHash = node.getCore().getTopBlockHash();
+  Crypto::Hash middleHash = node.getCore().getBlockHashByIndex(top / 2);
+
+  node.stop();
+  node.start();
+
+  ASSERT_EQ(top, node.getCore().getTopBlockIndex());
+  ASSERT_EQ(topHash, node.getCore().getTopBlockHash());
+  ASSERT_EQ(middleHash, node.getCore().getBlockHashByIndex(top / 2));
+  ASSERT_EQ(top, getDataBaseTop());
+
+  node.addBlocks(1);
+  ASSERT_EQ(top + 1, node.getCore().getTopBlockIndex());
+}
+
+}
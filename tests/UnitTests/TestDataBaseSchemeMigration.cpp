@@ -0,0 +1,135 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "gtest/gtest.h"
+
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "IWriteBatch.h"
+#include "Common/StdOutputStream.h"
+#include "CryptoNoteCore/DBUtils.h"
+#include "Logging/LoggerGroup.h"
+#include "Serialization/KVBinaryOutputStreamSerializer.h"
+#include "Serialization/SerializationOverloads.h"
+
+#include "TestBlockchainHelpers.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const std::string DB_VERSION_KEY = "db_scheme_version";
+
+class RawWriteBatch : public IWriteBatch {
+public:
+  void insert(const std::string& key, const std::string& value) {
+    rawDataToInsert.emplace_back(key, value);
+  }
+
+  virtual std::vector<std::pair<std::string, std::string>> extractRawDataToInsert() override {
+    return std::move(rawDataToInsert);
+  }
+
+  virtual std::vector<std::string> extractRawKeysToRemove() override {
+    return {};
+  }
+
+private:
+  std::vector<std::pair<std::string, std::string>> rawDataToInsert;
+};
+
+// scheme version 2 stored keys and values in the key-value storage format, a key as the (prefix, key) pair
+template <class Value>
+std::string serializeVersion2(const Value& value, const std::string& name) {
+  KVBinaryOutputStreamSerializer serializer;
+  serializer(const_cast<Value&>(value), name);
+
+  std::stringstream stream;
+  Common::StdOutputStream output(stream);
+  serializer.dump(output);
+  return stream.str();
+}
+
+template <class Key>
+std::string serializeVersion2Key(const std::string& prefix, const Key& key) {
+  return serializeVersion2(std::make_pair(prefix, key), prefix);
+}
+
+class DataBaseSchemeMigrationTest : public ::testing::Test {
+public:
+  DataBaseSchemeMigrationTest() :
+    currency(CurrencyBuilder(logger).currency()),
+    // everything goes to the database right away, so the dump has the whole chain
+    node(currency, logger, dispatcher, directory.getPath(), 0) {
+  }
+
+protected:
+  void writeToDataBase(RawWriteBatch& writeBatch) {
+    RocksDBWrapper database(logger);
+    database.init(node.getDataBaseConfig());
+    ASSERT_FALSE(database.write(writeBatch));
+    database.shutdown();
+  }
+
+  Logging::LoggerGroup logger;
+  System::Dispatcher dispatcher;
+  Currency currency;
+  TemporaryDirectory directory;
+  TestNode node;
+};
+
+TEST_F(DataBaseSchemeMigrationTest, rebuildsOlderSchemeFromMainChainStorage) {
+  node.start();
+  node.addBlocks(15);
+  std::vector<Crypto::Hash> blockHashes;
+  for (uint32_t blockIndex = 0; blockIndex <= 15; ++blockIndex) {
+    blockHashes.push_back(node.getCore().getBlockHashByIndex(blockIndex));
+  }
+
+  node.stop();
+
+  auto expectedContents = dumpDataBase(node.getDataBaseConfig());
+  ASSERT_EQ("3", expectedContents.at(DB_VERSION_KEY));
+
+  // what a version 2 database holds for the chain, next to the version
+  RawWriteBatch writeBatch;
+  writeBatch.insert(DB_VERSION_KEY, "2");
+  writeBatch.insert(serializeVersion2Key(DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, DB::LAST_BLOCK_INDEX_KEY),
+                    serializeVersion2(uint32_t(15), DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX));
+  for (uint32_t blockIndex = 0; blockIndex <= 15; ++blockIndex) {
+    writeBatch.insert(serializeVersion2Key(DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX, blockIndex),
+                      serializeVersion2(blockHashes[blockIndex], DB::BLOCK_INDEX_TO_BLOCK_HASH_PREFIX));
+  }
+
+  writeToDataBase(writeBatch);
+  ASSERT_NE(expectedContents, dumpDataBase(node.getDataBaseConfig()));
+
+  node.start();
+  EXPECT_EQ(15, node.getCore().getTopBlockIndex());
+  EXPECT_EQ(blockHashes.back(), node.getCore().getTopBlockHash());
+  node.stop();
+
+  EXPECT_EQ(expectedContents, dumpDataBase(node.getDataBaseConfig()));
+}
+
+TEST_F(DataBaseSchemeMigrationTest, refusesNewerScheme) {
+  node.start();
+  node.addBlocks(3);
+  node.stop();
+
+  RawWriteBatch writeBatch;
+  writeBatch.insert(DB_VERSION_KEY, "4");
+  writeToDataBase(writeBatch);
+
+  auto contents = dumpDataBase(node.getDataBaseConfig());
+  EXPECT_THROW(node.start(), std::runtime_error);
+  node.getDataBase().shutdown();
+
+  EXPECT_EQ(contents, dumpDataBase(node.getDataBaseConfig()));
+}
+
+}
@@ -0,0 +1,413 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "gtest/gtest.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/StringTools.h"
+#include "crypto/hash.h"
+#include "CryptoNoteCore/BlockchainWriteBatch.h"
+#include "CryptoNoteCore/CachedBlock.h"
+#include "CryptoNoteCore/CachedTransaction.h"
+#include "CryptoNoteCore/CryptoNoteTools.h"
+#include "CryptoNoteCore/Currency.h"
+#include "CryptoNoteCore/DatabaseBlockchainCacheFactory.h"
+#include "CryptoNoteCore/MainChainStorage.h"
+#include "CryptoNoteCore/RocksDBWrapper.h"
+#include "CryptoNoteCore/TransactionExtra.h"
+#include "CryptoNoteCore/TransactionValidatiorState.h"
+#include "Logging/LoggerGroup.h"
+
+#include "TestBlockchainHelpers.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+const uint64_t FIRST_BLOCK_TIMESTAMP = 1514764800;
+// a few blocks a day, so both the first blocks of days and the blocks after them are indexed by timestamp
+const uint64_t BLOCK_TIME_STEP = 20000;
+
+const uint64_t SPENT_AMOUNT = 10;
+const std::vector<uint64_t> BASE_AMOUNTS = {100, 1000, 10000};
+
+struct TestBlock {
+  BlockTemplate block;
+  std::vector<CachedTransaction> transactions;
+  TransactionValidatorState validatorState;
+  RawBlock rawBlock;
+  uint64_t generatedCoins;
+  size_t blockSize;
+};
+
+// Everything the tests ask the cache, so that states can be compared the way a caller sees them
+struct CacheState {
+  uint32_t topBlockIndex;
+  Crypto::Hash topBlockHash;
+  size_t transactionCount;
+  uint64_t alreadyGeneratedCoins;
+  uint64_t cumulativeDifficulty;
+  std::vector<Crypto::Hash> blockHashes;
+  std::vector<size_t> keyOutputCounts;
+  std::vector<std::vector<Crypto::Hash>> paymentIdTransactions;
+  std::vector<Crypto::Hash> blockHashesByTimestamps;
+  std::vector<uint32_t> timestampLowerBounds;
+  std::vector<bool> spentKeyImages;
+};
+
+class DatabaseBlockchainCacheTest : public ::testing::Test {
+public:
+  DatabaseBlockchainCacheTest() :
+    currency(CurrencyBuilder(logger).currency()),
+    config(makeTestDataBaseConfig(directory.getPath())),
+    database(logger),
+    nextSeed(0) {
+    paymentIds = {makeValue<Crypto::Hash>(), makeValue<Crypto::Hash>()};
+  }
+
+protected:
+  virtual void SetUp() override {
+    open();
+  }
+
+  virtual void TearDown() override {
+    close();
+  }
+
+  void open() {
+    database.init(config);
+    mainChainStorage = createSwappedMainChainStorage(directory.getPath(), currency);
+    cacheFactory.reset(new DatabaseBlockchainCacheFactory(database, *mainChainStorage, "", logger));
+    cache = cacheFactory->createRootBlockchainCache(currency);
+    cache->load();
+  }
+
+  void close() {
+    cache->save();
+    cache.reset();
+    cacheFactory.reset();
+    mainChainStorage.reset();
+    database.shutdown();
+  }
+
+  std::map<std::string, std::string> reopenAndDump() {
+    close();
+    auto contents = dumpDataBase(config);
+    open();
+    return contents;
+  }
+
+  // distinct for every call, so keys, key images and payment IDs never collide by accident
+  template <class T>
+  T makeValue() {
+    static_assert(sizeof(T) == sizeof(Crypto::Hash), "Test values are made from hashes");
+
+    uint64_t seed = nextSeed++;
+    Crypto::Hash hash = Crypto::cn_fast_hash(&seed, sizeof(seed));
+    return reinterpret_cast<const T&>(hash);
+  }
+
+  TransactionOutput makeOutput(uint64_t amount) {
+    TransactionOutput output;
+    output.amount = amount;
+    output.target = KeyOutput{makeValue<Crypto::PublicKey>()};
+    return output;
+  }
+
+  // blocks on top of previousHash, the block at startIndex having the timestamp given
+  std::vector<TestBlock> makeChain(const Crypto::Hash& previousHash, uint32_t startIndex, uint64_t timestamp, uint32_t count) {
+    std::vector<TestBlock> chain;
+    Crypto::Hash previousBlockHash = previousHash;
+
+    for (uint32_t blockIndex = startIndex; blockIndex < startIndex + count; ++blockIndex) {
+      TestBlock testBlock;
+      BlockTemplate& block = testBlock.block;
+      block.majorVersion = BLOCK_MAJOR_VERSION_1;
+      block.minorVersion = BLOCK_MINOR_VERSION_0;
+      block.previousBlockHash = previousBlockHash;
+      block.nonce = 0;
+      // every fourth block shares the timestamp of the one before
+      block.timestamp = timestamp;
+      if (blockIndex % 4 != 2) {
+        timestamp += BLOCK_TIME_STEP;
+      }
+
+      block.baseTransaction.version = CURRENT_TRANSACTION_VERSION;
+      block.baseTransaction.unlockTime = blockIndex + currency.minedMoneyUnlockWindow();
+      block.baseTransaction.inputs.push_back(BaseInput{blockIndex});
+      block.baseTransaction.outputs.push_back(makeOutput(BASE_AMOUNTS[blockIndex % BASE_AMOUNTS.size()]));
+      block.baseTransaction.outputs.push_back(makeOutput(SPENT_AMOUNT));
+      addTransactionPublicKeyToExtra(block.baseTransaction.extra, makeValue<Crypto::PublicKey>());
+      testBlock.generatedCoins = BASE_AMOUNTS[blockIndex % BASE_AMOUNTS.size()] + SPENT_AMOUNT;
+
+      Transaction transaction;
+      transaction.version = CURRENT_TRANSACTION_VERSION;
+      transaction.unlockTime = 0;
+
+      KeyInput input;
+      input.amount = SPENT_AMOUNT;
+      input.outputIndexes = {0};
+      input.keyImage = makeValue<Crypto::KeyImage>();
+      transaction.inputs.push_back(input);
+      transaction.signatures.push_back(std::vector<Crypto::Signature>(1));
+      testBlock.validatorState.spentKeyImages.insert(input.keyImage);
+      keyImages.push_back(input.keyImage);
+
+      transaction.outputs.push_back(makeOutput(SPENT_AMOUNT));
+      // an amount of its own for every block, its output count appears and disappears with the block
+      transaction.outputs.push_back(makeOutput(blockIndex));
+      if (blockIndex % 3 != 0) {
+        BinaryArray extraNonce;
+        setPaymentIdToTransactionExtraNonce(extraNonce, paymentIds[blockIndex % paymentIds.size()]);
+        addExtraNonceToTransactionExtra(transaction.extra, extraNonce);
+      }
+
+      testBlock.transactions.emplace_back(std::move(transaction));
+      block.transactionHashes.push_back(testBlock.transactions.back().getTransactionHash());
+
+      testBlock.rawBlock.block = toBinaryArray(block);
+      testBlock.blockSize = testBlock.rawBlock.block.size();
+      for (const auto& cachedTransaction: testBlock.transactions) {
+        testBlock.rawBlock.transactions.push_back(cachedTransaction.getTransactionBinaryArray());
+        testBlock.blockSize += cachedTransaction.getTransactionBinaryArray().size();
+      }
+
+      previousBlockHash = CachedBlock(block).getBlockHash();
+      chain.push_back(std::move(testBlock));
+    }
+
+    return chain;
+  }
+
+  std::vector<TestBlock> makeChain(uint32_t count) {
+    uint32_t startIndex = cache->getTopBlockIndex() + 1;
+    return makeChain(cache->getTopBlockHash(), startIndex, FIRST_BLOCK_TIMESTAMP + startIndex * BLOCK_TIME_STEP, count);
+  }
+
+  // the way the core pushes main chain blocks: the raw block goes to the main chain storage first
+  void pushBlocks(const std::vector<TestBlock>& chain) {
+    for (const auto& testBlock: chain) {
+      mainChainStorage->pushBlock(testBlock.rawBlock);
+
+      RawBlock rawBlock = testBlock.rawBlock;
+      cache->pushBlock(CachedBlock(testBlock.block), testBlock.transactions, testBlock.validatorState, testBlock.blockSize,
+                       testBlock.generatedCoins, 1, std::move(rawBlock));
+    }
+  }
+
+  void pushBlocks(uint32_t count) {
+    pushBlocks(makeChain(count));
+  }
+
+  // pops the blocks from splitBlockIndex up, as the core does when switching to an alternative chain
+  void popBlocks(uint32_t splitBlockIndex) {
+    auto upperSegment = cache->split(splitBlockIndex);
+    ASSERT_EQ(splitBlockIndex, upperSegment->getStartBlockIndex());
+    cache->deleteChild(upperSegment.get());
+
+    while (mainChainStorage->getBlockCount() > splitBlockIndex) {
+      mainChainStorage->popBlock();
+    }
+  }
+
+  // makes the blocks look pushed before undo records were written, so that split has to delete them the slow way
+  void removeUndoRecords(uint32_t startIndex, uint32_t endIndex) {
+    BlockchainWriteBatch writeBatch;
+    for (uint32_t blockIndex = startIndex; blockIndex <= endIndex; ++blockIndex) {
+      writeBatch.removeBlockUndoInfo(blockIndex);
+    }
+
+    ASSERT_FALSE(database.write(writeBatch));
+  }
+
+  CacheState getState() const {
+    CacheState state;
+    state.topBlockIndex = cache->getTopBlockIndex();
+    state.topBlockHash = cache->getTopBlockHash();
+    state.transactionCount = cache->getTransactionCount();
+    state.alreadyGeneratedCoins = cache->getAlreadyGeneratedCoins();
+    state.cumulativeDifficulty = cache->getCurrentCumulativeDifficulty();
+    state.blockHashes = cache->getBlockHashes(0, state.topBlockIndex + 1);
+
+    // the per block amounts of popped blocks included, their counts must be back to zero
+    std::vector<uint64_t> amounts = BASE_AMOUNTS;
+    amounts.push_back(SPENT_AMOUNT);
+    for (uint32_t blockIndex = 0; blockIndex < 40; ++blockIndex) {
+      amounts.push_back(blockIndex);
+    }
+
+    for (auto amount: amounts) {
+      state.keyOutputCounts.push_back(cache->getKeyOutputsCountForAmount(amount, state.topBlockIndex + 1));
+    }
+
+    for (const auto& paymentId: paymentIds) {
+      state.paymentIdTransactions.push_back(cache->getTransactionHashesByPaymentId(paymentId));
+    }
+
+    // every block timestamp is one of these, a range over all of them would read the database second by second
+    for (uint32_t step = 0; step < 40; ++step) {
+      auto hashes = cache->getBlockHashesByTimestamps(FIRST_BLOCK_TIMESTAMP + step * BLOCK_TIME_STEP, 1);
+      state.blockHashesByTimestamps.insert(state.blockHashesByTimestamps.end(), hashes.begin(), hashes.end());
+    }
+
+    // not before the first block's day, the lookup would walk back day by day to the genesis timestamp
+    for (uint32_t blockIndex = 1; blockIndex <= state.topBlockIndex; ++blockIndex) {
+      state.timestampLowerBounds.push_back(cache->getTimestampLowerBoundBlockIndex(FIRST_BLOCK_TIMESTAMP + blockIndex * BLOCK_TIME_STEP));
+    }
+
+    for (const auto& keyImage: keyImages) {
+      state.spentKeyImages.push_back(cache->checkIfSpent(keyImage));
+    }
+
+    return state;
+  }
+
+  void expectSameState(const CacheState& expected, const CacheState& actual) const {
+    EXPECT_EQ(expected.topBlockIndex, actual.topBlockIndex);
+    EXPECT_EQ(expected.topBlockHash, actual.topBlockHash);
+    EXPECT_EQ(expected.transactionCount, actual.transactionCount);
+    EXPECT_EQ(expected.alreadyGeneratedCoins, actual.alreadyGeneratedCoins);
+    EXPECT_EQ(expected.cumulativeDifficulty, actual.cumulativeDifficulty);
+    EXPECT_EQ(expected.blockHashes, actual.blockHashes);
+    EXPECT_EQ(expected.keyOutputCounts, actual.keyOutputCounts);
+    EXPECT_EQ(expected.paymentIdTransactions, actual.paymentIdTransactions);
+    EXPECT_EQ(expected.blockHashesByTimestamps, actual.blockHashesByTimestamps);
+    EXPECT_EQ(expected.timestampLowerBounds, actual.timestampLowerBounds);
+
+    // key images of blocks made later are unknown to the expected state
+    std::vector<bool> spentKeyImages = actual.spentKeyImages;
+    spentKeyImages.resize(expected.spentKeyImages.size());
+    EXPECT_EQ(expected.spentKeyImages, spentKeyImages);
+    for (size_t i = expected.spentKeyImages.size(); i < actual.spentKeyImages.size(); ++i) {
+      EXPECT_FALSE(actual.spentKeyImages[i]);
+    }
+  }
+
+  // pushes the blocks above lowerCount blocks and pops them, the database and the cache must be as before
+  void testPopAcrossRoot(uint32_t lowerCount, uint32_t upperCount, uint32_t slowPathCount) {
+    pushBlocks(lowerCount);
+    auto expectedContents = reopenAndDump();
+    auto expectedState = getState();
+
+    uint32_t splitBlockIndex = cache->getTopBlockIndex() + 1;
+    pushBlocks(upperCount);
+    if (slowPathCount != 0) {
+      removeUndoRecords(splitBlockIndex, splitBlockIndex + slowPathCount - 1);
+    }
+
+    popBlocks(splitBlockIndex);
+    expectSameState(expectedState, getState());
+
+    expectSameContents(expectedContents, reopenAndDump());
+    expectSameState(expectedState, getState());
+  }
+
+  // one failure per key, the whole dump in a message says nothing
+  static void expectSameContents(const std::map<std::string, std::string>& expected, const std::map<std::string, std::string>& actual) {
+    for (const auto& entry: expected) {
+      auto it = actual.find(entry.first);
+      if (it == actual.end()) {
+        ADD_FAILURE() << "Key " << Common::toHex(entry.first.data(), entry.first.size()) << " is missing";
+      } else if (it->second != entry.second) {
+        ADD_FAILURE() << "Key " << Common::toHex(entry.first.data(), entry.first.size()) << " has value "
+                      << Common::toHex(it->second.data(), it->second.size()) << ", expected "
+                      << Common::toHex(entry.second.data(), entry.second.size());
+      }
+    }
+
+    for (const auto& entry: actual) {
+      if (expected.count(entry.first) == 0) {
+        ADD_FAILURE() << "Key " << Common::toHex(entry.first.data(), entry.first.size()) << " is left over";
+      }
+    }
+  }
+
+  Logging::LoggerGroup logger;
+  Currency currency;
+  TemporaryDirectory directory;
+  DataBaseConfig config;
+  RocksDBWrapper database;
+  std::unique_ptr<IMainChainStorage> mainChainStorage;
+  std::unique_ptr<IBlockchainCacheFactory> cacheFactory;
+  std::unique_ptr<IBlockchainCache> cache;
+
+  uint64_t nextSeed;
+  std::vector<Crypto::Hash> paymentIds;
+  std::vector<Crypto::KeyImage> keyImages;
+};
+
+TEST_F(DatabaseBlockchainCacheTest, reloadKeepsState) {
+  pushBlocks(12);
+  auto state = getState();
+
+  close();
+  open();
+  expectSameState(state, getState());
+}
+
+TEST_F(DatabaseBlockchainCacheTest, popRestoresDataBaseFromUndoRecords) {
+  testPopAcrossRoot(10, 7, 0);
+}
+
+TEST_F(DatabaseBlockchainCacheTest, popRestoresDataBaseWithoutUndoRecords) {
+  testPopAcrossRoot(10, 7, 7);
+}
+
+TEST_F(DatabaseBlockchainCacheTest, popRestoresDataBaseWithUndoRecordsAboveBlocksWithout) {
+  testPopAcrossRoot(10, 7, 3);
+}
+
+TEST_F(DatabaseBlockchainCacheTest, popRestoresDataBaseDownToGenesis) {
+  testPopAcrossRoot(0, 9, 0);
+}
+
+TEST_F(DatabaseBlockchainCacheTest, popsOneBlockAtATime) {
+  std::vector<std::map<std::string, std::string>> contents;
+  std::vector<CacheState> states;
+
+  contents.push_back(reopenAndDump());
+  states.push_back(getState());
+  for (uint32_t i = 0; i < 9; ++i) {
+    pushBlocks(1);
+    contents.push_back(reopenAndDump());
+    states.push_back(getState());
+  }
+
+  for (uint32_t blockIndex = cache->getTopBlockIndex(); blockIndex > 0; --blockIndex) {
+    popBlocks(blockIndex);
+    expectSameState(states[blockIndex - 1], getState());
+    expectSameContents(contents[blockIndex - 1], reopenAndDump());
+    ASSERT_FALSE(HasFailure()) << "Popping block " << blockIndex;
+  }
+}
+
+TEST_F(DatabaseBlockchainCacheTest, pushAfterPopEqualsPushOnly) {
+  pushBlocks(8);
+  auto forkHash = cache->getTopBlockHash();
+  uint32_t splitBlockIndex = cache->getTopBlockIndex() + 1;
+  uint64_t forkTimestamp = FIRST_BLOCK_TIMESTAMP + splitBlockIndex * BLOCK_TIME_STEP;
+
+  auto mainChain = makeChain(forkHash, splitBlockIndex, forkTimestamp, 6);
+  // the alternative chain spends other key images at the same timestamps as the main chain
+  auto alternativeChain = makeChain(forkHash, splitBlockIndex, forkTimestamp, 4);
+
+  pushBlocks(mainChain);
+  auto expectedContents = reopenAndDump();
+  auto expectedState = getState();
+
+  // no reload between the pops and the pushes, the counters the cache keeps in memory have to follow
+  popBlocks(splitBlockIndex);
+  pushBlocks(alternativeChain);
+  popBlocks(splitBlockIndex);
+  pushBlocks(mainChain);
+
+  expectSameState(expectedState, getState());
+  expectSameContents(expectedContents, reopenAndDump());
+}
+
+}
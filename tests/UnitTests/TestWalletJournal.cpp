@@ -0,0 +1,130 @@
+// Copyright (c) 2018, The TurtleCoin Developers
+//
+// Please see the included LICENSE file for more information.
+
+#include "gtest/gtest.h"
+
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "crypto/crypto.h"
+#include "Wallet/WalletJournal.h"
+
+#include "TestBlockchainHelpers.h"
+
+using namespace CryptoNote;
+
+namespace {
+
+class WalletJournalTest : public ::testing::Test {
+public:
+  WalletJournalTest() :
+    path(directory.getPath() + "/wallet.journal"),
+    key(Crypto::rand<Crypto::chacha8_key>()),
+    snapshotIv(Crypto::rand<Crypto::chacha8_iv>()) {
+  }
+
+protected:
+  std::vector<BinaryArray> reopen(const Crypto::chacha8_key& openKey, const Crypto::chacha8_iv& openSnapshotIv) {
+    std::vector<BinaryArray> records;
+    journal.close();
+    journal.open(path, openKey, openSnapshotIv, records);
+    return records;
+  }
+
+  std::vector<BinaryArray> reopen() {
+    return reopen(key, snapshotIv);
+  }
+
+  static BinaryArray makeRecord(uint8_t value, size_t size) {
+    return BinaryArray(size, value);
+  }
+
+  TemporaryDirectory directory;
+  std::string path;
+  Crypto::chacha8_key key;
+  Crypto::chacha8_iv snapshotIv;
+  WalletJournal journal;
+};
+
+TEST_F(WalletJournalTest, replaysCommittedRecords) {
+  std::vector<BinaryArray> records = {makeRecord(1, 10), makeRecord(2, 1000), makeRecord(3, 1)};
+
+  journal.create(path, key, snapshotIv);
+  for (const auto& record : records) {
+    journal.append(record);
+  }
+
+  journal.commit();
+  ASSERT_EQ(records.size(), journal.recordCount());
+
+  ASSERT_EQ(records, reopen());
+  ASSERT_EQ(records.size(), journal.recordCount());
+
+  // appended after the replay, behind the records already there
+  journal.append(makeRecord(4, 20));
+  journal.commit();
+  records.push_back(makeRecord(4, 20));
+  ASSERT_EQ(records, reopen());
+}
+
+TEST_F(WalletJournalTest, cutsTornRecord) {
+  journal.create(path, key, snapshotIv);
+  journal.append(makeRecord(1, 100));
+  journal.append(makeRecord(2, 100));
+  journal.commit();
+  journal.close();
+
+  uint64_t size = boost::filesystem::file_size(path);
+  boost::filesystem::resize_file(path, size - 1);
+
+  ASSERT_EQ(std::vector<BinaryArray>{makeRecord(1, 100)}, reopen());
+  ASSERT_EQ(1, journal.recordCount());
+
+  journal.append(makeRecord(3, 5));
+  journal.commit();
+  ASSERT_EQ(std::vector<BinaryArray>({makeRecord(1, 100), makeRecord(3, 5)}), reopen());
+}
+
+TEST_F(WalletJournalTest, dropsJournalOfAnotherSave) {
+  journal.create(path, key, snapshotIv);
+  journal.append(makeRecord(1, 10));
+  journal.commit();
+
+  ASSERT_TRUE(reopen(key, Crypto::rand<Crypto::chacha8_iv>()).empty());
+  ASSERT_EQ(0, journal.recordCount());
+}
+
+TEST_F(WalletJournalTest, restartDropsRecords) {
+  journal.create(path, key, snapshotIv);
+  journal.append(makeRecord(1, 10));
+  journal.commit();
+
+  snapshotIv = Crypto::rand<Crypto::chacha8_iv>();
+  journal.restart(key, snapshotIv);
+  journal.append(makeRecord(2, 10));
+  journal.commit();
+
+  ASSERT_EQ(std::vector<BinaryArray>{makeRecord(2, 10)}, reopen());
+}
+
+TEST_F(WalletJournalTest, rekeyKeepsRecords) {
+  std::vector<BinaryArray> records = {makeRecord(1, 10), makeRecord(2, 30)};
+
+  journal.create(path, key, snapshotIv);
+  for (const auto& record : records) {
+    journal.append(record);
+  }
+
+  journal.commit();
+
+  key = Crypto::rand<Crypto::chacha8_key>();
+  snapshotIv = Crypto::rand<Crypto::chacha8_iv>();
+  journal.rekey(key, snapshotIv);
+
+  ASSERT_EQ(records, reopen());
+}
+
+}